@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "common/Types.hpp"
+
+using namespace std;
+
+// OS activity seen by the calling thread, plus the machine-wide interrupt
+// count (interrupts are not accounted per thread). All zero off Linux.
+struct OsCounters {
+    long voluntary_switches = 0;
+    long involuntary_switches = 0;
+    long minor_faults = 0;
+    long major_faults = 0;
+    uint64_t interrupts = 0;  // all CPUs, from /proc/stat: not this thread's
+
+    OsCounters Since(const OsCounters& earlier) const {
+        return OsCounters{
+            .voluntary_switches =
+                voluntary_switches - earlier.voluntary_switches,
+            .involuntary_switches =
+                involuntary_switches - earlier.involuntary_switches,
+            .minor_faults = minor_faults - earlier.minor_faults,
+            .major_faults = major_faults - earlier.major_faults,
+            .interrupts = interrupts - earlier.interrupts};
+    }
+
+    bool HasContextSwitch() const {
+        return voluntary_switches + involuntary_switches > 0;
+    }
+    bool HasPageFault() const { return minor_faults + major_faults > 0; }
+};
+
+// Reads OsCounters with one getrusage call and one small /proc/stat read, so
+// it is cheap enough to call between operations. Only a window around the
+// "intr" line is read: its offset is found once and followed as the lines
+// before it grow, so a read touches a few hundred bytes, not the whole file.
+class OsCounterReader {
+   private:
+    static constexpr size_t kWindowBytes = 256;
+    static constexpr size_t kWindowLead = 64;  // read from before the line
+
+    int stat_fd_ = -1;
+    size_t intr_offset_ = 0;  // of the newline before "intr "
+    char window_[kWindowBytes + 1] = {};
+
+#ifdef __linux__
+    // Scans the whole file for the line (at start-up, or if it moved far)
+    bool locateInterrupts() {
+        vector<char> buffer(1 << 16);
+        ssize_t size = pread(stat_fd_, buffer.data(), buffer.size() - 1, 0);
+        if (size <= 0) {
+            return false;
+        }
+        buffer[size] = '\0';
+        const char* line = strstr(buffer.data(), "\nintr ");
+        if (line == nullptr) {
+            return false;
+        }
+        intr_offset_ = static_cast<size_t>(line - buffer.data());
+        return true;
+    }
+
+    bool readInterrupts(uint64_t& interrupts) {
+        size_t start = intr_offset_ > kWindowLead ? intr_offset_ - kWindowLead
+                                                  : 0;
+        ssize_t size = pread(stat_fd_, window_, kWindowBytes,
+                             static_cast<off_t>(start));
+        if (size <= 0) {
+            return false;
+        }
+        window_[size] = '\0';
+        const char* line = strstr(window_, "\nintr ");
+        if (line == nullptr) {
+            return false;
+        }
+        intr_offset_ = start + static_cast<size_t>(line - window_);
+        interrupts = strtoull(line + 6, nullptr, 10);
+        return true;
+    }
+#endif
+
+   public:
+    OsCounterReader() {
+#ifdef __linux__
+        stat_fd_ = open("/proc/stat", O_RDONLY);
+        if (stat_fd_ >= 0 && !locateInterrupts()) {
+            close(stat_fd_);
+            stat_fd_ = -1;
+        }
+#endif
+    }
+    ~OsCounterReader() {
+#ifdef __linux__
+        if (stat_fd_ >= 0) {
+            close(stat_fd_);
+        }
+#endif
+    }
+    OsCounterReader(const OsCounterReader&) = delete;
+    OsCounterReader& operator=(const OsCounterReader&) = delete;
+
+    OsCounters Read() {
+        OsCounters counters;
+#ifdef __linux__
+        rusage usage{};
+        getrusage(RUSAGE_THREAD, &usage);
+        counters.voluntary_switches = usage.ru_nvcsw;
+        counters.involuntary_switches = usage.ru_nivcsw;
+        counters.minor_faults = usage.ru_minflt;
+        counters.major_faults = usage.ru_majflt;
+
+        // The window can miss the line if the lines before it grew past the
+        // lead; then it is located again
+        if (stat_fd_ >= 0 &&
+            !readInterrupts(counters.interrupts) && locateInterrupts()) {
+            readInterrupts(counters.interrupts);
+        }
+#endif
+        return counters;
+    }
+};
+
+// One operation that took longer than the outlier threshold
+struct OutlierRecord {
+    size_t sequence;  // position in the measured run
+    long long latency_ns;
+    OrderType type;
+    size_t orders_swept;       // resting orders filled
+    size_t levels_touched;     // distinct trade prices
+    double index_load_factor;  // ID index, after the operation
+    bool index_rehashed;       // the ID index grew its bucket array
+    OsCounters os;             // OS activity during the operation
+};
+
+// Resting orders filled and distinct prices of one operation's trades
+inline pair<size_t, size_t> SweepShape(const vector<Trade>& trades) {
+    size_t levels = 0;
+    for (size_t i = 0; i < trades.size(); i++) {
+        if (i == 0 || trades[i].price != trades[i - 1].price) {
+            levels++;
+        }
+    }
+    return {trades.size(), levels};
+}
+
+inline const char* OrderTypeName(OrderType type) {
+    switch (type) {
+        case MARKET:
+            return "MARKET";
+        case LIMIT:
+            return "LIMIT";
+        case CANCEL:
+            return "CANCEL";
+        case STOP:
+            return "STOP";
+        case STOP_LIMIT:
+            return "STOP_LIMIT";
+    }
+    return "?";
+}
+
+inline void WriteOutliers(const vector<OutlierRecord>& outliers,
+                          const string& path) {
+    ofstream file(path);
+    file << "sequence,latency_ns,type,orders_swept,levels_touched,"
+            "index_load_factor,index_rehashed,voluntary_switches,"
+            "involuntary_switches,minor_faults,major_faults,interrupts\n";
+    for (const OutlierRecord& outlier : outliers) {
+        file << outlier.sequence << "," << outlier.latency_ns << ","
+             << OrderTypeName(outlier.type) << "," << outlier.orders_swept
+             << "," << outlier.levels_touched << ","
+             << outlier.index_load_factor << ","
+             << (outlier.index_rehashed ? 1 : 0) << ","
+             << outlier.os.voluntary_switches << ","
+             << outlier.os.involuntary_switches << ","
+             << outlier.os.minor_faults << "," << outlier.os.major_faults
+             << "," << outlier.os.interrupts << "\n";
+    }
+}
+
+// Splits the outliers into those with a visible OS cause and the rest, which
+// point at the engine (or at something the counters cannot see, such as
+// cache or TLB misses and SMIs)
+inline void PrintOutlierSummary(const vector<OutlierRecord>& outliers,
+                                long long threshold_ns, size_t operations,
+                                double interrupts_per_operation) {
+    size_t switched = 0;
+    size_t faulted = 0;
+    size_t rehashed = 0;
+    size_t unexplained = 0;
+    uint64_t outlier_interrupts = 0;
+    size_t by_type[STOP_LIMIT + 1] = {};
+    size_t swept_by_type[STOP_LIMIT + 1] = {};
+    for (const OutlierRecord& outlier : outliers) {
+        switched += outlier.os.HasContextSwitch() ? 1 : 0;
+        faulted += outlier.os.HasPageFault() ? 1 : 0;
+        rehashed += outlier.index_rehashed ? 1 : 0;
+        if (!outlier.os.HasContextSwitch() && !outlier.os.HasPageFault() &&
+            !outlier.index_rehashed) {
+            unexplained++;
+        }
+        outlier_interrupts += outlier.os.interrupts;
+        by_type[outlier.type]++;
+        swept_by_type[outlier.type] += outlier.orders_swept;
+    }
+
+    cout << "Outliers above " << threshold_ns << " ns: " << outliers.size()
+         << " of " << operations << " operations\n";
+    if (outliers.empty()) {
+        return;
+    }
+    cout << "- With a context switch: " << switched << "\n";
+    cout << "- With a page fault: " << faulted << "\n";
+    cout << "- With an ID index rehash: " << rehashed << "\n";
+    cout << "- None of the above (engine or unseen platform cause): "
+         << unexplained << "\n";
+    cout << "- Interrupts (all CPUs) per operation: "
+         << static_cast<double>(outlier_interrupts) / outliers.size()
+         << " in outliers vs " << interrupts_per_operation << " overall\n";
+    for (int type = MARKET; type <= STOP_LIMIT; type++) {
+        if (by_type[type] != 0) {
+            cout << "- " << OrderTypeName(static_cast<OrderType>(type))
+                 << ": " << by_type[type] << " outliers, "
+                 << static_cast<double>(swept_by_type[type]) / by_type[type]
+                 << " orders swept on average\n";
+        }
+    }
+
+    // The worst few, for a first look without opening the CSV
+    vector<OutlierRecord> worst = outliers;
+    size_t shown = min<size_t>(worst.size(), 10);
+    partial_sort(worst.begin(), worst.begin() + shown, worst.end(),
+                 [](const OutlierRecord& a, const OutlierRecord& b) {
+                     return a.latency_ns > b.latency_ns;
+                 });
+    cout << "Worst outliers:\n";
+    for (size_t i = 0; i < shown; i++) {
+        const OutlierRecord& outlier = worst[i];
+        cout << "  #" << outlier.sequence << " " << outlier.latency_ns
+             << " ns " << OrderTypeName(outlier.type) << ", "
+             << outlier.orders_swept << " orders / "
+             << outlier.levels_touched << " levels, load factor "
+             << outlier.index_load_factor
+             << (outlier.index_rehashed ? " (rehash)" : "") << ", cs "
+             << outlier.os.voluntary_switches +
+                    outlier.os.involuntary_switches
+             << ", faults "
+             << outlier.os.minor_faults + outlier.os.major_faults
+             << ", irqs " << outlier.os.interrupts << "\n";
+    }
+}
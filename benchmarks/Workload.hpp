@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/Types.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+using namespace std;
+
+const int kMinPrice = 800'00;     // Min price in cents
+const int kMaxPrice = 1200'00;    // Max price in cents
+const int kStartPrice = 1000'00;  // Starting mid price in cents
+
+const int kMaxCancelAttempts =
+    20;  // Max attempts to find a valid target for CANCEL orders
+
+const Volume kMaxOrderVolume = 1'000'000;  // Cap for heavy-tailed sizes
+
+// Parameters of one synthetic order flow regime. All fields are numbers so
+// any of them can be overridden from the command line (name=value).
+struct WorkloadProfile {
+    string name;
+    string description;
+
+    // Order type mix (relative weights). A requote cancels a resting order
+    // and quotes the same side again near the touch, two messages in one.
+    double market_weight;
+    double limit_weight;
+    double cancel_weight;
+    double requote_weight;
+
+    // Limit prices: mid +/- (min_offset + geometric(offset_p)) ticks
+    double min_offset;
+    double offset_p;
+
+    // Mid price random walk: normal step per order
+    double mid_step;
+
+    // Order sizes: geometric(volume_p), or Pareto with this tail index when
+    // volume_tail_alpha > 0 (smaller alpha = heavier tail)
+    double volume_p;
+    double volume_tail_alpha;
+
+    // One-sided sweeps: with this probability per order a run of
+    // sweep_length market orders hits one side, dragging the mid along
+    double sweep_probability;
+    double sweep_length;
+
+    // Bursty arrivals: orders come in bursts of geometric mean length
+    // mean_burst_length, separated by idle gaps (0 = continuous flow)
+    double mean_burst_length;
+    double idle_gap_ns;
+};
+
+const vector<WorkloadProfile> kWorkloadProfiles = {
+    {.name = "default",
+     .description = "balanced flow (10/70/20 market/limit/cancel)",
+     .market_weight = 10,
+     .limit_weight = 70,
+     .cancel_weight = 20,
+     .requote_weight = 0,
+     .min_offset = 0,
+     .offset_p = 0.3,
+     .mid_step = 0.5,
+     .volume_p = 0.1,
+     .volume_tail_alpha = 0,
+     .sweep_probability = 0,
+     .sweep_length = 0,
+     .mean_burst_length = 0,
+     .idle_gap_ns = 0},
+    {.name = "cancel-heavy",
+     .description = "HFT quoting: cancel/requote pairs at the touch, "
+                    "~45% of messages cancels, ~88% of quotes cancelled",
+     .market_weight = 2,
+     .limit_weight = 5,
+     .cancel_weight = 0,
+     .requote_weight = 93,
+     .min_offset = 0,
+     .offset_p = 0.5,
+     .mid_step = 0.3,
+     .volume_p = 0.1,
+     .volume_tail_alpha = 0,
+     .sweep_probability = 0,
+     .sweep_length = 0,
+     .mean_burst_length = 0,
+     .idle_gap_ns = 0},
+    {.name = "deep-book",
+     .description = "resting liquidity spread over thousands of levels",
+     .market_weight = 5,
+     .limit_weight = 85,
+     .cancel_weight = 10,
+     .requote_weight = 0,
+     .min_offset = 0,
+     .offset_p = 0.002,
+     .mid_step = 0.5,
+     .volume_p = 0.1,
+     .volume_tail_alpha = 0,
+     .sweep_probability = 0,
+     .sweep_length = 0,
+     .mean_burst_length = 0,
+     .idle_gap_ns = 0},
+    {.name = "illiquid",
+     .description = "wide spread, sparse levels, jumpy mid",
+     .market_weight = 10,
+     .limit_weight = 60,
+     .cancel_weight = 30,
+     .requote_weight = 0,
+     .min_offset = 50,
+     .offset_p = 0.05,
+     .mid_step = 3.0,
+     .volume_p = 0.1,
+     .volume_tail_alpha = 0,
+     .sweep_probability = 0,
+     .sweep_length = 0,
+     .mean_burst_length = 0,
+     .idle_gap_ns = 0},
+    {.name = "sweep",
+     .description = "default flow with sudden one-sided sweeps, "
+                    "heavy-tailed sizes",
+     .market_weight = 10,
+     .limit_weight = 70,
+     .cancel_weight = 20,
+     .requote_weight = 0,
+     .min_offset = 0,
+     .offset_p = 0.3,
+     .mid_step = 0.5,
+     .volume_p = 0.1,
+     .volume_tail_alpha = 1.5,
+     .sweep_probability = 0.0005,
+     .sweep_length = 50,
+     .mean_burst_length = 0,
+     .idle_gap_ns = 0},
+    {.name = "bursty",
+     .description = "default flow arriving in bursts with idle gaps",
+     .market_weight = 10,
+     .limit_weight = 70,
+     .cancel_weight = 20,
+     .requote_weight = 0,
+     .min_offset = 0,
+     .offset_p = 0.3,
+     .mid_step = 0.5,
+     .volume_p = 0.1,
+     .volume_tail_alpha = 0,
+     .sweep_probability = 0,
+     .sweep_length = 0,
+     .mean_burst_length = 200,
+     .idle_gap_ns = 50'000},
+};
+
+// Generated orders plus the idle time to leave after each of them
+struct Workload {
+    vector<Order> orders;
+    vector<uint32_t> idle_gaps_ns;
+};
+
+inline const WorkloadProfile* FindWorkloadProfile(const string& name) {
+    for (const WorkloadProfile& profile : kWorkloadProfiles) {
+        if (profile.name == name) {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+inline void PrintWorkloadProfiles() {
+    cout << "Workload profiles:\n";
+    for (const WorkloadProfile& profile : kWorkloadProfiles) {
+        cout << "  " << profile.name << ": " << profile.description << "\n";
+    }
+}
+
+// Applies one "name=value" override; returns false if it is not one
+inline bool SetWorkloadParameter(WorkloadProfile& profile,
+                                 const string& assignment) {
+    size_t equals = assignment.find('=');
+    if (equals == string::npos) {
+        return false;
+    }
+    string key = assignment.substr(0, equals);
+    double value = stod(assignment.substr(equals + 1));
+
+    const pair<const char*, double*> fields[] = {
+        {"market_weight", &profile.market_weight},
+        {"limit_weight", &profile.limit_weight},
+        {"cancel_weight", &profile.cancel_weight},
+        {"requote_weight", &profile.requote_weight},
+        {"min_offset", &profile.min_offset},
+        {"offset_p", &profile.offset_p},
+        {"mid_step", &profile.mid_step},
+        {"volume_p", &profile.volume_p},
+        {"volume_tail_alpha", &profile.volume_tail_alpha},
+        {"sweep_probability", &profile.sweep_probability},
+        {"sweep_length", &profile.sweep_length},
+        {"mean_burst_length", &profile.mean_burst_length},
+        {"idle_gap_ns", &profile.idle_gap_ns}};
+    for (const auto& [field, target] : fields) {
+        if (key == field) {
+            *target = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Prints the generated message mix, which can differ from the profile's
+// weights: a cancel needs a resting order to target
+inline void PrintWorkloadMix(const Workload& workload) {
+    size_t counts[3] = {0, 0, 0};  // MARKET, LIMIT, CANCEL
+    for (const Order& order : workload.orders) {
+        counts[order.getOrderType()]++;
+    }
+    double total = static_cast<double>(max<size_t>(1, workload.orders.size()));
+    cout << "- Mix: " << 100.0 * counts[MARKET] / total << "% market, "
+         << 100.0 * counts[LIMIT] / total << "% limit, "
+         << 100.0 * counts[CANCEL] / total << "% cancel ("
+         << 100.0 * counts[CANCEL] /
+                static_cast<double>(max<size_t>(1, counts[LIMIT]))
+         << "% of limit orders cancelled)\n";
+}
+
+inline Workload GenerateWorkload(const WorkloadProfile& profile,
+                                 size_t num_orders) {
+    random_device rd;
+    default_random_engine generator(rd());
+
+    // Price movement distribution
+    normal_distribution<double> price_difference(0.0, profile.mid_step);
+    double current_mid_price = kStartPrice;
+
+    // Type distribution: 0 for MARKET, 1 for LIMIT, 2 for CANCEL, 3 for a
+    // requote
+    discrete_distribution<int> type_distribution(
+        {profile.market_weight, profile.limit_weight, profile.cancel_weight,
+         profile.requote_weight});
+    const int kRequote = 3;
+
+    // Side distribution: 0 for BUY, 1 for SELL
+    uniform_int_distribution<int> side_distribution(0, 1);
+
+    // Price distribution for limit orders
+    geometric_distribution<int> price_offset_distribution(profile.offset_p);
+
+    // Volume distributions
+    geometric_distribution<int> volume_distribution(profile.volume_p);
+    uniform_real_distribution<double> unit_distribution(0.0, 1.0);
+    auto draw_volume = [&]() -> Volume {
+        if (profile.volume_tail_alpha <= 0) {
+            return volume_distribution(generator);
+        }
+        // Pareto with minimum 1 by inverse transform
+        double u = 1.0 - unit_distribution(generator);  // (0, 1]
+        double size = ceil(pow(u, -1.0 / profile.volume_tail_alpha));
+        return static_cast<Volume>(
+            min(size, static_cast<double>(kMaxOrderVolume)));
+    };
+
+    // Burst lengths (a burst ends after each order with probability 1/mean)
+    bernoulli_distribution burst_end(
+        profile.mean_burst_length > 0 ? 1.0 / profile.mean_burst_length : 0);
+    bernoulli_distribution sweep_start(profile.sweep_probability);
+
+    Workload workload;
+    workload.orders.reserve(num_orders);
+    workload.idle_gaps_ns.reserve(num_orders);
+    vector<Order>& orders = workload.orders;
+
+    // Shadow book to track active orders for generating valid CANCEL orders
+    OrderBook shadow_book;
+    vector<OrderID> active_limit_ids;
+    active_limit_ids.reserve(num_orders);
+
+    auto next_gap = [&]() -> uint32_t {
+        return burst_end(generator) ? static_cast<uint32_t>(profile.idle_gap_ns)
+                                    : 0;
+    };
+    auto place = [&](Side side, OrderType type, Price price, Volume volume) {
+        orders.emplace_back(orders.size(), side, type, price, volume);
+        workload.idle_gaps_ns.push_back(next_gap());
+        shadow_book.PlaceOrder(orders.back());
+        if (type == LIMIT) {
+            active_limit_ids.push_back(orders.back().getOrderId());
+        }
+    };
+
+    // Limit prices: mid +/- offset, inside the price range
+    auto limit_price = [&](Side side) -> Price {
+        int price_offset = static_cast<int>(profile.min_offset) +
+                           price_offset_distribution(generator);
+        auto mid = static_cast<Price>(current_mid_price);
+        Price price = side == BUY ? mid - price_offset : mid + price_offset;
+        price = max<Price>(price, kMinPrice);
+        return min<Price>(price, kMaxPrice);
+    };
+
+    // Cancels a random resting limit order; returns false if none was found
+    auto cancel_resting = [&](Side& side) -> bool {
+        // Attempt to find a valid target
+        size_t attempts = 0;
+
+        while (attempts < kMaxCancelAttempts && !active_limit_ids.empty()) {
+            // Pick random index
+            uniform_int_distribution<size_t> dist(0,
+                                                  active_limit_ids.size() - 1);
+            size_t idx = dist(generator);
+            OrderID target_id = active_limit_ids[idx];
+
+            // Remove from active list, whether it rests or already filled
+            active_limit_ids[idx] = active_limit_ids.back();
+            active_limit_ids.pop_back();
+
+            // Check if it really exists in the book (not filled)
+            if (shadow_book.ContainsOrder(target_id)) {
+                // Order IDs are indices into the generated orders
+                side = orders[target_id].getSide();
+                orders.emplace_back(orders.size(), BUY, CANCEL, 0, 0,
+                                    target_id);
+                workload.idle_gaps_ns.push_back(next_gap());
+                shadow_book.CancelOrder(target_id);
+                return true;
+            }
+            attempts++;
+        }
+        return false;
+    };
+
+    // Generate Orders
+    while (orders.size() < num_orders) {
+        // Simulate mid-price movement
+        current_mid_price += price_difference(generator);
+        current_mid_price = max<double>(current_mid_price, kMinPrice);
+        current_mid_price = min<double>(current_mid_price, kMaxPrice);
+
+        // One-sided sweep: a run of market orders, the mid following it
+        if (sweep_start(generator)) {
+            Side side = side_distribution(generator) == 0 ? BUY : SELL;
+            for (int i = 0; i < static_cast<int>(profile.sweep_length) &&
+                            orders.size() < num_orders;
+                 i++) {
+                place(side, MARKET, 0, draw_volume());
+                current_mid_price += side == BUY ? 1.0 : -1.0;
+            }
+            continue;
+        }
+
+        // Order type
+        int action = type_distribution(generator);
+
+        // CANCEL order, or a requote: cancel, then quote the same side
+        if (action == CANCEL || action == kRequote) {
+            Side side;
+            if (cancel_resting(side) && action == kRequote &&
+                orders.size() < num_orders) {
+                place(side, LIMIT, limit_price(side), draw_volume());
+            }
+            continue;
+        }
+
+        // MARKET or LIMIT order
+        auto type = static_cast<OrderType>(action);
+        Side side = side_distribution(generator) == 0 ? BUY : SELL;
+        Price price = type == LIMIT ? limit_price(side) : 0;
+        place(side, type, price, draw_volume());
+    }
+
+    return workload;
+}
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+#include "common/Types.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+const int kOrdersPerLevel = 4;  // Orders resting at every price level
+const int kRepetitions = 5;     // Uncross runs per book size (best is kept)
+
+const int kStartPrice = 1000'00;  // Auction reference price in cents
+
+// Number of price levels per side of the opening book
+const vector<int> kLevelsPerSide = {1'000, 10'000, 50'000, 100'000};
+
+// Fills a book in auction mode with overlapping buy and sell interest: both
+// sides spread over the same band around the start price, so roughly half of
+// every side is crossed at the open
+OrderBook BuildOpeningBook(int levels_per_side, default_random_engine& gen) {
+    geometric_distribution<int> volume_distribution(0.1);
+
+    OrderBook book;
+    book.StartAuction();
+
+    OrderID next_id = 0;
+    Price low = kStartPrice - levels_per_side / 2;
+    for (int level = 0; level < levels_per_side; level++) {
+        for (int i = 0; i < kOrdersPerLevel; i++) {
+            book.PlaceOrder(Order(next_id++, BUY, LIMIT, low + level,
+                                  volume_distribution(gen) + 1));
+            book.PlaceOrder(Order(next_id++, SELL, LIMIT, low + level,
+                                  volume_distribution(gen) + 1));
+        }
+    }
+    return book;
+}
+
+int main() {
+    random_device rd;
+    default_random_engine generator(rd());
+
+    cout << "Call auction uncross benchmark (" << kOrdersPerLevel
+         << " orders per level, best of " << kRepetitions << " runs)\n";
+
+    for (int levels : kLevelsPerSide) {
+        long long best_indicative = LLONG_MAX;
+        long long best_uncross = LLONG_MAX;
+        size_t trade_count = 0;
+
+        for (int run = 0; run < kRepetitions; run++) {
+            OrderBook book = BuildOpeningBook(levels, generator);
+
+            // Equilibrium price search only
+            auto start = chrono::high_resolution_clock::now();
+            AuctionResult result = book.GetIndicativeUncross();
+            auto end = chrono::high_resolution_clock::now();
+            best_indicative = min<long long>(
+                best_indicative,
+                chrono::duration_cast<chrono::microseconds>(end - start)
+                    .count());
+
+            // Full uncross (price search + executions)
+            start = chrono::high_resolution_clock::now();
+            vector<Trade> trades = book.Uncross();
+            end = chrono::high_resolution_clock::now();
+            best_uncross = min<long long>(
+                best_uncross,
+                chrono::duration_cast<chrono::microseconds>(end - start)
+                    .count());
+
+            trade_count = trades.size();
+            if (result.matched_volume == 0) {
+                cout << "Warning: generated book did not cross\n";
+            }
+        }
+
+        cout << "- " << levels << " levels per side: indicative "
+             << best_indicative << " us, uncross " << best_uncross << " us ("
+             << trade_count << " trades)\n";
+    }
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#include "common/Types.hpp"
+#include "matching_engine/ConsolidatedBbo.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+#include "Workload.hpp"
+
+const size_t kDefaultOrders = 2'000'000;
+const size_t kDefaultBooks = 4;
+const size_t kQueryBatches = 200'000;
+const size_t kQueryBatch = 16;  // queries per timing, amortizing the clock
+
+// Runs the flow once; returns the average ns per operation
+double RunFlow(OrderBook& book, const vector<Order>& orders) {
+    size_t checksum = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (const Order& order : orders) {
+        if (order.getOrderType() != CANCEL) {
+            checksum += book.PlaceOrder(order).size();
+        } else {
+            book.CancelOrder(order.getCancelOrderId());
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    cout << "  (checksum " << checksum << ")\n";
+    return static_cast<double>(
+               chrono::duration_cast<chrono::nanoseconds>(end - start)
+                   .count()) /
+           static_cast<double>(orders.size());
+}
+
+// Usage: benchmark_bbo [--orders N] [--books N]
+int main(int argc, char* argv[]) {
+    size_t num_orders = kDefaultOrders;
+    size_t num_books = kDefaultBooks;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--orders") {
+            num_orders = stoull(argv[i + 1]);
+        } else if (arg == "--books") {
+            num_books = max<size_t>(1, stoull(argv[i + 1]));
+        }
+    }
+
+    cout << "Generating " << num_orders << " orders...\n";
+    Workload workload =
+        GenerateWorkload(*FindWorkloadProfile("default"), num_orders);
+    const vector<Order>& orders = workload.orders;
+
+    // Writer side: what publishing costs the matching thread
+    cout << "Running the flow without a top-of-book slot...\n";
+    OrderBook bare_book;
+    double bare_ns = RunFlow(bare_book, orders);
+    cout << "Running the flow publishing into a slot...\n";
+    ConsolidatedBbo single(1);
+    OrderBook publishing_book;
+    publishing_book.SetTopOfBookSlot(&single.GetSlot(0));
+    double publishing_ns = RunFlow(publishing_book, orders);
+    cout << "- Per operation: " << bare_ns << " ns without, "
+         << publishing_ns << " ns with publishing\n";
+
+    // Reader side: consolidated queries while every book keeps trading on
+    // its own thread
+    cout << "Querying the consolidated BBO of " << num_books
+         << " books while they trade...\n";
+    ConsolidatedBbo bbo(num_books);
+    atomic<bool> done{false};
+    vector<thread> writers;
+    for (size_t book = 0; book < num_books; book++) {
+        writers.emplace_back([&, book]() {
+            while (!done.load(memory_order_relaxed)) {
+                OrderBook ob;
+                ob.SetTopOfBookSlot(&bbo.GetSlot(book));
+                for (size_t i = 0; i < orders.size() &&
+                                   !done.load(memory_order_relaxed);
+                     i++) {
+                    if (orders[i].getOrderType() != CANCEL) {
+                        ob.PlaceOrder(orders[i]);
+                    } else {
+                        ob.CancelOrder(orders[i].getCancelOrderId());
+                    }
+                }
+                ob.SetTopOfBookSlot(nullptr);
+            }
+        });
+    }
+
+    vector<double> latencies;  // per query, averaged over a batch
+    latencies.reserve(kQueryBatches);
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < kQueryBatches; i++) {
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t j = 0; j < kQueryBatch; j++) {
+            ConsolidatedQuote quote = bbo.GetBbo();
+            checksum += quote.bid_price + quote.ask_volume;
+        }
+        auto end = chrono::high_resolution_clock::now();
+        latencies.push_back(
+            static_cast<double>(
+                chrono::duration_cast<chrono::nanoseconds>(end - start)
+                    .count()) /
+            kQueryBatch);
+    }
+    done.store(true, memory_order_relaxed);
+    for (thread& writer : writers) {
+        writer.join();
+    }
+
+    double average = accumulate(latencies.begin(), latencies.end(), 0.0) /
+                     static_cast<double>(latencies.size());
+    ranges::sort(latencies);
+    cout << "  (checksum " << checksum << ")\n";
+    cout << "- GetBbo (batches of " << kQueryBatch << "): average " << average
+         << " ns, P50 " << latencies[latencies.size() / 2] << " ns, P99 "
+         << latencies[static_cast<size_t>(0.99 * (latencies.size() - 1))]
+         << " ns\n";
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "common/Types.hpp"
+#include "matching_engine/DropCopy.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+#include "Workload.hpp"
+
+const size_t kDefaultOrders = 2'000'000;
+const char kDropCopyPath[] = "drop_copy.bin";
+
+// Runs the flow through a fresh book, recording every fill into the drop
+// copy if there is one; prints per-operation latencies of the matching
+// thread, recording included
+void RunFlow(const string& name, const vector<Order>& orders,
+             DropCopyWriter* writer) {
+    OrderBook book;
+    vector<long long> latencies;
+    latencies.reserve(orders.size());
+    size_t fills = 0;
+    auto run_start = chrono::high_resolution_clock::now();
+    for (const Order& order : orders) {
+        auto start = chrono::high_resolution_clock::now();
+        if (order.getOrderType() != CANCEL) {
+            vector<Trade> trades = book.PlaceOrder(order);
+            if (writer != nullptr) {
+                writer->Record(trades);
+            }
+            fills += trades.size();
+        } else {
+            book.CancelOrder(order.getCancelOrderId());
+        }
+        auto end = chrono::high_resolution_clock::now();
+        latencies.push_back(
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+    double seconds = chrono::duration<double>(
+                         chrono::high_resolution_clock::now() - run_start)
+                         .count();
+
+    double average = accumulate(latencies.begin(), latencies.end(), 0.0) /
+                     static_cast<double>(latencies.size());
+    ranges::sort(latencies);
+    auto percentile = [&latencies](double p) {
+        return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    cout << "- " << name << ": average " << average << " ns, P50 "
+         << percentile(0.5) << " ns, P99 " << percentile(0.99)
+         << " ns, P99.9 " << percentile(0.999) << " ns ("
+         << static_cast<double>(fills) / seconds << " fills/s)\n";
+
+    if (writer != nullptr) {
+        writer->Close();
+        DropCopyStats stats = writer->GetStats();
+        cout << "  " << stats.records << " records in " << stats.writes
+             << " writes, " << stats.syncs << " syncs, " << stats.stalls
+             << " producer stalls, " << stats.errors << " errors"
+             << (stats.io_uring ? " (io_uring)" : "") << "\n";
+    }
+}
+
+// Usage: benchmark_drop_copy [--orders N]
+int main(int argc, char* argv[]) {
+    size_t num_orders = kDefaultOrders;
+    if (argc > 2 && string(argv[1]) == "--orders") {
+        num_orders = stoull(argv[2]);
+    }
+
+    cout << "Generating " << num_orders << " orders...\n";
+    Workload workload =
+        GenerateWorkload(*FindWorkloadProfile("default"), num_orders);
+
+    RunFlow("No drop copy", workload.orders, nullptr);
+
+    DropCopyWriter plain(kDropCopyPath, DropCopyOptions{});
+    RunFlow("write(), sync every 10 ms", workload.orders, &plain);
+
+    DropCopyWriter uring(kDropCopyPath,
+                         DropCopyOptions{.use_io_uring = true});
+    RunFlow("io_uring, sync every 10 ms", workload.orders, &uring);
+
+    DropCopyWriter every_batch(
+        kDropCopyPath,
+        DropCopyOptions{.sync = SYNC_EVERY_BATCH, .use_io_uring = true});
+    RunFlow("io_uring, sync every batch", workload.orders, &every_batch);
+
+    remove(kDropCopyPath);
+}
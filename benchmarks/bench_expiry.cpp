@@ -0,0 +1,99 @@
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+#include "common/Types.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+const int kRepetitions = 3;  // Runs per book size (best is kept)
+
+const int kStartPrice = 1000'00;  // Mid price in cents
+const int kLevelsPerSide = 5'000;
+
+// Session timeline in nanoseconds
+const Timestamp kSessionOpen = 9ULL * 3600 * 1'000'000'000;
+const Timestamp kSessionEnd = 17ULL * 3600 * 1'000'000'000;
+
+// Number of resting DAY orders at session end
+const vector<int> kOrderCounts = {100'000, 1'000'000, 2'000'000};
+
+// A book full of non-crossing DAY orders spread over both sides, with the
+// clock ticking through the session while it fills
+OrderBook BuildSessionBook(int order_count, vector<OrderID>& order_ids,
+                           default_random_engine& gen) {
+    uniform_int_distribution<int> level_distribution(1, kLevelsPerSide);
+    geometric_distribution<int> volume_distribution(0.1);
+
+    OrderBook book;
+    book.SetSessionEnd(kSessionEnd);
+    book.AdvanceTime(kSessionOpen);
+
+    Timestamp step = (kSessionEnd - kSessionOpen) / (order_count + 1);
+    order_ids.clear();
+    for (int i = 0; i < order_count; i++) {
+        Side side = i % 2 == 0 ? BUY : SELL;
+        int offset = level_distribution(gen);
+        Price price = side == BUY ? kStartPrice - offset : kStartPrice + offset;
+
+        Order order(i, side, LIMIT, price, volume_distribution(gen) + 1);
+        order.setTimeInForce(DAY);
+        book.PlaceOrder(order);
+        order_ids.push_back(order.getOrderId());
+
+        if (i % 1024 == 0) {
+            book.AdvanceTime(kSessionOpen + step * (i + 1));
+        }
+    }
+    return book;
+}
+
+int main() {
+    random_device rd;
+    default_random_engine generator(rd());
+
+    cout << "Session-end expiry benchmark (" << kLevelsPerSide
+         << " levels per side, best of " << kRepetitions << " runs)\n";
+
+    vector<OrderID> order_ids;
+    for (int order_count : kOrderCounts) {
+        long long best_expiry = LLONG_MAX;
+        long long best_cancel = LLONG_MAX;
+        size_t expired_count = 0;
+
+        for (int run = 0; run < kRepetitions; run++) {
+            // Timer wheel: one AdvanceTime past the session end
+            OrderBook book =
+                BuildSessionBook(order_count, order_ids, generator);
+            auto start = chrono::high_resolution_clock::now();
+            vector<OrderID> expired = book.AdvanceTime(kSessionEnd);
+            auto end = chrono::high_resolution_clock::now();
+            best_expiry = min<long long>(
+                best_expiry,
+                chrono::duration_cast<chrono::microseconds>(end - start)
+                    .count());
+            expired_count = expired.size();
+
+            // Baseline: the same orders removed one CancelOrder at a time
+            OrderBook cancel_book =
+                BuildSessionBook(order_count, order_ids, generator);
+            start = chrono::high_resolution_clock::now();
+            for (OrderID order_id : order_ids) {
+                cancel_book.CancelOrder(order_id);
+            }
+            end = chrono::high_resolution_clock::now();
+            best_cancel = min<long long>(
+                best_cancel,
+                chrono::duration_cast<chrono::microseconds>(end - start)
+                    .count());
+        }
+
+        cout << "- " << order_count << " DAY orders: timer wheel expiry "
+             << best_expiry << " us (" << expired_count
+             << " expired), individual cancels " << best_cancel << " us\n";
+    }
+}
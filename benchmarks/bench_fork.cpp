@@ -0,0 +1,86 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "common/Types.hpp"
+#include "matching_engine/BookFork.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+#include "Workload.hpp"
+
+const size_t kDefaultOrders = 2'000'000;
+const int kRepetitions = 1'000;
+const OrderID kWhatIfOrderId = UINT64_MAX;
+
+// What-if sweeps on a fork of a live book, against copying the book. The
+// book is built from half of a workload (deep-book unless named).
+//
+// Usage: benchmark_fork [profile] [--orders N]
+int main(int argc, char* argv[]) {
+    WorkloadProfile profile = *FindWorkloadProfile("deep-book");
+    size_t num_orders = kDefaultOrders;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--orders" && i + 1 < argc) {
+            num_orders = stoull(argv[++i]);
+        } else if (const WorkloadProfile* named = FindWorkloadProfile(arg)) {
+            profile = *named;
+        } else {
+            cerr << "Unknown argument: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    Workload workload = GenerateWorkload(profile, num_orders / 2);
+    PrintWorkloadMix(workload);
+    OrderBook book;
+    for (const Order& order : workload.orders) {
+        if (order.getOrderType() != CANCEL) {
+            book.PlaceOrder(order);
+        } else {
+            book.CancelOrder(order.getCancelOrderId());
+        }
+    }
+    MemoryUsage usage = book.GetMemoryUsage();
+    cout << "Book built from " << workload.orders.size() << " "
+         << profile.name << " orders (" << usage.Total() / 1024
+         << " KiB)\n";
+
+    // A full copy, for scale (it still shares the order records, so it is
+    // cheaper than a copy that could safely be matched against)
+    auto start = chrono::high_resolution_clock::now();
+    OrderBook copy = book;
+    auto end = chrono::high_resolution_clock::now();
+    cout << "- Copying the book: "
+         << chrono::duration_cast<chrono::microseconds>(end - start).count()
+         << " us\n";
+
+    // Fork, sweep one side with a market order, drop the fork
+    for (Volume volume : {10u, 100u, 1'000u, 10'000u, 100'000u}) {
+        size_t trades = 0;
+        size_t levels = 0;
+        start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < kRepetitions; i++) {
+            BookFork fork(book);
+            Side side = i % 2 == 0 ? BUY : SELL;
+            trades += fork
+                          .PlaceOrder(Order(kWhatIfOrderId, side, MARKET, 0,
+                                            volume))
+                          .size();
+            levels += fork.GetTouchedLevelCount();
+        }
+        end = chrono::high_resolution_clock::now();
+        double per_sweep_us =
+            static_cast<double>(
+                chrono::duration_cast<chrono::nanoseconds>(end - start)
+                    .count()) /
+            kRepetitions / 1000.0;
+        cout << "- What-if sweep of " << volume << ": " << per_sweep_us
+             << " us (" << trades / kRepetitions << " fills, "
+             << levels / kRepetitions << " levels touched)\n";
+    }
+}
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "Diagnostics.hpp"
+
+const double kDefaultSeconds = 10.0;
+const long long kDefaultThresholdNs = 1'000;  // gaps to record
+const int kHistogramBuckets = 24;             // powers of two of 1 us
+
+// A gap in an otherwise empty loop: the thread did not run for gap_ns
+struct Gap {
+    long long gap_ns;
+    OsCounters os;  // OS activity since the previous recorded gap
+};
+
+// Platform jitter probe: spins on the clock doing no work at all and records
+// every gap between consecutive reads above the threshold. Whatever shows up
+// here is machine noise (interrupts, preemption, SMIs, frequency changes),
+// so it is the floor against which benchmark_engine --outliers is judged.
+//
+// Usage: benchmark_jitter [seconds] [threshold_ns]
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? stod(argv[1]) : kDefaultSeconds;
+    long long threshold_ns = argc > 2 ? stoll(argv[2]) : kDefaultThresholdNs;
+
+    cout << "Idle-loop jitter probe: " << seconds << " s, recording gaps above "
+         << threshold_ns << " ns\n";
+
+    OsCounterReader os_reader;
+    vector<Gap> gaps;
+    gaps.reserve(1 << 16);
+    long long loops = 0;
+
+    // The loop body is one clock read; OS counters are only read after a gap
+    // so the loop itself stays as quiet as possible
+    OsCounters os_start = os_reader.Read();
+    OsCounters os_last = os_start;
+    auto start = chrono::steady_clock::now();
+    auto deadline = start + chrono::duration<double>(seconds);
+    auto previous = start;
+    while (previous < deadline) {
+        auto now = chrono::steady_clock::now();
+        long long gap_ns =
+            chrono::duration_cast<chrono::nanoseconds>(now - previous).count();
+        if (gap_ns > threshold_ns) {
+            OsCounters os_now = os_reader.Read();
+            gaps.push_back(Gap{.gap_ns = gap_ns, .os = os_now.Since(os_last)});
+            os_last = os_now;
+            now = chrono::steady_clock::now();  // skip the counter read
+        }
+        previous = now;
+        loops++;
+    }
+    OsCounters os_total = os_reader.Read().Since(os_start);
+
+    // ----- Results -----
+
+    long long lost_ns = 0;
+    long long max_gap_ns = 0;
+    size_t switched = 0;
+    size_t faulted = 0;
+    size_t unexplained = 0;
+    vector<size_t> histogram(kHistogramBuckets, 0);
+    for (const Gap& gap : gaps) {
+        lost_ns += gap.gap_ns;
+        max_gap_ns = max(max_gap_ns, gap.gap_ns);
+        switched += gap.os.HasContextSwitch() ? 1 : 0;
+        faulted += gap.os.HasPageFault() ? 1 : 0;
+        if (!gap.os.HasContextSwitch() && !gap.os.HasPageFault()) {
+            unexplained++;
+        }
+        int bucket = 0;
+        while (bucket + 1 < kHistogramBuckets &&
+               gap.gap_ns >= (1'000LL << (bucket + 1))) {
+            bucket++;
+        }
+        histogram[bucket]++;
+    }
+
+    cout << "- Clock reads: " << loops << " ("
+         << seconds * 1e9 / static_cast<double>(loops) << " ns each)\n";
+    cout << "- Gaps above threshold: " << gaps.size() << ", max "
+         << max_gap_ns << " ns, "
+         << 100.0 * static_cast<double>(lost_ns) / (seconds * 1e9)
+         << "% of the time lost\n";
+    cout << "- Gaps with a context switch: " << switched
+         << ", with a page fault: " << faulted
+         << ", neither (interrupts, SMIs, ...): " << unexplained << "\n";
+    cout << "- Interrupts on all CPUs during the probe: " << os_total.interrupts
+         << "\n";
+
+    cout << "Gap histogram:\n";
+    for (int bucket = 0; bucket < kHistogramBuckets; bucket++) {
+        if (histogram[bucket] == 0) {
+            continue;
+        }
+        if (bucket == 0) {
+            cout << "  < 2 us: " << histogram[bucket] << "\n";
+        } else {
+            cout << "  >= " << (1LL << bucket) << " us: " << histogram[bucket]
+                 << "\n";
+        }
+    }
+}
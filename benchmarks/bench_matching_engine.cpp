@@ -2,152 +2,117 @@
 #include <immintrin.h>
 #include <algorithm>
 #include <chrono>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <string>
 #include <vector>
 
 using namespace std;
 
 #include "common/Types.hpp"
+#include "matching_engine/ColumnarExport.hpp"
 #include "matching_engine/Order.hpp"
 #include "matching_engine/OrderBook.hpp"
 
-const int kNumOrders =
-    40'000'000;  // Total number of orders to generate and process
-
-const int kMinPrice = 800'00;     // Min price in cents
-const int kMaxPrice = 1200'00;    // Max price in cents
-const int kStartPrice = 1000'00;  // Starting mid price in cents
-
-const int kMaxCancelAttempts =
-    20;  // Max attempts to find a valid target for CANCEL orders
-
-int main() {
-    // ----- Random Order Generation -----
-
-    cout << "Generating " << kNumOrders << " random orders..." << "\n";
-
-    random_device rd;
-    default_random_engine generator(rd());
-
-    // Price movement distribution
-    normal_distribution<double> price_difference(0.0, 0.5);
-    double current_mid_price = kStartPrice;
-
-    // Type distribution: 0 for MARKET, 1 for LIMIT, 2 for CANCEL
-    discrete_distribution<int> type_distribution({10, 70, 20});
-
-    // Side distribution: 0 for BUY, 1 for SELL
-    uniform_int_distribution<int> side_distribution(0, 1);
-
-    // Price distribution for limit orders
-    geometric_distribution<int> price_offset_distribution(0.3);
-
-    // Volume distribution
-    geometric_distribution<int> volume_distribution(0.1);
-
-    // Pre-allocate memory
-    vector<Order> orders;
-    orders.reserve(kNumOrders);
-
-    // Shadow book to track active orders for generating valid CANCEL orders
-    OrderBook shadow_book;
-    vector<OrderID> active_limit_ids;
-    active_limit_ids.reserve(kNumOrders);
-
-    // Generate Orders
-    while (orders.size() < kNumOrders) {
-        // Simulate mid-price movement
-        current_mid_price += price_difference(generator);
-        current_mid_price = max<double>(current_mid_price, kMinPrice);
-        current_mid_price = min<double>(current_mid_price, kMaxPrice);
-
-        // Order type
-        auto type = static_cast<OrderType>(type_distribution(generator));
-
-        // CANCEL order
-        if (type == CANCEL) {
-            if (active_limit_ids.empty())
-                continue;
+#include "Diagnostics.hpp"
+#include "Workload.hpp"
 
-            // Attempt to find a valid target
-            size_t attempts = 0;
-
-            while (attempts < kMaxCancelAttempts && !active_limit_ids.empty()) {
-                // Pick random index
-                uniform_int_distribution<size_t> dist(
-                    0, active_limit_ids.size() - 1);
-                size_t idx = dist(generator);
-                OrderID target_id = active_limit_ids[idx];
-
-                // Check if it really exists in the book (not filled)
-                if (shadow_book.ContainsOrder(target_id)) {
-                    // Found a valid limit order to cancel
-                    orders.emplace_back(orders.size(), BUY, CANCEL, 0, 0,
-                                        target_id);
-                    shadow_book.CancelOrder(target_id);
-
-                    // Remove from active list
-                    active_limit_ids[idx] = active_limit_ids.back();
-                    active_limit_ids.pop_back();
-                    break;
-                }
-
-                // It was already filled, remove from active list and try again
-                active_limit_ids[idx] = active_limit_ids.back();
-                active_limit_ids.pop_back();
-
-                attempts++;
-            }
-            continue;
+const int kNumOrders =
+    40'000'000;  // Default number of orders to generate and process
+
+// Cold gaps: bytes of unrelated data streamed through the cache at the start
+// of each idle gap (more than the L2 of common server parts)
+const size_t kEvictionBytes = 8 << 20;
+const uint32_t kWarmIntervalNs = 5'000;  // KeepWarm period while idle
+
+// --export: trades of the latency run, plus a depth snapshot this often
+const int kDepthSnapshotInterval = 10'000;
+const size_t kDepthSnapshotLevels = 10;
+
+// Headline numbers of one RunBenchmarks call, for side-by-side tables
+struct BenchmarkSummary {
+    double average_ns = 0;
+    long long p50_ns = 0;
+    long long p99_ns = 0;
+    double throughput = 0;  // orders per second
+};
+
+// What the benchmark thread does during a bursty workload's idle gaps
+struct IdleGapOptions {
+    bool evict = false;      // other work takes the caches (--cold-gaps)
+    bool keep_warm = false;  // the book is kept warm (--keep-warm)
+};
+
+// Busy-waits so the idle gap does not give the core away. With cold gaps
+// other work first evicts the caches, then the gap starts; with warm-keeping
+// the idle thread calls KeepWarm every kWarmIntervalNs until it is over
+template <typename Book>
+static uint64_t IdleFor(const Book& book, uint32_t duration_ns,
+                        const IdleGapOptions& options,
+                        vector<uint8_t>& eviction_buffer) {
+    if (options.evict) {
+        for (size_t i = 0; i < eviction_buffer.size(); i += 64) {
+            eviction_buffer[i]++;
         }
-
-        // MARKET or LIMIT order
-
-        // Order side
-        Side side = side_distribution(generator) == 0 ? BUY : SELL;
-
-        // Order price
-        Price price;
-        if (type == LIMIT) {
-            int price_offset = price_offset_distribution(generator);
-
-            if (side == BUY) {
-                price = static_cast<Price>(current_mid_price) - price_offset;
-            } else {
-                price = static_cast<Price>(current_mid_price) + price_offset;
-            }
-
-            price = max<Price>(price, kMinPrice);
-            price = min<Price>(price, kMaxPrice);
-        } else {
-            price = 0;  // Price is not used for MARKET orders
+    }
+    auto now = chrono::steady_clock::now();
+    auto until = now + chrono::nanoseconds(duration_ns);
+    uint64_t checksum = 0;
+    auto next_warm = now;
+    while ((now = chrono::steady_clock::now()) < until) {
+        if (options.keep_warm && now >= next_warm) {
+            checksum += book.KeepWarm();
+            next_warm = now + chrono::nanoseconds(kWarmIntervalNs);
         }
+        _mm_pause();
+    }
+    return checksum;
+}
 
-        // Order volume
-        Volume volume = volume_distribution(generator);
-
-        orders.emplace_back(orders.size(), side, type, price, volume);
-
-        // Update Shadow State
-        shadow_book.PlaceOrder(orders.back());
-
-        if (type == LIMIT) {
-            active_limit_ids.push_back(orders.back().getOrderId());
-        }
+void PrintAfterGapLatencies(vector<long long>& latencies,
+                            const IdleGapOptions& options) {
+    if (latencies.empty()) {
+        return;
     }
+    ranges::sort(latencies, std::less<>());
+    double average =
+        accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+    cout << "First order after an idle gap ("
+         << (options.evict ? "cold gaps" : "quiet gaps")
+         << (options.keep_warm ? ", kept warm" : "") << "): "
+         << latencies.size() << " orders\n";
+    cout << "- Average latency: " << average << " ns\n";
+    cout << "- P50 latency: "
+         << latencies[static_cast<size_t>(0.50 * (latencies.size() - 1))]
+         << " ns\n";
+    cout << "- P99 latency: "
+         << latencies[static_cast<size_t>(0.99 * (latencies.size() - 1))]
+         << " ns\n";
+}
+
+// Latency and throughput runs over one workload, for one book type. With a
+// non-zero outlier threshold the latency run also records why outliers were
+// slow (see Diagnostics.hpp)
+template <typename Book>
+BenchmarkSummary RunBenchmarks(Workload& workload,
+                               long long outlier_threshold_ns,
+                               const IdleGapOptions& gap_options,
+                               bool export_data) {
+    vector<Order>& orders = workload.orders;
+    const int half = static_cast<int>(orders.size() / 2);
+    const int total = static_cast<int>(orders.size());
 
     // ----- Latency Benchmark Execution -----
 
     // Warm-up
-    cout << "Populating order book by simulating " << kNumOrders / 2
+    cout << "Populating order book by simulating " << half
          << " orders..."
          << "\n";
 
-    OrderBook latency_orderBook;
-    for (int i = 0; i < kNumOrders / 2; i++) {
+    Book latency_orderBook;
+    for (int i = 0; i < half; i++) {
         if (orders[i].getOrderType() != CANCEL) {
             latency_orderBook.PlaceOrder(orders[i]);
         } else {
@@ -156,16 +121,44 @@ int main() {
     }
 
     // Latency measurement
-    cout << "Running latency benchmark using the remaining " << kNumOrders / 2
+    cout << "Running latency benchmark using the remaining " << half
          << " orders..."
          << "\n";
 
     vector<long long> latencies;  // in nanoseconds
-    latencies.reserve(kNumOrders / 2);
+    latencies.reserve(half);
 
     long long total_checksum = 0;  // To prevent compiler optimizations
 
-    for (int i = kNumOrders / 2; i < kNumOrders; i++) {
+    // Diagnostic mode: OS counters between operations and the book state
+    // after every outlier. Each read doubles as the next operation's
+    // baseline, so nothing is read right before a timed operation.
+    const bool diagnose = outlier_threshold_ns > 0;
+    OsCounterReader os_reader;
+    vector<OutlierRecord> outliers;
+    uint64_t total_interrupts = 0;
+    OsCounters os_before;
+    double load_factor_before = 0;
+    if (diagnose) {
+        os_before = os_reader.Read();
+        load_factor_before = latency_orderBook.GetIndexLoadFactor();
+    }
+
+    // The first order after each idle gap, reported separately
+    vector<long long> after_gap_latencies;
+    vector<uint8_t> eviction_buffer(gap_options.evict ? kEvictionBytes : 0);
+    bool after_gap = false;
+
+    // Export mode: written by background threads, fed outside the timing
+    unique_ptr<TradeWriter> trade_writer;
+    unique_ptr<DepthWriter> depth_writer;
+    if (export_data) {
+        trade_writer = make_unique<TradeWriter>("trades.col", kTradeColumns);
+        depth_writer = make_unique<DepthWriter>("depth.col", kDepthColumns,
+                                                kDepthChunkRows);
+    }
+
+    for (int i = half; i < total; i++) {
         // Force cold cache for the order data
         _mm_clflush(&orders[i]);
         _mm_mfence();
@@ -180,20 +173,83 @@ int main() {
         auto end = chrono::high_resolution_clock::now();
         auto diff = chrono::duration_cast<chrono::nanoseconds>(end - start);
         latencies.push_back(static_cast<long long>(diff.count()));
+        if (after_gap) {
+            after_gap_latencies.push_back(latencies.back());
+            after_gap = false;
+        }
+
+        if (diagnose) {
+            OsCounters os_after = os_reader.Read();
+            OsCounters os = os_after.Since(os_before);
+            double load_factor = latency_orderBook.GetIndexLoadFactor();
+            total_interrupts += os.interrupts;
+            if (latencies.back() > outlier_threshold_ns) {
+                auto [swept, levels] = SweepShape(trades);
+                outliers.push_back(OutlierRecord{
+                    .sequence = static_cast<size_t>(i - half),
+                    .latency_ns = latencies.back(),
+                    .type = orders[i].getOrderType(),
+                    .orders_swept = swept,
+                    .levels_touched = levels,
+                    .index_load_factor = load_factor,
+                    .index_rehashed = load_factor < 0.75 * load_factor_before,
+                    .os = os});
+            }
+            os_before = os_after;
+            load_factor_before = load_factor;
+        }
 
         // Prevent compiler optimization by using the trades result in some way
         total_checksum += trades.size();
+
+        if (export_data) {
+            for (const Trade& trade : trades) {
+                trade_writer->Write(TradeRow(i - half, trade));
+            }
+            if ((i - half) % kDepthSnapshotInterval == 0) {
+                WriteDepthSnapshot(*depth_writer,
+                                   (i - half) / kDepthSnapshotInterval,
+                                   latency_orderBook, kDepthSnapshotLevels);
+            }
+        }
+
+        // Bursty profiles: idle until the next burst (not timed)
+        if (workload.idle_gaps_ns[i] != 0) {
+            total_checksum += IdleFor(latency_orderBook,
+                                      workload.idle_gaps_ns[i], gap_options,
+                                      eviction_buffer);
+            after_gap = true;
+
+            // What happened while idle is not the next operation's
+            if (diagnose) {
+                os_before = os_reader.Read();
+                load_factor_before = latency_orderBook.GetIndexLoadFactor();
+            }
+        }
     }
 
     cout << "Total checksum (to prevent optimization, ignore this number): "
          << total_checksum << "\n";
 
-    // Save latencies to a file for further analysis
-    ofstream latency_file("latencies.txt");
-    for (const auto& latency : latencies) {
-        latency_file << latency << "\n";
+    // Save latencies for further analysis (scripts/latencies.py)
+    LatencyWriter latency_writer("latencies.col", kLatencyColumns);
+    for (size_t i = 0; i < latencies.size(); i++) {
+        latency_writer.Write({static_cast<uint64_t>(latencies[i]),
+                              orders[half + i].getOrderType()});
+    }
+    latency_writer.Close();
+    if (export_data) {
+        trade_writer->Close();
+        depth_writer->Close();
+        cout << "Exported trades.col and depth.col\n";
+    }
+
+    if (diagnose) {
+        PrintOutlierSummary(outliers, outlier_threshold_ns, latencies.size(),
+                            static_cast<double>(total_interrupts) /
+                                static_cast<double>(latencies.size()));
+        WriteOutliers(outliers, "outliers.csv");
     }
-    latency_file.close();
 
     // ----- Latency results -----
 
@@ -218,15 +274,16 @@ int main() {
     cout << "- P90 latency: " << p90 << " ns" << "\n";
     cout << "- P99 latency: " << p99 << " ns" << "\n";
     cout << "- P99.9 latency: " << p999 << " ns" << "\n";
+    PrintAfterGapLatencies(after_gap_latencies, gap_options);
 
     // ----- Throughput Benchmark Execution -----
 
     // Warm-up
-    cout << "Populating order book by simulating " << kNumOrders / 2
+    cout << "Populating order book by simulating " << half
          << " orders..." << "\n";
 
-    OrderBook throughput_orderBook;
-    for (int i = 0; i < kNumOrders / 2; i++) {
+    Book throughput_orderBook;
+    for (int i = 0; i < half; i++) {
         if (orders[i].getOrderType() != CANCEL) {
             throughput_orderBook.PlaceOrder(orders[i]);
         } else {
@@ -236,11 +293,11 @@ int main() {
 
     // Throughput measurement
     cout << "Running throughput benchmark using the remaining "
-         << kNumOrders / 2 << " orders..."
+         << half << " orders..."
          << "\n";
 
     auto throughput_start = chrono::high_resolution_clock::now();
-    for (int i = kNumOrders / 2; i < kNumOrders; i++) {
+    for (int i = half; i < total; i++) {
         // Force cold cache for the order data
         _mm_clflush(&orders[i]);
         _mm_mfence();
@@ -258,7 +315,123 @@ int main() {
     auto total_duration = chrono::duration_cast<chrono::milliseconds>(
                               throughput_end - throughput_start)
                               .count();
-    double throughput = static_cast<double>(kNumOrders / 2) /
+    double throughput = static_cast<double>(half) /
                         (static_cast<double>(total_duration) / 1000.0);
     cout << "- Throughput: " << throughput / 1e6 << "M orders/sec" << "\n";
-}
\ No newline at end of file
+
+    return BenchmarkSummary{.average_ns = average_latency,
+                            .p50_ns = p50,
+                            .p99_ns = p99,
+                            .throughput = throughput};
+}
+
+// --all-containers: the FIFO book over every combination of the container
+// policies in ContainerPolicy.hpp, on the same workload
+using ContainerResults = vector<pair<string, BenchmarkSummary>>;
+
+template <typename LevelPolicy, typename QueuePolicy, typename IndexPolicy>
+void RunContainerVariant(Workload& workload, const IdleGapOptions& gap_options,
+                         ContainerResults& results) {
+    string name = string(LevelPolicy::kName) + " / " + QueuePolicy::kName +
+                  " / " + IndexPolicy::kName;
+    cout << "\nContainers: " << name << "\n";
+    using Book = BasicOrderBook<
+        FifoMatching, BookContainers<LevelPolicy, QueuePolicy, IndexPolicy>>;
+    results.emplace_back(name,
+                         RunBenchmarks<Book>(workload, 0, gap_options, false));
+}
+
+template <typename LevelPolicy, typename QueuePolicy>
+void RunIndexVariants(Workload& workload, const IdleGapOptions& gap_options,
+                      ContainerResults& results) {
+    RunContainerVariant<LevelPolicy, QueuePolicy, HashIndex>(
+        workload, gap_options, results);
+    RunContainerVariant<LevelPolicy, QueuePolicy, PooledHashIndex>(
+        workload, gap_options, results);
+}
+
+template <typename LevelPolicy>
+void RunQueueVariants(Workload& workload, const IdleGapOptions& gap_options,
+                      ContainerResults& results) {
+    RunIndexVariants<LevelPolicy, DequeQueue>(workload, gap_options, results);
+    RunIndexVariants<LevelPolicy, RingQueue>(workload, gap_options, results);
+}
+
+void RunAllContainerVariants(Workload& workload,
+                             const IdleGapOptions& gap_options) {
+    ContainerResults results;
+    RunQueueVariants<MapLevels>(workload, gap_options, results);
+    RunQueueVariants<PooledMapLevels>(workload, gap_options, results);
+
+    cout << "\nContainers (levels / queue / index): average, P50, P99 "
+            "latency, throughput\n";
+    for (const auto& [name, summary] : results) {
+        cout << "- " << name << ": " << summary.average_ns << " ns, "
+             << summary.p50_ns << " ns, " << summary.p99_ns << " ns, "
+             << summary.throughput / 1e6 << "M orders/sec\n";
+    }
+}
+
+// Usage: benchmark_engine [profile] [name=value ...] [--orders N]
+//                         [--pro-rata | --fifo-pro-rata | --all-containers]
+//                         [--outliers THRESHOLD_NS]
+//                         [--cold-gaps] [--keep-warm] [--export]
+//                         [--list]
+int main(int argc, char* argv[]) {
+    WorkloadProfile profile = *FindWorkloadProfile("default");
+    size_t num_orders = kNumOrders;
+    string policy = "fifo";
+    long long outlier_threshold_ns = 0;  // 0 = no diagnostics
+    IdleGapOptions gap_options;
+    bool export_data = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--list") {
+            PrintWorkloadProfiles();
+            return 0;
+        }
+        if (arg == "--orders" && i + 1 < argc) {
+            num_orders = stoull(argv[++i]);
+        } else if (arg == "--outliers" && i + 1 < argc) {
+            outlier_threshold_ns = stoll(argv[++i]);
+        } else if (arg == "--export") {
+            export_data = true;
+        } else if (arg == "--cold-gaps") {
+            gap_options.evict = true;
+        } else if (arg == "--keep-warm") {
+            gap_options.keep_warm = true;
+        } else if (arg == "--pro-rata" || arg == "--fifo-pro-rata" ||
+                   arg == "--all-containers") {
+            policy = arg.substr(2);
+        } else if (const WorkloadProfile* named = FindWorkloadProfile(arg)) {
+            profile = *named;
+        } else if (!SetWorkloadParameter(profile, arg)) {
+            cerr << "Unknown argument: " << arg << "\n";
+            PrintWorkloadProfiles();
+            return 1;
+        }
+    }
+
+    // ----- Random Order Generation -----
+
+    cout << "Generating " << num_orders << " random orders (profile: "
+         << profile.name << ", matching: " << policy << ")..." << "\n";
+
+    Workload workload = GenerateWorkload(profile, num_orders);
+    PrintWorkloadMix(workload);
+
+    // The matching and container policies are template parameters of the book
+    if (policy == "all-containers") {
+        RunAllContainerVariants(workload, gap_options);
+    } else if (policy == "pro-rata") {
+        RunBenchmarks<ProRataOrderBook>(workload, outlier_threshold_ns,
+                                        gap_options, export_data);
+    } else if (policy == "fifo-pro-rata") {
+        RunBenchmarks<FifoProRataOrderBook>(workload, outlier_threshold_ns,
+                                            gap_options, export_data);
+    } else {
+        RunBenchmarks<OrderBook>(workload, outlier_threshold_ns, gap_options,
+                                 export_data);
+    }
+}
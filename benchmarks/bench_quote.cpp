@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "common/Types.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+#include "Workload.hpp"
+
+const size_t kDefaultRounds = 20'000;
+const ParticipantID kQuoters = 50;
+const int kQuoteLevels = 3;         // levels per side in each quote
+const int kBackgroundLevels = 200;  // per side, below the quotes
+const int kBackgroundOrders = 4;    // per background level
+const OrderID kBackgroundIds = 1'000'000'000;
+
+// Every quoter's legs for every round: bids below the start price, asks
+// above it, so no leg ever trades and both books stay comparable
+vector<vector<vector<QuoteEntry>>> GenerateQuotes(size_t rounds) {
+    mt19937_64 rng(42);
+    uniform_int_distribution<int> shift(0, 3);
+    uniform_int_distribution<Volume> volume(1, 100);
+
+    vector<vector<vector<QuoteEntry>>> quotes(rounds);
+    for (auto& round : quotes) {
+        round.resize(kQuoters);
+        for (ParticipantID quoter = 0; quoter < kQuoters; quoter++) {
+            int offset = shift(rng);
+            for (int level = 0; level < kQuoteLevels; level++) {
+                OrderID id = static_cast<OrderID>(quoter) * 2 * kQuoteLevels +
+                             2 * level;
+                Price distance = 1 + level + offset;
+                round[quoter].push_back(
+                    {id, BUY, kStartPrice - distance, volume(rng)});
+                round[quoter].push_back(
+                    {id + 1, SELL, kStartPrice + distance, volume(rng)});
+            }
+        }
+    }
+    return quotes;
+}
+
+void AddBackground(OrderBook& book) {
+    OrderID id = kBackgroundIds;
+    for (int level = 0; level < kBackgroundLevels; level++) {
+        for (int i = 0; i < kBackgroundOrders; i++) {
+            book.PlaceOrder(Order(id++, BUY, LIMIT, kStartPrice - 1 - level,
+                                  100));
+            book.PlaceOrder(Order(id++, SELL, LIMIT, kStartPrice + 1 + level,
+                                  100));
+        }
+    }
+}
+
+// Per-quote latencies: one MassQuote per participant per round
+vector<long long> RunMassQuotes(
+    OrderBook& book, const vector<vector<vector<QuoteEntry>>>& quotes) {
+    vector<long long> latencies;
+    latencies.reserve(quotes.size() * kQuoters);
+    for (const auto& round : quotes) {
+        for (ParticipantID quoter = 0; quoter < kQuoters; quoter++) {
+            auto start = chrono::high_resolution_clock::now();
+            book.MassQuote(quoter, round[quoter]);
+            auto end = chrono::high_resolution_clock::now();
+            latencies.push_back(
+                chrono::duration_cast<chrono::nanoseconds>(end - start)
+                    .count());
+        }
+    }
+    return latencies;
+}
+
+// The same requotes as a cancel and a new order per leg
+vector<long long> RunCancelPlace(
+    OrderBook& book, const vector<vector<vector<QuoteEntry>>>& quotes) {
+    vector<long long> latencies;
+    latencies.reserve(quotes.size() * kQuoters);
+    for (const auto& round : quotes) {
+        for (ParticipantID quoter = 0; quoter < kQuoters; quoter++) {
+            auto start = chrono::high_resolution_clock::now();
+            for (const QuoteEntry& entry : round[quoter]) {
+                book.CancelOrder(entry.order_id);
+                Order order(entry.order_id, entry.side, LIMIT, entry.price,
+                            entry.volume);
+                order.setParticipantId(quoter);
+                book.PlaceOrder(order);
+            }
+            auto end = chrono::high_resolution_clock::now();
+            latencies.push_back(
+                chrono::duration_cast<chrono::nanoseconds>(end - start)
+                    .count());
+        }
+    }
+    return latencies;
+}
+
+void PrintLatencies(const string& name, vector<long long>& latencies) {
+    double average = accumulate(latencies.begin(), latencies.end(), 0.0) /
+                     static_cast<double>(latencies.size());
+    ranges::sort(latencies);
+    cout << "- " << name << ": average " << average << " ns per quote ("
+         << average / (2 * kQuoteLevels) << " ns per leg), P50 "
+         << latencies[latencies.size() / 2] << " ns, P99 "
+         << latencies[static_cast<size_t>(0.99 * (latencies.size() - 1))]
+         << " ns\n";
+}
+
+// Usage: benchmark_quote [--rounds N]
+int main(int argc, char* argv[]) {
+    size_t rounds = kDefaultRounds;
+    if (argc > 2 && string(argv[1]) == "--rounds") {
+        rounds = stoull(argv[2]);
+    }
+
+    cout << "Generating " << rounds << " rounds of " << kQuoters
+         << " quotes, " << kQuoteLevels << " levels a side...\n";
+    auto quotes = GenerateQuotes(rounds);
+
+    OrderBook quote_book;
+    AddBackground(quote_book);
+    OrderBook order_book;
+    AddBackground(order_book);
+
+    cout << "Requoting with MassQuote...\n";
+    vector<long long> quote_latencies = RunMassQuotes(quote_book, quotes);
+    cout << "Requoting with CancelOrder + PlaceOrder...\n";
+    vector<long long> order_latencies = RunCancelPlace(order_book, quotes);
+    PrintLatencies("MassQuote", quote_latencies);
+    PrintLatencies("CancelOrder + PlaceOrder", order_latencies);
+}
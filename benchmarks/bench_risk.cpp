@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "common/Types.hpp"
+#include "matching_engine/Order.hpp"
+#include "matching_engine/OrderBook.hpp"
+#include "matching_engine/RiskGate.hpp"
+
+#include "Workload.hpp"
+
+const size_t kDefaultOrders = 4'000'000;
+const ParticipantID kParticipants = 64;
+
+// Limits wide enough that every check runs to the end and passes
+const RiskConfig kRiskConfig = {.max_order_volume = kMaxOrderVolume,
+                                .price_collar = kMaxPrice - kMinPrice};
+const RiskLimits kParticipantLimits = {.max_order_volume = kMaxOrderVolume,
+                                       .max_open_notional = UINT64_MAX / 2,
+                                       .max_position = INT64_MAX / 2};
+
+// Per-operation latencies of one pass over the measured half
+template <typename Book>
+vector<long long> MeasureLatencies(Book& book, const vector<Order>& orders) {
+    size_t half = orders.size() / 2;
+    for (size_t i = 0; i < half; i++) {
+        if (orders[i].getOrderType() != CANCEL) {
+            book.PlaceOrder(orders[i]);
+        } else {
+            book.CancelOrder(orders[i].getCancelOrderId());
+        }
+    }
+
+    vector<long long> latencies;
+    latencies.reserve(orders.size() - half);
+    size_t checksum = 0;
+    for (size_t i = half; i < orders.size(); i++) {
+        auto start = chrono::high_resolution_clock::now();
+        if (orders[i].getOrderType() != CANCEL) {
+            checksum += book.PlaceOrder(orders[i]).size();
+        } else {
+            book.CancelOrder(orders[i].getCancelOrderId());
+        }
+        auto end = chrono::high_resolution_clock::now();
+        latencies.push_back(
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+    cout << "  (checksum " << checksum << ")\n";
+    return latencies;
+}
+
+void PrintLatencies(const string& name, vector<long long>& latencies) {
+    double average = accumulate(latencies.begin(), latencies.end(), 0.0) /
+                     static_cast<double>(latencies.size());
+    ranges::sort(latencies);
+    cout << "- " << name << ": average " << average << " ns, P50 "
+         << latencies[latencies.size() / 2] << " ns, P99 "
+         << latencies[static_cast<size_t>(0.99 * (latencies.size() - 1))]
+         << " ns\n";
+}
+
+// Usage: benchmark_risk [--orders N]
+int main(int argc, char* argv[]) {
+    size_t num_orders = kDefaultOrders;
+    if (argc > 2 && string(argv[1]) == "--orders") {
+        num_orders = stoull(argv[2]);
+    }
+
+    cout << "Generating " << num_orders << " orders over " << kParticipants
+         << " participants...\n";
+    Workload workload =
+        GenerateWorkload(*FindWorkloadProfile("default"), num_orders);
+    vector<Order>& orders = workload.orders;
+    for (size_t i = 0; i < orders.size(); i++) {
+        orders[i].setParticipantId(static_cast<ParticipantID>(i) %
+                                   kParticipants);
+    }
+
+    RiskGate gate(kRiskConfig);
+    for (ParticipantID id = 0; id < kParticipants; id++) {
+        gate.SetParticipantLimits(id, kParticipantLimits);
+    }
+    gate.SetReferencePrice(kStartPrice);
+
+    // The check alone, in a tight loop over every order
+    size_t passed = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (const Order& order : orders) {
+        passed += gate.CheckOrder(order) == NOT_REJECTED ? 1 : 0;
+    }
+    auto end = chrono::high_resolution_clock::now();
+    double check_ns =
+        static_cast<double>(
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count()) /
+        static_cast<double>(orders.size());
+    cout << "- CheckOrder: " << check_ns << " ns per order (" << passed
+         << " passed)\n";
+
+    // End to end: the same flow through a bare book and through the gate
+    cout << "Running the flow through a bare book...\n";
+    OrderBook book;
+    vector<long long> book_latencies = MeasureLatencies(book, orders);
+    cout << "Running the flow through the risk gate...\n";
+    vector<long long> gate_latencies = MeasureLatencies(gate, orders);
+    PrintLatencies("OrderBook", book_latencies);
+    PrintLatencies("RiskGate + OrderBook", gate_latencies);
+}
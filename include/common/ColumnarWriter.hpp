@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.hpp"
+
+using namespace std;
+
+const size_t kDefaultChunkRows = size_t{1} << 16;
+const size_t kColumnarRingRows = size_t{1} << 14;  // rows in flight
+const char kColumnarMagic[8] = {'O', 'B', 'C', 'O', 'L', 'S', '0', '1'};
+
+// One column of a columnar file: an unsigned little-endian integer of
+// `width` bytes (4 or 8)
+struct ColumnSpec {
+    char name[28];
+    uint32_t width;
+};
+static_assert(sizeof(ColumnSpec) == 32, "ColumnSpec is written as is");
+
+// Streams rows into a columnar binary file from a background thread. The
+// producer copies each row into an SPSC ring and never touches the file;
+// the writer thread transposes rows into fixed-size column chunks.
+//
+// Layout (little-endian):
+//   header: kColumnarMagic, uint32 column count, uint32 chunk rows, then
+//           one 32-byte ColumnSpec per column
+//   chunks: uint64 row count, then each column's chunk-rows values in turn
+//           (values past the row count are zero)
+// Every chunk has the same size, so readers can map the file as an array
+// of chunks (see scripts/columnar.py).
+template <size_t kColumns>
+class ColumnarWriter {
+   public:
+    using Row = array<uint64_t, kColumns>;
+
+   private:
+    using Ring = SpscRing<Row, kColumnarRingRows>;
+
+    FILE* file_ = nullptr;
+    array<ColumnSpec, kColumns> schema_;
+    size_t chunk_rows_;
+    array<size_t, kColumns> column_offsets_{};  // within a chunk
+
+    unique_ptr<Ring> ring_ = make_unique<Ring>();
+    uint64_t stalls_ = 0;  // producer waits on a full ring
+
+    // Writer thread state
+    vector<uint8_t> chunk_;
+    size_t rows_in_chunk_ = 0;
+    atomic<bool> closing_{false};
+    thread thread_;
+
+    void append(const Row& row) {
+        for (size_t column = 0; column < kColumns; column++) {
+            uint32_t width = schema_[column].width;
+            memcpy(&chunk_[column_offsets_[column] + rows_in_chunk_ * width],
+                   &row[column], width);
+        }
+        if (++rows_in_chunk_ == chunk_rows_) {
+            flushChunk();
+        }
+    }
+
+    void flushChunk() {
+        uint64_t rows = rows_in_chunk_;
+        memcpy(chunk_.data(), &rows, sizeof(rows));
+        fwrite(chunk_.data(), 1, chunk_.size(), file_);
+        fill(chunk_.begin(), chunk_.end(), 0);
+        rows_in_chunk_ = 0;
+    }
+
+    void run() {
+        // Drains the ring; sleeps briefly when it is empty so an idle
+        // writer does not compete with the producer for the core
+        Row row;
+        while (true) {
+            if (ring_->TryPop(row)) {
+                append(row);
+            } else if (closing_.load(memory_order_acquire)) {
+                if (ring_->Empty()) {
+                    break;
+                }
+            } else {
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+        }
+        if (rows_in_chunk_ != 0) {
+            flushChunk();
+        }
+    }
+
+   public:
+    ColumnarWriter(const string& path,
+                   const array<ColumnSpec, kColumns>& schema,
+                   size_t chunk_rows = kDefaultChunkRows)
+        : schema_(schema), chunk_rows_(chunk_rows) {
+        file_ = fopen(path.c_str(), "wb");
+        if (file_ == nullptr) {
+            return;
+        }
+
+        uint32_t header[2] = {static_cast<uint32_t>(kColumns),
+                              static_cast<uint32_t>(chunk_rows_)};
+        fwrite(kColumnarMagic, 1, sizeof(kColumnarMagic), file_);
+        fwrite(header, 1, sizeof(header), file_);
+        fwrite(schema_.data(), sizeof(ColumnSpec), kColumns, file_);
+
+        size_t offset = sizeof(uint64_t);
+        for (size_t column = 0; column < kColumns; column++) {
+            column_offsets_[column] = offset;
+            offset += chunk_rows_ * schema_[column].width;
+        }
+        chunk_.assign(offset, 0);
+        thread_ = thread([this]() { run(); });
+    }
+
+    ~ColumnarWriter() { Close(); }
+
+    ColumnarWriter(const ColumnarWriter&) = delete;
+    ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+
+    bool IsOpen() const { return file_ != nullptr; }
+
+    // Producer: spins while the ring is full (counted in GetStallCount)
+    void Write(const Row& row) {
+        if (file_ == nullptr) {
+            return;
+        }
+        while (!ring_->TryPush(row)) {
+            stalls_++;
+            this_thread::yield();
+        }
+    }
+
+    // Producer: writes out everything queued and closes the file
+    void Close() {
+        if (file_ == nullptr) {
+            return;
+        }
+        closing_.store(true, memory_order_release);
+        thread_.join();
+        fclose(file_);
+        file_ = nullptr;
+    }
+
+    uint64_t GetStallCount() const { return stalls_; }
+};
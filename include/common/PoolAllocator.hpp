@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+const size_t kPoolBlockNodes = 256;  // nodes carved from one block
+
+// Free list of fixed-size nodes shared by every PoolAllocator of one node
+// type on a thread. Blocks are allocated kPoolBlockNodes nodes at a time and
+// kept for the thread's lifetime, so a container that keeps freeing and
+// reallocating nodes (a level emptying and refilling) never reaches malloc.
+template <size_t kNodeBytes, size_t kNodeAlign>
+class NodePool {
+   private:
+    union Node {
+        Node* next;
+        alignas(kNodeAlign) unsigned char bytes[kNodeBytes];
+    };
+
+    Node* free_ = nullptr;
+    vector<Node*> blocks_;
+
+   public:
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool() {
+        for (Node* block : blocks_) {
+            ::operator delete(block, align_val_t{alignof(Node)});
+        }
+    }
+
+    void* Allocate() {
+        if (free_ == nullptr) {
+            Node* block = static_cast<Node*>(::operator new(
+                kPoolBlockNodes * sizeof(Node), align_val_t{alignof(Node)}));
+            blocks_.push_back(block);
+            for (size_t i = 0; i < kPoolBlockNodes; i++) {
+                block[i].next = free_;
+                free_ = &block[i];
+            }
+        }
+        Node* node = free_;
+        free_ = node->next;
+        return node;
+    }
+
+    void Free(void* pointer) {
+        Node* node = static_cast<Node*>(pointer);
+        node->next = free_;
+        free_ = node;
+    }
+
+    static NodePool& ThreadLocal() {
+        thread_local NodePool pool;
+        return pool;
+    }
+};
+
+// Stateless allocator serving single-object allocations (container nodes)
+// from the thread's NodePool; arrays (hash buckets) go to operator new. Any
+// two instances are equal, so containers using it stay copyable, movable
+// and can splice nodes between each other. Nodes must be freed on the
+// thread that allocated them.
+template <typename T>
+class PoolAllocator {
+   private:
+    using Pool = NodePool<sizeof(T), alignof(T)>;
+
+   public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        if (count == 1) {
+            return static_cast<T*>(Pool::ThreadLocal().Allocate());
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        if (count == 1) {
+            Pool::ThreadLocal().Free(pointer);
+        } else {
+            ::operator delete(pointer);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const {
+        return true;
+    }
+};
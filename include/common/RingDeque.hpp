@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Double-ended queue in one contiguous power-of-two ring. It offers the
+// subset of deque a price level uses (push_back, pop_front, indexing,
+// erase, iteration). Compared with deque, a short queue takes one small
+// allocation instead of a 512-byte chunk plus a chunk map, and walking it
+// touches consecutive cache lines; growing copies the whole queue.
+template <typename T>
+class RingDeque {
+   private:
+    vector<T> slots_;  // size is 0 or a power of two
+    size_t head_ = 0;
+    size_t size_ = 0;
+
+    size_t slot(size_t index) const {
+        return (head_ + index) & (slots_.size() - 1);
+    }
+
+    void reallocate(size_t capacity) {
+        vector<T> slots(capacity);
+        for (size_t i = 0; i < size_; i++) {
+            slots[i] = std::move(slots_[slot(i)]);
+        }
+        slots_.swap(slots);
+        head_ = 0;
+    }
+
+   public:
+    template <typename Queue, typename Value>
+    class Iterator {
+       private:
+        Queue* queue_ = nullptr;
+        size_t index_ = 0;
+
+       public:
+        using iterator_category = random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iterator() = default;
+        Iterator(Queue* queue, size_t index) : queue_(queue), index_(index) {}
+
+        reference operator*() const { return (*queue_)[index_]; }
+        pointer operator->() const { return &(*queue_)[index_]; }
+        reference operator[](difference_type n) const {
+            return (*queue_)[index_ + n];
+        }
+
+        Iterator& operator++() {
+            index_++;
+            return *this;
+        }
+        Iterator operator++(int) { return Iterator(queue_, index_++); }
+        Iterator& operator--() {
+            index_--;
+            return *this;
+        }
+        Iterator operator--(int) { return Iterator(queue_, index_--); }
+        Iterator& operator+=(difference_type n) {
+            index_ += n;
+            return *this;
+        }
+        Iterator& operator-=(difference_type n) {
+            index_ -= n;
+            return *this;
+        }
+        Iterator operator+(difference_type n) const {
+            return Iterator(queue_, index_ + n);
+        }
+        friend Iterator operator+(difference_type n, const Iterator& it) {
+            return it + n;
+        }
+        Iterator operator-(difference_type n) const {
+            return Iterator(queue_, index_ - n);
+        }
+        difference_type operator-(const Iterator& other) const {
+            return static_cast<difference_type>(index_) -
+                   static_cast<difference_type>(other.index_);
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+        auto operator<=>(const Iterator& other) const {
+            return index_ <=> other.index_;
+        }
+
+        size_t Index() const { return index_; }
+    };
+
+    using value_type = T;
+    using iterator = Iterator<RingDeque, T>;
+    using const_iterator = Iterator<const RingDeque, const T>;
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return slots_.size(); }
+
+    T& operator[](size_t index) { return slots_[slot(index)]; }
+    const T& operator[](size_t index) const { return slots_[slot(index)]; }
+    T& front() { return slots_[head_]; }
+    const T& front() const { return slots_[head_]; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    void push_back(T value) {
+        if (size_ == slots_.size()) {
+            reallocate(max<size_t>(4, 2 * slots_.size()));
+        }
+        slots_[slot(size_)] = std::move(value);
+        size_++;
+    }
+
+    void pop_front() {
+        slots_[head_] = T();  // release what the slot held
+        head_ = slot(1);
+        size_--;
+    }
+
+    // Closes the gap by moving the later elements forward
+    iterator erase(iterator position) {
+        size_t index = position.Index();
+        for (size_t i = index; i + 1 < size_; i++) {
+            (*this)[i] = std::move((*this)[i + 1]);
+        }
+        resize(size_ - 1);
+        return iterator(this, index);
+    }
+
+    void resize(size_t size) {
+        if (size > slots_.size()) {
+            reallocate(bit_ceil(size));
+        }
+        for (size_t i = size; i < size_; i++) {
+            (*this)[i] = T();
+        }
+        size_ = size;
+    }
+
+    void shrink_to_fit() {
+        size_t capacity = size_ == 0 ? 0 : max<size_t>(4, bit_ceil(size_));
+        if (capacity < slots_.size()) {
+            reallocate(capacity);
+        }
+    }
+};
+
+// Keeps the order of the elements that stay, like erase_if on a deque
+template <typename T, typename Predicate>
+size_t erase_if(RingDeque<T>& queue, Predicate predicate) {
+    size_t kept = 0;
+    for (size_t i = 0; i < queue.size(); i++) {
+        if (!predicate(queue[i])) {
+            if (kept != i) {
+                queue[kept] = std::move(queue[i]);
+            }
+            kept++;
+        }
+    }
+    size_t erased = queue.size() - kept;
+    queue.resize(kept);
+    return erased;
+}
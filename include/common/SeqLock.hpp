@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "SpscRing.hpp"
+
+using namespace std;
+
+// One writer publishes a value, any number of readers copy it without ever
+// blocking the writer. The writer makes the sequence odd, stores the value
+// and makes it even again; a reader retries if it saw an odd sequence or the
+// sequence moved while it copied. The value is kept in relaxed atomic words,
+// so a torn read is detected instead of being a data race.
+template <typename T>
+class SeqLock {
+    static_assert(is_trivially_copyable_v<T>,
+                  "SeqLock values are copied word by word");
+
+   private:
+    static constexpr size_t kWords = (sizeof(T) + 7) / 8;
+
+    alignas(kCacheLineSize) atomic<uint64_t> sequence_{0};
+    array<atomic<uint64_t>, kWords> words_{};
+
+   public:
+    SeqLock() = default;
+
+    // A copy starts out holding the source's current value, so objects that
+    // embed one stay copyable; the copy must not race with the writer
+    SeqLock(const SeqLock& other) { Store(other.Load()); }
+    SeqLock& operator=(const SeqLock& other) {
+        Store(other.Load());
+        return *this;
+    }
+
+    // Writer only
+    void Store(const T& value) {
+        uint64_t words[kWords] = {};
+        memcpy(words, &value, sizeof(T));
+
+        uint64_t sequence = sequence_.load(memory_order_relaxed);
+        sequence_.store(sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        for (size_t i = 0; i < kWords; i++) {
+            words_[i].store(words[i], memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, memory_order_release);
+    }
+
+    // Any thread
+    T Load() const {
+        uint64_t words[kWords];
+        while (true) {
+            uint64_t before = sequence_.load(memory_order_acquire);
+            for (size_t i = 0; i < kWords; i++) {
+                words[i] = words_[i].load(memory_order_relaxed);
+            }
+            atomic_thread_fence(memory_order_acquire);
+            uint64_t after = sequence_.load(memory_order_relaxed);
+            if (before == after && (before & 1) == 0) {
+                break;
+            }
+        }
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+};
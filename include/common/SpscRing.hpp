@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+using namespace std;
+
+const size_t kCacheLineSize = 64;
+
+// Bounded single-producer/single-consumer queue. The ring holds no pointers
+// and only lock-free atomics, so it can be placed in shared memory and used
+// between two processes as well as between two threads.
+template <typename T, size_t kCapacity>
+class SpscRing {
+    static_assert((kCapacity & (kCapacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+    static_assert(is_trivially_copyable_v<T>,
+                  "SpscRing elements are copied with plain stores");
+
+   private:
+    // Producer side: write position plus its last view of the read position
+    alignas(kCacheLineSize) atomic<uint64_t> tail_{0};
+    uint64_t cached_head_ = 0;
+
+    // Consumer side: read position plus its last view of the write position
+    alignas(kCacheLineSize) atomic<uint64_t> head_{0};
+    uint64_t cached_tail_ = 0;
+
+    alignas(kCacheLineSize) T slots_[kCapacity];
+
+   public:
+    // Producer: returns false if the ring is full
+    bool TryPush(const T& item) {
+        uint64_t tail = tail_.load(memory_order_relaxed);
+        if (tail - cached_head_ == kCapacity) {
+            cached_head_ = head_.load(memory_order_acquire);
+            if (tail - cached_head_ == kCapacity) {
+                return false;
+            }
+        }
+        slots_[tail & (kCapacity - 1)] = item;
+        tail_.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    // Consumer: returns false if the ring is empty
+    bool TryPop(T& item) {
+        uint64_t head = head_.load(memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        item = slots_[head & (kCapacity - 1)];
+        head_.store(head + 1, memory_order_release);
+        return true;
+    }
+
+    // Either side: number of items currently queued (a snapshot)
+    size_t Size() const {
+        return tail_.load(memory_order_acquire) -
+               head_.load(memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    static constexpr size_t Capacity() { return kCapacity; }
+};
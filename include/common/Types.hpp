@@ -2,17 +2,81 @@
 
 #include <cstdint>
 
-using OrderID = uint64_t;  // max order ID 18,446,744,073,709,551,615
-using Price = uint32_t;    // max price 4,294,967,295
-using Volume = uint32_t;   // max volume 4,294,967,295
+using OrderID = uint64_t;        // max order ID 18,446,744,073,709,551,615
+using Price = uint32_t;          // max price 4,294,967,295
+using Volume = uint32_t;         // max volume 4,294,967,295
+using Timestamp = uint64_t;      // engine time in nanoseconds
+using ParticipantID = uint32_t;  // account an order belongs to
 
 enum Side : uint8_t { BUY = 0, SELL = 1 };
 
-enum OrderType : uint8_t { MARKET = 0, LIMIT = 1, CANCEL = 2 };
+enum OrderType : uint8_t {
+    MARKET = 0,
+    LIMIT = 1,
+    CANCEL = 2,
+    STOP = 3,       // becomes a MARKET order once the trigger price trades
+    STOP_LIMIT = 4  // becomes a LIMIT order once the trigger price trades
+};
+
+enum TimeInForce : uint8_t {
+    GTC = 0,  // good till cancelled
+    DAY = 1,  // expires at the session end set on the book
+    GTD = 2,  // good till date: expires at the order's expire time
+    IOC = 3,  // immediate or cancel: fills what it can, never rests
+    FOK = 4   // fill or kill: fills in full on arrival or not at all
+};
+
+enum PegType : uint8_t {
+    NO_PEG = 0,
+    PEG_MID = 1,     // midpoint of the displayed best bid and ask
+    PEG_PRIMARY = 2  // same-side displayed best (bid for buys, ask for sells)
+};
+
+enum RejectReason : uint8_t {
+    NOT_REJECTED = 0,
+    OFF_TICK = 1,                // price is not on the instrument's tick grid
+    OUTSIDE_PRICE_BAND = 2,      // price is outside the instrument's band
+    ALREADY_EXPIRED = 3,         // expire time is not after the engine time
+    INVALID_PEG = 4,             // only plain limit orders can peg
+    INSUFFICIENT_LIQUIDITY = 5,  // fill-or-kill order cannot fill in full
+    UNKNOWN_PARTICIPANT = 6,     // risk: no limits set for the participant
+    ORDER_TOO_LARGE = 7,         // risk: volume above the max order size
+    OUTSIDE_PRICE_COLLAR = 8,    // risk: price too far from the last trade
+    OPEN_NOTIONAL_LIMIT = 9,     // risk: resting notional above the limit
+    POSITION_LIMIT = 10,         // risk: worst-case position above the limit
+    NOT_SIMULATED = 11,          // BookFork: pegged and stop orders
+    INVALID_QUOTE = 12,          // mass quote crossed itself or reused an ID
+    MARKET_IN_AUCTION = 13,      // call auction: market orders do not queue
+    DUPLICATE_ORDER_ID = 14      // risk: ID of an order that is still open
+};
+
+// Price grid of one instrument: valid prices are min_price + k * tick_size,
+// up to max_price
+struct InstrumentConfig {
+    Price tick_size = 1;
+    Price min_price = 0;
+    Price max_price = UINT32_MAX;
+};
+
+// How a matching order's fills are reported
+enum ReportMode : uint8_t {
+    PER_ORDER_REPORTS = 0,  // one Trade per resting order filled
+    CONFLATED_REPORTS = 1   // aggressor gets one Trade per price level swept
+};
+
+// Counterparty ID of a conflated Trade, which covers several resting orders
+const OrderID kConflatedOrderId = UINT64_MAX;
 
 struct Trade {
     OrderID buy_order_id;
     OrderID sell_order_id;
     Price price;
     Volume volume;
-};
\ No newline at end of file
+};
+
+// Indicative result of a call auction uncross
+struct AuctionResult {
+    Price price;              // equilibrium price (0 if book is not crossed)
+    uint64_t matched_volume;  // volume executable at the equilibrium price
+    int64_t imbalance;        // buy surplus (>0) or sell surplus (<0)
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Order.hpp"
+#include "OrderBook.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+// What-if view of a live OrderBook: simulated orders match, rest and cancel
+// as if they had been sent to the book, which is never modified. The fork
+// starts out sharing every level and order record with the book. A touched
+// level takes pointers off the front of the book's queue only as far as
+// matching reaches, and an order record is copied the first time it is
+// filled, so a hypothetical sweep costs about as much as the real one would.
+//
+// Displayed levels (icebergs included) are simulated in time priority.
+// Pegged and stop orders are neither simulated nor matched against, and
+// simulated trades do not trigger stops. The book must not change while a
+// fork of it is in use; Reset drops all simulated changes.
+class BookFork {
+   private:
+    // A touched level's queue: the orders taken off the front of the book's
+    // queue, then the book's orders from next on (less the ones the fork
+    // cancelled), then the orders the fork appended
+    struct ForkLevel {
+        const PriceLevel* live = nullptr;
+        size_t next = 0;
+        deque<shared_ptr<Order>> taken;
+        deque<shared_ptr<Order>> appended;
+        Volume total_volume = 0;
+        Volume hidden_volume = 0;
+    };
+
+    // Touched levels, keyed by tick like the book's; an empty level hides
+    // the book's level at that price
+    map<Price, ForkLevel, greater<Price>> buy_levels_;
+    map<Price, ForkLevel, less<Price>> sell_levels_;
+
+    const OrderBook& book_;
+    unordered_set<const Order*> owned_orders_;  // records the fork holds
+    size_t copied_orders_ = 0;                  // book records copied
+    size_t taken_orders_ = 0;                   // book pointers taken
+    RejectReason last_reject_reason_ = NOT_REJECTED;
+
+    // Orders placed in the fork and still resting, and book orders the fork
+    // has filled or cancelled
+    unordered_map<OrderID, shared_ptr<Order>> added_orders_;
+    unordered_set<OrderID> removed_orders_;
+
+    // Helpers
+    template <typename Touched, typename Levels, typename Visitor>
+    static void visitLevels(const Touched& touched, const Levels& live,
+                            Visitor visit);
+    template <typename Touched, typename Levels>
+    static ForkLevel& touchLevel(Touched& touched, const Levels& live,
+                                 Price tick);
+    shared_ptr<Order>* frontOrder(ForkLevel& level);
+    Order& ownOrder(shared_ptr<Order>& slot);
+    template <typename Touched, typename Levels>
+    void matchAgainst(Order& order, Touched& touched, const Levels& live,
+                      vector<Trade>& trades);
+    template <typename Touched, typename Levels>
+    uint64_t availableVolume(const Order& order, const Touched& touched,
+                             const Levels& live) const;
+    template <typename Touched, typename Levels>
+    bool removeOrder(Touched& touched, const Levels& live, Price tick,
+                     OrderID order_id);
+    void addOrder(const Order& order);
+
+   public:
+    explicit BookFork(const OrderBook& book);
+
+    // Simulated core methods (prices as in OrderBook, never ticks)
+    vector<Trade> PlaceOrder(Order order);
+    void CancelOrder(OrderID orderId);
+    void Reset();
+
+    // Query methods, over the book with the simulated changes applied
+    bool ContainsOrder(OrderID orderId) const;
+    RejectReason GetLastRejectReason() const;
+    Volume GetVolumeAtPrice(Price price, Side side) const;
+    size_t GetTouchedLevelCount() const;
+    size_t GetCopiedOrderCount() const;
+    size_t GetTakenOrderCount() const;
+};
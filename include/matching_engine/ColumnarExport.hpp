@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "OrderBook.hpp"
+#include "common/ColumnarWriter.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Schemas of the engine's columnar exports (see ColumnarWriter)
+
+// One row per fill; message is the caller's sequence number of the order
+// or command that produced it
+const array<ColumnSpec, 5> kTradeColumns = {{{"message", 8},
+                                             {"buy_order_id", 8},
+                                             {"sell_order_id", 8},
+                                             {"price", 4},
+                                             {"volume", 4}}};
+using TradeWriter = ColumnarWriter<kTradeColumns.size()>;
+
+inline TradeWriter::Row TradeRow(uint64_t message, const Trade& trade) {
+    return {message, trade.buy_order_id, trade.sell_order_id, trade.price,
+            trade.volume};
+}
+
+// One row per measured operation
+const array<ColumnSpec, 2> kLatencyColumns = {
+    {{"latency_ns", 8}, {"order_type", 4}}};
+using LatencyWriter = ColumnarWriter<kLatencyColumns.size()>;
+
+// One row per price level of a depth snapshot (level 0 is the best)
+const array<ColumnSpec, 7> kDepthColumns = {{{"snapshot", 8},
+                                             {"side", 4},
+                                             {"level", 4},
+                                             {"price", 4},
+                                             {"volume", 4},
+                                             {"hidden_volume", 4},
+                                             {"orders", 4}}};
+using DepthWriter = ColumnarWriter<kDepthColumns.size()>;
+const size_t kDepthChunkRows = 4'096;  // snapshots are small and sparse
+
+// Writes the top max_levels of both sides of the book as one snapshot
+template <typename Book>
+void WriteDepthSnapshot(DepthWriter& writer, uint64_t snapshot,
+                        const Book& book, size_t max_levels) {
+    for (Side side : {BUY, SELL}) {
+        vector<DepthLevel> depth = book.GetDepth(side, max_levels);
+        for (size_t level = 0; level < depth.size(); level++) {
+            writer.Write({snapshot, side, level, depth[level].price,
+                          depth[level].volume, depth[level].hidden_volume,
+                          depth[level].orders});
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/SeqLock.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+const size_t kTopOfBookLevels = 4;  // levels per side a book publishes
+
+// One displayed price level (instrument prices, not ticks); a volume of 0
+// marks an unused level
+struct TopLevel {
+    Price price = 0;
+    Volume volume = 0;  // displayed, iceberg reserves excluded
+
+    bool operator==(const TopLevel&) const = default;
+};
+
+// What a book publishes after every message that changes it
+struct TopOfBook {
+    array<TopLevel, kTopOfBookLevels> bids;  // best first
+    array<TopLevel, kTopOfBookLevels> asks;
+    bool in_auction = false;  // may be crossed; not part of the consolidation
+
+    bool operator==(const TopOfBook&) const = default;
+};
+
+// One book's top of book. A SeqLock starts on its own cache line and is
+// padded to whole lines, so books publishing into neighbouring slots never
+// share a line.
+using TopOfBookSlot = SeqLock<TopOfBook>;
+static_assert(alignof(TopOfBookSlot) == kCacheLineSize &&
+                  sizeof(TopOfBookSlot) % kCacheLineSize == 0,
+              "top of book slots must not share cache lines");
+
+// Best bid/offer over all books, with the volume of every book at that price
+struct ConsolidatedQuote {
+    Price bid_price = 0;
+    uint64_t bid_volume = 0;
+    uint32_t bid_books = 0;  // books at the best bid (0 = no bid anywhere)
+    Price ask_price = 0;
+    uint64_t ask_volume = 0;
+    uint32_t ask_books = 0;
+
+    bool HasBid() const { return bid_books != 0; }
+    bool HasAsk() const { return ask_books != 0; }
+};
+
+// Consolidated top of book for one product traded in several books (worker
+// shards, simulated venues). Each book publishes into its own slot from its
+// own thread (OrderBook::SetTopOfBookSlot); any thread can read the
+// consolidated view at any time. Reads copy every slot through its seqlock
+// and combine them, so writers never wait, readers never lock, and a book
+// that is mid-update is seen as of its previous message. Books in a call
+// auction are left out.
+class ConsolidatedBbo {
+   private:
+    vector<TopOfBookSlot> slots_;
+
+   public:
+    explicit ConsolidatedBbo(size_t books);
+
+    ConsolidatedBbo(const ConsolidatedBbo&) = delete;
+    ConsolidatedBbo& operator=(const ConsolidatedBbo&) = delete;
+
+    // Setup: the slot book `book` publishes into (valid for our lifetime)
+    TopOfBookSlot& GetSlot(size_t book);
+    size_t GetBookCount() const;
+
+    // Any thread
+    ConsolidatedQuote GetBbo() const;
+    uint64_t GetVolumeAtPrice(Price price, Side side) const;
+    TopOfBook GetTopOfBook(size_t book) const;
+};
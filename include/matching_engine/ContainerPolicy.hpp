@@ -0,0 +1,83 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "Order.hpp"
+#include "OrderIndex.hpp"
+#include "common/PoolAllocator.hpp"
+#include "common/RingDeque.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Container policies choose the data structures behind the book, one axis
+// each: the sorted price levels of a side, the time-priority queue of one
+// level and the order ID index. Like the matching policy they are compile-
+// time parameters (see BasicOrderBook), bundled by BookContainers, so
+// alternative backends are separate instantiations of the same book. Each
+// policy has a kName for benchmark output.
+
+// Price levels: a red-black tree with the default allocator
+struct MapLevels {
+    static constexpr const char* kName = "map";
+    template <typename Level, typename Compare>
+    using Levels = map<Price, Level, Compare>;
+};
+
+// Price levels: the same tree with nodes recycled through a NodePool, so a
+// level emptying and refilling does not go through malloc
+struct PooledMapLevels {
+    static constexpr const char* kName = "pooled-map";
+    template <typename Level, typename Compare>
+    using Levels =
+        map<Price, Level, Compare, PoolAllocator<pair<const Price, Level>>>;
+};
+
+// Level queue: deque (512-byte chunks plus a chunk map)
+struct DequeQueue {
+    static constexpr const char* kName = "deque";
+    template <typename T>
+    using Queue = deque<T>;
+};
+
+// Level queue: one contiguous ring per level
+struct RingQueue {
+    static constexpr const char* kName = "ring";
+    template <typename T>
+    using Queue = RingDeque<T>;
+};
+
+// Order index: hash map with the default allocator
+struct HashIndex {
+    static constexpr const char* kName = "hash";
+    using Index = BasicOrderIndex<unordered_map<OrderID, shared_ptr<Order>>>;
+};
+
+// Order index: the same hash map with nodes recycled through a NodePool
+struct PooledHashIndex {
+    static constexpr const char* kName = "pooled-hash";
+    using Index = BasicOrderIndex<unordered_map<
+        OrderID, shared_ptr<Order>, hash<OrderID>, equal_to<OrderID>,
+        PoolAllocator<pair<const OrderID, shared_ptr<Order>>>>>;
+};
+
+// One choice per axis; the defaults are the book's original containers
+template <typename LevelPolicy = MapLevels, typename QueuePolicy = DequeQueue,
+          typename IndexPolicy = HashIndex>
+struct BookContainers {
+    template <typename Level, typename Compare>
+    using Levels = typename LevelPolicy::template Levels<Level, Compare>;
+    using Queue = typename QueuePolicy::template Queue<shared_ptr<Order>>;
+    using Index = typename IndexPolicy::Index;
+
+    using LevelType = LevelPolicy;
+    using QueueType = QueuePolicy;
+    using IndexType = IndexPolicy;
+};
+
+using DefaultContainers = BookContainers<>;
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/SpscRing.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+const size_t kDropCopyRingSize = 1 << 16;      // records in flight
+const size_t kDefaultDropCopyBatch = 1 << 20;  // bytes per write
+const char kDropCopyMagic[8] = {'O', 'B', 'D', 'R', 'O', 'P', '0', '1'};
+
+// One fill as persisted. Sequences are gapless from 1 within a file, and
+// all fills of one Record call share a timestamp.
+struct DropCopyRecord {
+    uint64_t sequence;
+    uint64_t timestamp_ns;  // wall-clock (system_clock) time it was recorded
+    OrderID buy_order_id;
+    OrderID sell_order_id;
+    Price price;
+    Volume volume;
+};
+static_assert(sizeof(DropCopyRecord) == 40, "DropCopyRecord is written as is");
+
+enum SyncPolicy : uint8_t {
+    SYNC_NONE = 0,        // the OS flushes when it likes
+    SYNC_INTERVAL = 1,    // fdatasync at most once per sync interval
+    SYNC_EVERY_BATCH = 2  // fdatasync after every write
+};
+
+struct DropCopyOptions {
+    SyncPolicy sync = SYNC_INTERVAL;
+    uint64_t sync_interval_ns = 10'000'000;  // 10 ms
+    uint64_t flush_interval_ns = 1'000'000;  // longest a fill waits unwritten
+    size_t batch_bytes = kDefaultDropCopyBatch;
+    bool use_io_uring = false;  // falls back to write() if unavailable
+};
+
+// Writer-side counters, readable from any thread
+struct DropCopyStats {
+    uint64_t records;  // written to the file
+    uint64_t writes;
+    uint64_t syncs;
+    uint64_t stalls;  // producer waits on a full ring
+    uint64_t errors;  // failed writes or syncs
+    bool io_uring;    // writes go through io_uring
+};
+
+class UringFile;
+
+// Persists every fill off the matching thread. Record encodes each fill as
+// a DropCopyRecord into an SPSC ring; a background thread gathers them into
+// large batches, writes them out (with io_uring if asked for) and syncs per
+// the policy. A full ring makes Record wait rather than drop fills.
+//
+// File layout (little-endian): kDropCopyMagic, uint32 record size, then
+// one DropCopyRecord per fill.
+class DropCopyWriter {
+   private:
+    using Ring = SpscRing<DropCopyRecord, kDropCopyRingSize>;
+
+    int fd_ = -1;
+    DropCopyOptions options_;
+    unique_ptr<Ring> ring_ = make_unique<Ring>();
+
+    // Producer state
+    uint64_t sequence_ = 0;
+    atomic<uint64_t> stalls_{0};
+
+    // Writer thread state: with io_uring, one batch fills while the other
+    // is being written
+    vector<char> batches_[2];
+    size_t filling_ = 0;
+    uint64_t file_offset_ = 0;
+    uint64_t last_sync_ns_ = 0;
+    bool unsynced_ = false;  // written since the last sync
+    unique_ptr<UringFile> uring_;
+    bool io_uring_ = false;
+    size_t in_flight_records_ = 0;
+    atomic<uint64_t> records_{0};
+    atomic<uint64_t> writes_{0};
+    atomic<uint64_t> syncs_{0};
+    atomic<uint64_t> errors_{0};
+    atomic<bool> closing_{false};
+    thread thread_;
+
+    void push(const Trade& trade, uint64_t timestamp);
+    void run();
+    void writeBatch();
+    void finishWrite();
+    void syncNow();
+
+   public:
+    DropCopyWriter(const string& path,
+                   const DropCopyOptions& options = DropCopyOptions());
+    ~DropCopyWriter();
+
+    DropCopyWriter(const DropCopyWriter&) = delete;
+    DropCopyWriter& operator=(const DropCopyWriter&) = delete;
+
+    // Producer (the matching thread)
+    void Record(const Trade& trade);
+    void Record(const vector<Trade>& trades);
+    uint64_t GetSequence() const;
+
+    // Producer: writes out and syncs everything recorded, then closes
+    void Close();
+
+    DropCopyStats GetStats() const;
+};
+
+// Reads a drop-copy file back; throws if it is not one
+vector<DropCopyRecord> ReadDropCopy(const string& path);
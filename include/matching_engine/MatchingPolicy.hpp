@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Matching policies decide how an incoming order's volume is split between
+// the resting orders at one price level. They are compile-time parameters of
+// the book (see BasicOrderBook), so a FIFO book carries no pro-rata code.
+// kFifoPercent is the share of the incoming volume allocated in time priority
+// first; the rest is allocated pro-rata to the displayed sizes, with rounding
+// leftovers going back to time priority.
+
+// Strict price-time priority
+struct FifoMatching {
+    static constexpr uint32_t kFifoPercent = 100;
+};
+
+// Pure pro-rata (e.g. short-term interest rate futures)
+struct ProRataMatching {
+    static constexpr uint32_t kFifoPercent = 0;
+};
+
+// Split allocation: the oldest orders get a FIFO share, the rest pro-rata
+struct FifoProRataMatching {
+    static constexpr uint32_t kFifoPercent = 40;
+};
+
+// Products below this are exact in double
+const uint64_t kExactDoubleLimit = uint64_t{1} << 53;
+
+// shares[i] = floor(sizes[i] * volume / total) for all orders of a level,
+// where the sizes sum to total. While total * (volume + 1) stays below 2^53
+// every product, quotient bound and check is exact in double: the quotient
+// is rounded once and corrected by one if that rounding went up, in plain
+// branch-free arithmetic over contiguous arrays, which the compiler
+// vectorizes. Beyond that the shares are computed with integer division;
+// sizes and volume are Volume values, so their products fit in 64 bits.
+inline void ComputeProRataShares(const double* sizes, double* shares,
+                                 size_t count, Volume volume,
+                                 uint64_t total) {
+    if (total == 0) {
+        fill(shares, shares + count, 0.0);
+        return;
+    }
+    if (static_cast<uint64_t>(volume) + 1 < kExactDoubleLimit / total) {
+        const double volume_d = static_cast<double>(volume);
+        const double total_d = static_cast<double>(total);
+        for (size_t i = 0; i < count; i++) {
+            double numerator = sizes[i] * volume_d;
+            double share = floor(numerator / total_d);
+            shares[i] = share - (share * total_d > numerator ? 1.0 : 0.0);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        auto size = static_cast<uint64_t>(sizes[i]);
+        shares[i] = static_cast<double>(size * volume / total);
+    }
+}
@@ -12,6 +12,20 @@ class Order {
     Volume volume_;
     Volume filled_volume_;
     OrderID cancel_order_id_;
+    Price trigger_price_;
+    Volume peak_volume_;     // iceberg display size (0 if not an iceberg)
+    Volume visible_volume_;  // iceberg: remaining part of the shown slice
+    TimeInForce time_in_force_;
+    PegType peg_type_;
+    Price peg_offset_;       // pegged: ticks behind the reference price
+    ParticipantID participant_id_;
+    Timestamp expire_time_;  // DAY/GTD: engine time the order expires at
+
+    // Place in its price level's queue: the level's departure counters when
+    // it joined plus what was queued ahead of it (see BasicPriceLevel)
+    uint64_t queue_volume_mark_;
+    uint64_t queue_order_mark_;
+    bool queue_watched_;  // the owner gets queue position updates
 
    public:
     // Constructor
@@ -29,9 +43,32 @@ class Order {
     Volume getFilledVolume() const;
     Volume getRemainingVolume() const;
     OrderID getCancelOrderId() const;
+    Price getTriggerPrice() const;
+    Volume getPeakVolume() const;
+    Volume getVisibleVolume() const;
+    Volume getHiddenVolume() const;
+    TimeInForce getTimeInForce() const;
+    Timestamp getExpireTime() const;
+    PegType getPegType() const;
+    Price getPegOffset() const;
+    ParticipantID getParticipantId() const;
+    bool isIceberg() const;
+    bool isPegged() const;
     bool isFilled() const;
+    uint64_t getQueueVolumeMark() const;
+    uint64_t getQueueOrderMark() const;
+    bool isQueueWatched() const;
 
     // Setter methods
+    void setPrice(Price price);
     void setVolume(Volume volume);
     void addFilledVolume(Volume volume);
+    void setTriggerPrice(Price trigger_price);
+    void setPeakVolume(Volume peak_volume);
+    void setTimeInForce(TimeInForce time_in_force, Timestamp expire_time = 0);
+    void setPeg(PegType peg_type, Price peg_offset = 0);
+    void setParticipantId(ParticipantID participant_id);
+    Volume replenishVisibleVolume();
+    void setQueueMarks(uint64_t volume_mark, uint64_t order_mark);
+    void setQueueWatched(bool watched);
 };
\ No newline at end of file
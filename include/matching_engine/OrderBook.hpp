@@ -1,40 +1,383 @@
 #pragma once
 
+#include <array>
 #include <deque>
 #include <map>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "ConsolidatedBbo.hpp"
+#include "ContainerPolicy.hpp"
+#include "MatchingPolicy.hpp"
 #include "Order.hpp"
+#include "TickConverter.hpp"
+#include "TimerWheel.hpp"
+#include "TradeStatistics.hpp"
 #include "common/Types.hpp"
 
 using namespace std;
 
-class OrderBook {
+// Max number of triggered stop orders injected per call, so a stop cascade
+// during a fast move cannot stall the engine on a single message
+const size_t kDefaultMaxStopCascade = 64;
+
+// How much of each side KeepWarm touches: the best levels (displayed and
+// pegged) and the first orders queued at each of them
+const size_t kWarmLevels = 4;
+const size_t kWarmOrdersPerLevel = 32;
+
+// All resting orders at a single price, in time priority, plus the level's
+// aggregate remaining volume (kept up to date on add, fill and cancel).
+// hidden_volume is the part of total_volume held in iceberg reserves. Queue
+// comes from the book's container policy (see ContainerPolicy.hpp).
+//
+// Queue positions are counted, never scanned for: departed_volume and
+// departed_orders only grow, by the displayed volume and orders that leave
+// the queue ahead of everyone still in it. An order's queue marks are these
+// counters plus what was ahead of it when it joined, so what is ahead now
+// is its mark minus the counter. An order leaving from the middle counts as
+// departed for everyone and credits its marks back to the orders ahead.
+template <typename Queue>
+struct BasicPriceLevel {
+    Queue orders;
+    Volume total_volume = 0;
+    Volume hidden_volume = 0;
+    uint32_t watched = 0;  // orders whose owners get position updates
+    uint64_t departed_volume = 0;
+    uint64_t departed_orders = 0;
+};
+
+using PriceLevel = BasicPriceLevel<deque<shared_ptr<Order>>>;
+
+// What a bulk cancel removed from the book
+struct RangeCancelReport {
+    vector<OrderID> order_ids;  // in price (best first), then time order
+    uint64_t volume = 0;        // total remaining volume cancelled
+    size_t levels = 0;          // price levels dropped
+};
+
+// What sweeping the book for a given volume would cost right now
+struct FillCost {
+    uint64_t volume = 0;    // fillable volume (less than asked if too thin)
+    uint64_t notional = 0;  // sum of price * volume over the fills
+    Price worst_price = 0;  // price of the last level reached
+};
+
+// One leg of a mass quote. A leg whose order ID is already resting for the
+// participant is changed in place; other IDs are new orders.
+struct QuoteEntry {
+    OrderID order_id;
+    Side side;
+    Price price;
+    Volume volume;  // new remaining volume
+};
+
+// One displayed price level, as reported by GetDepth
+struct DepthLevel {
+    Price price = 0;
+    Volume volume = 0;         // total remaining, iceberg reserves included
+    Volume hidden_volume = 0;  // of which in iceberg reserves
+    uint32_t orders = 0;
+};
+
+// Where a resting order stands in its price level's time priority queue
+struct QueuePosition {
+    uint64_t volume_ahead = 0;  // displayed volume queued ahead of it
+    uint64_t orders_ahead = 0;
+};
+
+// A watched order's queue position after a message that moved its queue
+struct QueuePositionUpdate {
+    OrderID order_id;
+    ParticipantID participant_id;
+    QueuePosition position;
+};
+
+// Estimated heap bytes held by the book, by component
+struct MemoryUsage {
+    size_t levels = 0;    // price and trigger level nodes, queue slots in use
+    size_t orders = 0;    // order records (resting, stop and triggered)
+    size_t index = 0;     // order ID index entries and the buckets they need
+    size_t overhead = 0;  // allocated but idle: queue slack, spare buckets
+
+    size_t Total() const { return levels + orders + index + overhead; }
+};
+
+// Where an incremental compaction pass resumes
+enum CompactionPhase : uint8_t {
+    COMPACTION_IDLE = 0,
+    COMPACTING_INDEX = 1,
+    COMPACTING_BIDS = 2,
+    COMPACTING_ASKS = 3
+};
+
+class BookFork;
+
+// The limit order book. MatchingPolicy (see MatchingPolicy.hpp) selects the
+// allocation at a price level and Containers (see ContainerPolicy.hpp) the
+// level, queue and index data structures; the book is instantiated for the
+// combinations listed at the end of OrderBook.cpp.
+template <typename MatchingPolicy, typename Containers = DefaultContainers>
+class BasicOrderBook {
+    // Reads the levels, index and price grid of the book it simulates on
+    friend class BookFork;
+
    private:
-    map<Price, deque<shared_ptr<Order>>, greater<Price>> buy_orders_by_price_;
-    map<Price, deque<shared_ptr<Order>>, less<Price>> sell_orders_by_price_;
-    unordered_map<OrderID, shared_ptr<Order>> orders_by_id_;
+    using Level = BasicPriceLevel<typename Containers::Queue>;
+    template <typename Compare>
+    using LevelMap = typename Containers::template Levels<Level, Compare>;
+
+    // Pegged orders of one side and peg type, keyed by their tick offset
+    // behind the reference price (best first)
+    using PegLevels = LevelMap<less<Price>>;
+
+    // Levels are keyed by tick index (see TickConverter), not raw price
+    LevelMap<greater<Price>> buy_orders_by_price_;
+    LevelMap<less<Price>> sell_orders_by_price_;
+    typename Containers::Index orders_by_id_;
+
+    // Stop orders waiting for their trigger price, keyed so that the triggered
+    // range always starts at begin(): buy stops trigger when a trade prints at
+    // or above the key, sell stops at or below it
+    map<Price, deque<shared_ptr<Order>>, less<Price>> buy_stops_by_trigger_;
+    map<Price, deque<shared_ptr<Order>>, greater<Price>> sell_stops_by_trigger_;
+    deque<shared_ptr<Order>> triggered_stops_;
+    size_t max_stop_cascade_ = kDefaultMaxStopCascade;
+
+    // Pegged orders, per side and peg type (indexed by PegType - 1). They are
+    // priced from a reference BBO that is refreshed once per message, so a
+    // BBO change reprices all of them without touching any order
+    array<PegLevels, 2> buy_pegs_;
+    array<PegLevels, 2> sell_pegs_;
+    Price peg_best_bid_ = 0;  // reference, in ticks
+    Price peg_best_ask_ = 0;
+    bool peg_has_bid_ = false;
+    bool peg_has_ask_ = false;
+
+    // Instrument price grid, applied at the PlaceOrder/query boundary
+    TickConverter ticks_;
+    RejectReason last_reject_reason_ = NOT_REJECTED;
+
+    // Pro-rata scratch arrays, one entry per order at the level being shared
+    vector<double> prorata_sizes_;
+    vector<double> prorata_shares_;
+    vector<Volume> prorata_allocations_;
+    vector<shared_ptr<Order>> prorata_requeued_;
+
+    // Conflated mode: the per-order fills, kept for the passive side
+    ReportMode report_mode_ = PER_ORDER_REPORTS;
+    vector<Trade> passive_fills_;
+
+    // Order expiry: DAY/GTD orders are scheduled on the wheel when they rest
+    TimerWheel expiry_wheel_;
+    Timestamp now_ = 0;
+    Timestamp session_end_ = 0;  // expire time given to DAY orders (0 = none)
+
+    // Mass quotes: each participant's quote legs as of its last mass quote
+    // (legs filled or cancelled since then are skipped when it requotes)
+    unordered_map<ParticipantID, vector<shared_ptr<Order>>> quotes_;
+    vector<QuoteEntry> quote_entries_;  // scratch, reused by every quote
+    vector<shared_ptr<Order>> quote_old_legs_;
+    vector<shared_ptr<Order>> quote_records_;
+    vector<shared_ptr<Order>> quote_spare_;
+
+    // Call auction state
+    bool in_auction_ = false;
+    Price last_trade_price_ = 0;
+
+    // Last/VWAP/bars, fed per fill and published once per message
+    TradeStatistics trade_stats_;
+
+    // Top-of-book publishing for a consolidated BBO (none until a slot is
+    // set); the slot is only written when the published levels change
+    TopOfBookSlot* top_slot_ = nullptr;
+    TopOfBook published_top_;
+
+    // Queue position updates: levels with watched orders whose queue moved
+    // during the message (side << 32 | tick), and the updates not yet taken
+    vector<uint64_t> moved_queues_;
+    vector<QueuePositionUpdate> queue_updates_;
+
+    // Running hash of the book contents: the wrapping sum of one term per live
+    // order, one per price level and one per pair of neighbours in a queue
+    // (so time priority counts), so every change is a subtract + add
+    uint64_t state_hash_ = 0;
+
+    // Compaction progress, resumed by each Compact call
+    CompactionPhase compaction_phase_ = COMPACTION_IDLE;
+    Price compaction_cursor_ = 0;  // next level key to shrink
 
     // Helpers
-    vector<Trade> matchOrder(Order& order);
-    Trade executeMatch(Order& incoming_order, Order& resting_order);
+    RejectReason normalizePrices(Order& order) const;
+    void toExternalPrices(vector<Trade>& trades) const;
+    void placeOrder(Order& order, vector<Trade>& trades);
+    void executeOrder(Order& order, vector<Trade>& trades,
+                      bool expiry_scheduled = false);
+    void matchOrder(Order& order, vector<Trade>& trades);
+    template <typename Levels>
+    void matchAgainst(Order& order, Levels& opposite_book,
+                      vector<Trade>& trades);
+    template <typename LevelIterator>
+    void allocateLevel(Order& order, LevelIterator level_it,
+                       size_t first_trade, vector<Trade>& trades);
+    template <typename Levels>
+    void settleFrontOrder(Levels& book, typename Levels::iterator level_it);
+    void reportFill(const Order& order, const Trade& trade, size_t first_trade,
+                    vector<Trade>& trades);
+    Trade executeMatch(Order& incoming_order, Order& resting_order,
+                       Price trade_price, Volume trade_volume);
     bool canMatch(const Order& incoming, Price resting_price) const;
-    void addOrderToBook(const Order& order);
+    void addOrderToBook(const Order& order, bool expiry_scheduled = false);
+    void linkOrder(const shared_ptr<Order>& order);
+    template <typename Levels>
+    void unlinkOrder(Levels& book, const Order& order);
+
+    // Queue position helpers
+    void eraseQueued(Level& level, const Order& order);
+    void shrinkQueued(Level& level, const Order& order, Volume reduction);
+    void rebaseQueue(Level& level);
+    void noteQueueMoved(Side side, Price price, const Level& level);
+    static QueuePosition queuePosition(const Level& level, const Order& order);
+    void publishQueuePositions();
+
+    // Stop order helpers
+    void addStopOrder(const Order& order);
+    void cancelStopOrder(const Order& order);
+    void triggerStops(const vector<Trade>& trades, size_t first_trade);
+    void processTriggeredStops(vector<Trade>& trades);
+
+    // Pegged order helpers
+    PegLevels& pegLevels(Side side, PegType peg);
+    bool pegPrice(Side side, PegType peg, Price offset, Price& price) const;
+    PegLevels* bestPegLevels(Side side, Price& price);
+    void addPeggedOrder(const Order& order);
+    void cancelPeggedOrder(const Order& order);
+    void matchPegged(Order& order, PegLevels& pegs, Price peg_price,
+                     size_t first_trade, vector<Trade>& trades);
+    void settlePeggedFront(PegLevels& pegs);
+    void updatePegReference();
+    void repricePegs(vector<Trade>& trades);
+
+    // Mass quote helpers
+    RejectReason normalizeQuote(vector<QuoteEntry>& entries) const;
+    bool requoteInPlace(Order& leg, const QuoteEntry& entry);
+
+    // Liquidity query helpers
+    template <typename Levels, typename Visitor>
+    void visitLiquidity(const Levels& book, Side side, Visitor visit) const;
+    uint64_t availableVolume(Side side, bool limited, Price limit_tick,
+                             uint64_t enough) const;
+
+    // Order expiry helpers
+    RejectReason applyTimeInForce(Order& order) const;
+    bool isExpired(const Order& order) const;
+    void scheduleExpiry(const Order& order);
+    void expireOrders(const vector<OrderID>& due, vector<OrderID>& expired);
+
+    // Bulk cancel helpers
+    template <typename Levels>
+    void cancelLevels(Levels& book, typename Levels::iterator first,
+                      typename Levels::iterator last, Side side,
+                      RangeCancelReport& report);
+    RangeCancelReport cancelTickRange(Side side, Price low_tick,
+                                      Price high_tick);
+
+    // Call auction helpers
+    AuctionResult computeUncross() const;
+
+    // Memory helpers
+    template <typename Levels>
+    bool shrinkLevels(Levels& book, size_t work_budget, size_t& work);
+
+    // Top-of-book helpers
+    void publishTopOfBook();
+    template <typename Levels>
+    void topLevels(const Levels& book,
+                   array<TopLevel, kTopOfBookLevels>& levels) const;
+
+    // Warm-keeping helpers
+    template <typename Levels>
+    uint64_t warmLevels(const Levels& book) const;
+
+    // State hash helpers
+    static uint64_t mixHash(uint64_t value);
+    static uint64_t orderHash(const Order& order);
+    static uint64_t levelHash(Side side, Price price, const Level& level);
+    static uint64_t linkHash(const Order& ahead, const Order& behind);
+    static uint64_t queueHash(const Level& level);
 
    public:
     // Constructor
-    OrderBook();
+    BasicOrderBook();
+    explicit BasicOrderBook(const InstrumentConfig& config);
 
     // Core methods
     vector<Trade> PlaceOrder(Order order);
     void CancelOrder(OrderID orderId);
+    RangeCancelReport CancelRange(Side side, Price from_price, Price to_price);
+    RangeCancelReport CancelWorseThan(Side side, Price price);
+    vector<Trade> MassQuote(ParticipantID participant_id,
+                            const vector<QuoteEntry>& entries);
+
+    // Order expiry methods
+    vector<OrderID> AdvanceTime(Timestamp now);
+    void SetSessionEnd(Timestamp session_end);
+    size_t GetScheduledExpiryCount() const;
+
+    // Execution report methods
+    void SetReportMode(ReportMode report_mode);
+    vector<Trade> TakePassiveFills();
+
+    // Stop order methods
+    vector<Trade> ProcessTriggeredStops();
+    void SetMaxStopCascade(size_t max_stop_cascade);
+    size_t GetPendingStopCount() const;
+
+    // Call auction methods
+    void StartAuction();
+    vector<Trade> Uncross();
+    bool IsInAuction() const;
+    AuctionResult GetIndicativeUncross() const;
+
+    // Trade statistics methods
+    void SetBarInterval(Timestamp bar_interval_ns);
+    const TradeStatistics& GetTradeStatistics() const;
+
+    // Top-of-book methods
+    void SetTopOfBookSlot(TopOfBookSlot* slot);
+
+    // Queue position methods
+    bool GetQueuePosition(OrderID orderId, QueuePosition& position) const;
+    bool WatchQueuePosition(OrderID orderId);
+    void UnwatchQueuePosition(OrderID orderId);
+    vector<QueuePositionUpdate> TakeQueuePositionUpdates();
+
+    // Memory methods
+    MemoryUsage GetMemoryUsage() const;
+    bool Compact(size_t work_budget);
+
+    // Idle-time methods
+    uint64_t KeepWarm() const;
 
     // Helper methods
     bool ContainsOrder(OrderID orderId) const;
+    RejectReason GetLastRejectReason() const;
+    uint64_t GetStateHash() const;
+    double GetIndexLoadFactor() const;
 
     // Query methods
     Volume GetVolumeAtPrice(Price price, Side side) const;
+    Volume GetDisplayedVolumeAtPrice(Price price, Side side) const;
+    Volume GetHiddenVolumeAtPrice(Price price, Side side) const;
+    Volume GetPeggedVolume(Side side) const;
+    uint64_t GetAvailableVolume(Side side, Price limit_price) const;
+    FillCost GetCostToFill(Side side, uint64_t volume) const;
+    vector<DepthLevel> GetDepth(Side side, size_t max_levels) const;
+    Price GetPegPrice(PegType peg, Side side) const;
     void GetOrderBookStats() const;
-};
\ No newline at end of file
+};
+
+using OrderBook = BasicOrderBook<FifoMatching>;
+using ProRataOrderBook = BasicOrderBook<ProRataMatching>;
+using FifoProRataOrderBook = BasicOrderBook<FifoProRataMatching>;
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+#include "Order.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Order ID -> order record lookup. An unordered_map never gives back its
+// bucket array, so after a burst the index can be rebuilt at the live size:
+// the old table is drained into a fresh one a few entries per step (node
+// handles are moved, nothing is reallocated) while lookups check both.
+// Table is an unordered_map from OrderID to shared_ptr<Order>, with any
+// allocator (see ContainerPolicy.hpp).
+template <typename Table>
+class BasicOrderIndex {
+   private:
+    Table index_;
+    Table draining_;  // previous table, non-empty only while compacting
+
+   public:
+    const shared_ptr<Order>* Find(OrderID order_id) const {
+        auto it = index_.find(order_id);
+        if (it != index_.end()) {
+            return &it->second;
+        }
+        if (draining_.empty()) {
+            return nullptr;
+        }
+        auto old_it = draining_.find(order_id);
+        return old_it != draining_.end() ? &old_it->second : nullptr;
+    }
+
+    bool Contains(OrderID order_id) const { return Find(order_id) != nullptr; }
+
+    void Insert(OrderID order_id, const shared_ptr<Order>& order) {
+        index_[order_id] = order;
+    }
+
+    void Erase(OrderID order_id) {
+        if (index_.erase(order_id) == 0 && !draining_.empty()) {
+            draining_.erase(order_id);
+        }
+    }
+
+    size_t Size() const { return index_.size() + draining_.size(); }
+    size_t BucketCount() const {
+        return index_.bucket_count() + draining_.bucket_count();
+    }
+
+    // Buckets a table of the current size needs at the max load factor
+    size_t NeededBucketCount() const {
+        return static_cast<size_t>(static_cast<float>(Size()) /
+                                   index_.max_load_factor()) +
+               1;
+    }
+
+    bool IsCompacting() const { return !draining_.empty(); }
+
+    // Start draining into a table sized for the live entries; a table that is
+    // already close to its live size is left alone
+    void BeginCompaction() {
+        if (IsCompacting() || BucketCount() < 4 * NeededBucketCount()) {
+            return;
+        }
+        draining_.swap(index_);
+        Table fresh;
+        fresh.reserve(draining_.size());
+        index_.swap(fresh);
+    }
+
+    // Move up to max_entries into the new table; returns the number moved
+    size_t CompactStep(size_t max_entries) {
+        size_t moved = 0;
+        while (moved < max_entries && !draining_.empty()) {
+            index_.insert(draining_.extract(draining_.begin()));
+            moved++;
+        }
+        if (draining_.empty() && draining_.bucket_count() > 1) {
+            Table().swap(draining_);  // release the old bucket array
+        }
+        return moved;
+    }
+};
+
+using OrderIndex = BasicOrderIndex<unordered_map<OrderID, shared_ptr<Order>>>;
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Order.hpp"
+#include "OrderBook.hpp"
+#include "common/SpscRing.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Commands buffered between primary and standby (power of two)
+const size_t kReplicationRingSize = 1 << 16;
+
+// Standby treats the primary as dead after this long without a heartbeat
+const uint64_t kDefaultHeartbeatTimeoutNs = 50'000'000;  // 50 ms
+
+// Set in the published sequence by a promoting standby; the primary can
+// commit no further commands
+const uint64_t kSequenceFrozen = 1ULL << 63;
+
+enum CommandType : uint8_t {
+    PLACE_ORDER = 0,
+    CANCEL_ORDER = 1,  // order.getCancelOrderId() is the order to cancel
+    START_AUCTION = 2,
+    UNCROSS = 3,
+    PROCESS_STOPS = 4,
+    ADVANCE_TIME = 5,       // time is the new engine time
+    SET_SESSION_END = 6,    // time is the new session end
+    CANCEL_RANGE = 7,       // order side, from order price to to_price
+    CANCEL_WORSE_THAN = 8,  // order side and price
+    QUOTE_LEG = 9,          // order is one leg of the next MASS_QUOTE
+    MASS_QUOTE = 10         // order participant ID; applies the legs sent
+};
+
+// One sequenced input message, exactly as the primary applied it
+struct Command {
+    uint64_t sequence;
+    uint64_t publish_time_ns;
+    CommandType type;
+    Order order;
+    Timestamp time;
+    Price to_price;
+};
+
+enum ReplicationState : uint32_t {
+    PRIMARY_ACTIVE = 0,
+    HANDOVER_REQUESTED = 1,  // primary stopped publishing, standby takes over
+    STANDBY_PROMOTED = 2,    // standby owns the book, primary is fenced
+    STANDBY_DETACHED = 3     // standby stopped consuming, primary runs alone
+};
+
+struct ReplicationLag {
+    uint64_t sequences_behind;  // published but not yet applied
+    uint64_t apply_delay_ns;    // publish-to-apply time of the last command
+};
+
+// Layout of the shared memory segment. Primary-written and standby-written
+// fields sit on separate cache lines. The primary writes config before its
+// first heartbeat, so a nonzero heartbeat means the channel is ready.
+struct ReplicationChannel {
+    InstrumentConfig config;
+
+    alignas(kCacheLineSize) atomic<uint32_t> state{PRIMARY_ACTIVE};
+    atomic<uint32_t> epoch{0};
+    atomic<uint64_t> published_sequence{0};  // last committed command
+    atomic<uint64_t> primary_heartbeat_ns{0};
+    atomic<uint64_t> primary_state_hash{0};  // written on handover
+
+    alignas(kCacheLineSize) atomic<uint64_t> applied_sequence{0};
+    atomic<uint64_t> applied_state_hash{0};
+    atomic<uint64_t> apply_delay_ns{0};
+
+    SpscRing<Command, kReplicationRingSize> commands;
+};
+
+// POSIX shared memory mapping; the creating side unlinks it on destruction
+class SharedMemorySegment {
+   private:
+    string name_;
+    void* address_ = nullptr;
+    size_t size_ = 0;
+    bool owner_ = false;
+
+   public:
+    SharedMemorySegment(const string& name, size_t size, bool create);
+    ~SharedMemorySegment();
+
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+    void* GetAddress() const;
+};
+
+// Primary side: sequences every input command into the shared ring before
+// applying it to its own book
+class PrimaryBook {
+   private:
+    SharedMemorySegment segment_;
+    ReplicationChannel* channel_;
+    OrderBook book_;
+    uint64_t sequence_ = 0;
+
+    bool publish(CommandType type, const Order& order, Timestamp time = 0,
+                 Price to_price = 0);
+
+   public:
+    explicit PrimaryBook(const string& channel_name,
+                         const InstrumentConfig& config = InstrumentConfig());
+
+    // Core methods (no-ops once the primary is fenced)
+    vector<Trade> PlaceOrder(const Order& order);
+    void CancelOrder(OrderID orderId);
+    void StartAuction();
+    vector<Trade> Uncross();
+    vector<Trade> ProcessTriggeredStops();
+    vector<OrderID> AdvanceTime(Timestamp now);
+    void SetSessionEnd(Timestamp session_end);
+    RangeCancelReport CancelRange(Side side, Price from_price, Price to_price);
+    RangeCancelReport CancelWorseThan(Side side, Price price);
+    vector<Trade> MassQuote(ParticipantID participant_id,
+                            const vector<QuoteEntry>& entries);
+
+    // Replication methods. Commands refresh the heartbeat; an idle primary
+    // must call Heartbeat() well within the standby's timeout, or the
+    // standby takes over.
+    void Heartbeat();
+    void RequestHandover();
+    bool IsFenced() const;
+    ReplicationLag GetStandbyLag() const;
+    bool IsStandbyInSync() const;
+
+    const OrderBook& GetBook() const;
+};
+
+// Standby side: applies the primary's commands to its own book in lockstep,
+// with the instrument config the primary published in the channel
+class StandbyBook {
+   private:
+    SharedMemorySegment segment_;
+    ReplicationChannel* channel_;
+    OrderBook book_;
+    uint64_t applied_sequence_ = 0;
+    vector<QuoteEntry> quote_legs_;  // legs of the mass quote being received
+    bool verified_ = false;          // promoted on a handover, hashes equal
+
+    static ReplicationChannel* readyChannel(const SharedMemorySegment& segment);
+    void apply(const Command& command);
+
+   public:
+    explicit StandbyBook(const string& channel_name);
+
+    // Replication methods
+    size_t Poll(size_t max_commands = SIZE_MAX);
+    ReplicationLag GetLag() const;
+    uint64_t GetPrimaryHeartbeatAge() const;
+    bool IsHandoverRequested() const;
+    bool Promote();
+    bool IsPromoted() const;
+    bool IsPromotionVerified() const;
+
+    OrderBook& GetBook();
+};
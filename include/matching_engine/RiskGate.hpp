@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Order.hpp"
+#include "OrderBook.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Book-wide pre-trade limits (0 = no limit)
+struct RiskConfig {
+    Volume max_order_volume = 0;
+    Price price_collar = 0;  // max distance of a limit price from last trade
+};
+
+// Limits of one participant (0 = no limit)
+struct RiskLimits {
+    Volume max_order_volume = 0;
+    uint64_t max_open_notional = 0;  // resting buy + sell price * volume
+    int64_t max_position = 0;        // worst-case absolute net position
+};
+
+// Pre-trade risk layer in front of an OrderBook. Every order is checked
+// against the book-wide and its participant's limits before it reaches the
+// book; the check is a bounds check and a few compares on one participant's
+// counters. The counters (open volume and notional, net position) are kept
+// up to date incrementally from the fills, cancels and expiries that pass
+// through the gate, so the book must only be driven through it.
+// Fills are taken from per-order reports, the book's default report mode.
+class RiskGate {
+   private:
+    struct ParticipantState {
+        RiskLimits limits;
+        bool registered = false;
+        uint64_t open_notional = 0;
+        int64_t open_buy_volume = 0;
+        int64_t open_sell_volume = 0;
+        int64_t position = 0;  // net filled volume, buys positive
+    };
+
+    // What an accepted order still counts against its participant
+    struct OpenOrder {
+        ParticipantID participant_id;
+        Side side;
+        Price price;  // valuation price of the open volume
+        Volume remaining;
+    };
+
+    OrderBook book_;
+    RiskConfig risk_config_;
+    vector<ParticipantState> participants_;  // indexed by ParticipantID
+    unordered_map<OrderID, OpenOrder> open_orders_;
+    unordered_set<OrderID> open_stops_;  // stops, until they leave the book
+    Price reference_price_ = 0;  // collar center: last trade (0 = none yet)
+    RejectReason last_reject_reason_ = NOT_REJECTED;
+
+    Price valuationPrice(const Order& order) const;
+    void openOrder(const Order& order);
+    void releaseOrder(OrderID order_id);
+    void applyFill(OrderID order_id, Volume volume);
+    void applyTrades(const vector<Trade>& trades);
+    void releaseDepartedStops(const vector<Trade>& trades,
+                              size_t parked_stops);
+
+   public:
+    explicit RiskGate(const RiskConfig& risk_config = RiskConfig(),
+                      const InstrumentConfig& config = InstrumentConfig());
+
+    // Core methods (checked orders only reach the book if they pass)
+    vector<Trade> PlaceOrder(const Order& order);
+    void CancelOrder(OrderID orderId);
+    RangeCancelReport CancelRange(Side side, Price from_price, Price to_price);
+    RangeCancelReport CancelWorseThan(Side side, Price price);
+    vector<OrderID> AdvanceTime(Timestamp now);
+    vector<Trade> ProcessTriggeredStops();
+    void StartAuction();
+    vector<Trade> Uncross();
+
+    // Risk methods
+    RejectReason CheckOrder(const Order& order) const;
+    void SetParticipantLimits(ParticipantID participant_id,
+                              const RiskLimits& limits);
+    void SetReferencePrice(Price price);
+    uint64_t GetOpenNotional(ParticipantID participant_id) const;
+    int64_t GetPosition(ParticipantID participant_id) const;
+    RejectReason GetLastRejectReason() const;
+
+    const OrderBook& GetBook() const;
+};
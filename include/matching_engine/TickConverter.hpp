@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Converts external prices into dense tick indices (0 = band minimum, one
+// index per tick) and back. The conversion runs on every order, so it lives in
+// the header and uses a division by a compile-time constant for the common
+// power-of-ten tick sizes, which compiles to a multiply and shift.
+class TickConverter {
+   private:
+    InstrumentConfig config_;
+    uint8_t power_of_ten_;  // log10(tick_size), or kNotPowerOfTen
+
+    static constexpr uint8_t kNotPowerOfTen = UINT8_MAX;
+
+    template <Price kTickSize>
+    static RejectReason divideExact(Price offset, Price& tick) {
+        if (offset % kTickSize != 0) {
+            return OFF_TICK;
+        }
+        tick = offset / kTickSize;
+        return NOT_REJECTED;
+    }
+
+   public:
+    explicit TickConverter(const InstrumentConfig& config = InstrumentConfig())
+        : config_(config), power_of_ten_(kNotPowerOfTen) {
+        if (config_.tick_size == 0) {
+            config_.tick_size = 1;
+        }
+
+        Price scale = 1;
+        for (uint8_t power = 0; power <= 4; power++) {
+            if (config_.tick_size == scale) {
+                power_of_ten_ = power;
+            }
+            scale *= 10;
+        }
+    }
+
+    // External price -> tick index, rejecting off-tick and out-of-band prices
+    RejectReason ToTick(Price price, Price& tick) const {
+        if (price < config_.min_price || price > config_.max_price) {
+            return OUTSIDE_PRICE_BAND;
+        }
+
+        Price offset = price - config_.min_price;
+        switch (power_of_ten_) {
+            case 0:
+                tick = offset;
+                return NOT_REJECTED;
+            case 1:
+                return divideExact<10>(offset, tick);
+            case 2:
+                return divideExact<100>(offset, tick);
+            case 3:
+                return divideExact<1'000>(offset, tick);
+            case 4:
+                return divideExact<10'000>(offset, tick);
+            default:
+                if (offset % config_.tick_size != 0) {
+                    return OFF_TICK;
+                }
+                tick = offset / config_.tick_size;
+                return NOT_REJECTED;
+        }
+    }
+
+    // Nearest tick index at or below / at or above a price, clamped to the
+    // band (used for price ranges, where the bounds need not be on the grid)
+    Price FloorTick(Price price) const {
+        price = min(max(price, config_.min_price), config_.max_price);
+        return (price - config_.min_price) / config_.tick_size;
+    }
+
+    Price CeilTick(Price price) const {
+        price = min(max(price, config_.min_price), config_.max_price);
+        Price offset = price - config_.min_price;
+        return offset / config_.tick_size +
+               (offset % config_.tick_size != 0 ? 1 : 0);
+    }
+
+    // Tick index -> external price
+    Price ToPrice(Price tick) const {
+        return config_.min_price + tick * config_.tick_size;
+    }
+
+    // True when tick indices and prices coincide (tick 1, band from 0)
+    bool IsIdentity() const {
+        return config_.tick_size == 1 && config_.min_price == 0;
+    }
+
+    const InstrumentConfig& GetConfig() const { return config_; }
+};
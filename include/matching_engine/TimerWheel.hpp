@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "common/Types.hpp"
+
+using namespace std;
+
+// Expiry clock resolution: orders expire at most this late
+const Timestamp kDefaultExpiryResolutionNs = 1'000'000;  // 1 ms
+
+// Hierarchical timer wheel of order expiries. Four levels of 256 slots cover
+// 2^32 ticks (about 49 days at 1 ms); entries further out wait in an overflow
+// list. Scheduling is O(1) and entries are never removed: a cancelled or
+// filled order's entry simply fires later and is ignored by the book.
+// Advancing jumps straight to the next occupied slot using per-level
+// occupancy bitmaps, so long idle periods cost nothing.
+class TimerWheel {
+   private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 8;
+    static constexpr size_t kSlots = size_t{1} << kSlotBits;
+    static constexpr size_t kWords = kSlots / 64;
+
+    struct Entry {
+        OrderID order_id;
+        uint64_t tick;
+    };
+
+    Timestamp resolution_ns_;
+    uint64_t current_tick_ = 0;  // every tick up to this one has fired
+    size_t size_ = 0;            // entries in the slots and overflow
+
+    array<array<vector<Entry>, kSlots>, kLevels> slots_;
+    array<array<uint64_t, kWords>, kLevels> occupied_{};
+    vector<Entry> overflow_;  // more than one top-level rotation ahead
+    uint64_t overflow_first_tick_ = UINT64_MAX;
+    vector<OrderID> overdue_;  // scheduled at or before current_tick_
+
+    size_t digit(uint64_t tick, int level) const;
+    void place(const Entry& entry);
+    int nextOccupiedSlot(int level, size_t from) const;
+    uint64_t nextEventTick() const;
+    void land(vector<OrderID>& due);
+
+   public:
+    explicit TimerWheel(Timestamp resolution_ns = kDefaultExpiryResolutionNs);
+
+    void Schedule(OrderID order_id, Timestamp expire_time);
+    void Advance(Timestamp now, vector<OrderID>& due);
+    size_t Size() const;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/SeqLock.hpp"
+#include "common/Types.hpp"
+
+using namespace std;
+
+const Timestamp kDefaultBarIntervalNs = 60'000'000'000;  // 1 minute
+const size_t kBarHistory = 64;  // closed bars kept for readers
+
+// Running statistics since the book was created
+struct TradeSummary {
+    Price last = 0;  // 0 until the first trade
+    Price high = 0;
+    Price low = 0;
+    uint64_t volume = 0;
+    uint64_t notional = 0;  // sum of price * volume
+    uint64_t trades = 0;    // fills (one per resting order filled)
+
+    double Vwap() const {
+        return volume == 0 ? 0.0
+                           : static_cast<double>(notional) /
+                                 static_cast<double>(volume);
+    }
+};
+
+// OHLCV of one bar interval. Intervals without trades have no bar.
+struct Bar {
+    Timestamp start = 0;  // engine time, a multiple of the bar interval
+    Price open = 0;
+    Price high = 0;
+    Price low = 0;
+    Price close = 0;
+    uint64_t volume = 0;
+    uint64_t notional = 0;
+    uint64_t trades = 0;
+};
+
+// Last/high/low, cumulative volume and notional (VWAP) and time-bucketed
+// OHLCV bars of one instrument. The matching thread records every fill in
+// O(1) and publishes once per message; other threads read consistent copies
+// through seqlocks without ever blocking it. A bar closes when the first
+// fill of a later interval arrives.
+class TradeStatistics {
+   private:
+    // Published together, so a reader never sees a bar ahead of the totals
+    struct Current {
+        TradeSummary summary;
+        Bar bar;
+        uint64_t closed_bars = 0;
+    };
+
+    // Writer-side state, published by Publish
+    Timestamp bar_interval_ns_;
+    Current current_;
+    bool dirty_ = false;
+
+    SeqLock<Current> published_;
+    array<SeqLock<Bar>, kBarHistory> closed_;  // ring of closed bars
+
+   public:
+    explicit TradeStatistics(
+        Timestamp bar_interval_ns = kDefaultBarIntervalNs);
+
+    // Matching thread
+    void RecordTrade(Timestamp now, Price price, Volume volume);
+    void Publish();
+    void SetBarInterval(Timestamp bar_interval_ns);
+
+    // Any thread
+    TradeSummary GetSummary() const;
+    Bar GetCurrentBar() const;
+    uint64_t GetClosedBarCount() const;
+    bool GetClosedBar(size_t age, Bar& bar) const;  // age 0 = most recent
+};
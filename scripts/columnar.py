@@ -0,0 +1,37 @@
+import numpy as np
+
+# Reader for the engine's columnar files (include/common/ColumnarWriter.hpp).
+# The chunks are memory-mapped, not read; a column is gathered from them on
+# access.
+
+MAGIC = b'OBCOLS01'
+WIDTH_TYPES = {4: '<u4', 8: '<u8'}
+
+
+def read_columns(path):
+    """Returns {column name: numpy array} for a columnar file."""
+    header = np.memmap(path, dtype=np.uint8, mode='r', shape=(16,))
+    if bytes(header[:8]) != MAGIC:
+        raise ValueError(f'{path} is not a columnar file')
+    column_count, chunk_rows = np.frombuffer(bytes(header[8:16]), dtype='<u4')
+
+    spec_dtype = np.dtype([('name', 'S28'), ('width', '<u4')])
+    specs = np.memmap(path, dtype=spec_dtype, mode='r', offset=16,
+                      shape=(int(column_count),))
+    columns = [(spec['name'].decode(), WIDTH_TYPES[int(spec['width'])])
+               for spec in specs]
+
+    # Every chunk is the same size: a row count, then each column in turn
+    chunk_dtype = np.dtype([('rows', '<u8')] +
+                           [(name, dtype, (int(chunk_rows),))
+                            for name, dtype in columns])
+    data_offset = 16 + spec_dtype.itemsize * len(columns)
+    chunks = np.memmap(path, dtype=chunk_dtype, mode='r', offset=data_offset)
+
+    rows = chunks['rows']
+    result = {}
+    for name, _ in columns:
+        # Only the last chunk can be partly filled
+        parts = [chunks[name][i, :rows[i]] for i in range(len(chunks))]
+        result[name] = np.concatenate(parts) if parts else np.array([])
+    return result
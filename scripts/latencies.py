@@ -1,16 +1,10 @@
 import matplotlib.pyplot as plt
 
-latencies = []
+from columnar import read_columns
 
-print("Reading latencies from latencies.txt...")
+print("Reading latencies from latencies.col...")
 
-with open('latencies.txt', 'r') as f:
-    for line in f:
-        parts = line.strip().split()
-        if not parts:
-            continue
-        latency = int(parts[0])
-        latencies.append(latency)
+latencies = read_columns('latencies.col')['latency_ns']
 
 print(f"Read {len(latencies)} latency measurements.")
 
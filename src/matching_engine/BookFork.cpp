@@ -0,0 +1,352 @@
+#include <algorithm>
+
+#include "common/Types.hpp"
+#include "matching_engine/BookFork.hpp"
+
+using namespace std;
+
+BookFork::BookFork(const OrderBook& book) : book_(book) {}
+
+template <typename Touched, typename Levels, typename Visitor>
+void BookFork::visitLevels(const Touched& touched, const Levels& live,
+                           Visitor visit) {
+    // Merges the book's levels with the touched ones, best first; a touched
+    // level replaces the book's level at its price and empty levels are
+    // skipped. visit(tick, total_volume) returns false to stop.
+    auto live_it = live.begin();
+    auto touched_it = touched.begin();
+    auto comp = live.key_comp();
+    while (live_it != live.end() || touched_it != touched.end()) {
+        Volume total_volume = 0;
+        Price tick = 0;
+        if (touched_it == touched.end() ||
+            (live_it != live.end() &&
+             comp(live_it->first, touched_it->first))) {
+            tick = live_it->first;
+            if (!live_it->second.orders.empty()) {
+                total_volume = live_it->second.total_volume;
+            }
+            ++live_it;
+        } else {
+            if (live_it != live.end() && live_it->first == touched_it->first) {
+                ++live_it;
+            }
+            tick = touched_it->first;
+            total_volume = touched_it->second.total_volume;
+            ++touched_it;
+        }
+        if (total_volume > 0 && !visit(tick, total_volume)) {
+            return;
+        }
+    }
+}
+
+template <typename Touched, typename Levels>
+BookFork::ForkLevel& BookFork::touchLevel(Touched& touched,
+                                          const Levels& live, Price tick) {
+    // First touch copies the book's totals, not its queue
+    auto it = touched.find(tick);
+    if (it != touched.end()) {
+        return it->second;
+    }
+    ForkLevel level;
+    auto live_it = live.find(tick);
+    if (live_it != live.end()) {
+        level.live = &live_it->second;
+        level.total_volume = live_it->second.total_volume;
+        level.hidden_volume = live_it->second.hidden_volume;
+    }
+    return touched.emplace(tick, std::move(level)).first->second;
+}
+
+shared_ptr<Order>* BookFork::frontOrder(ForkLevel& level) {
+    // Once the taken orders run out, the next book order the fork has not
+    // cancelled is taken, then the appended ones
+    while (level.taken.empty()) {
+        if (level.live != nullptr && level.next < level.live->orders.size()) {
+            const shared_ptr<Order>& order = level.live->orders[level.next++];
+            if (!removed_orders_.contains(order->getOrderId())) {
+                level.taken.push_back(order);
+                taken_orders_++;
+            }
+        } else if (!level.appended.empty()) {
+            level.taken.push_back(std::move(level.appended.front()));
+            level.appended.pop_front();
+        } else {
+            return nullptr;
+        }
+    }
+    return &level.taken.front();
+}
+
+Order& BookFork::ownOrder(shared_ptr<Order>& slot) {
+    // An order record still shared with the book is copied before any change
+    if (!owned_orders_.contains(slot.get())) {
+        slot = make_shared<Order>(*slot);
+        owned_orders_.insert(slot.get());
+        copied_orders_++;
+    }
+    return *slot;
+}
+
+template <typename Touched, typename Levels>
+void BookFork::matchAgainst(Order& order, Touched& touched,
+                            const Levels& live, vector<Trade>& trades) {
+    bool buyer = order.getSide() == BUY;
+    while (!order.isFilled()) {
+        // The best level of the merged view, made a touched level to fill
+        bool found = false;
+        Price tick = 0;
+        visitLevels(touched, live, [&](Price level_tick, Volume) {
+            found = true;
+            tick = level_tick;
+            return false;
+        });
+        if (!found || (order.getOrderType() == LIMIT &&
+                       (buyer ? tick > order.getPrice()
+                              : tick < order.getPrice()))) {
+            return;
+        }
+        ForkLevel& level = touchLevel(touched, live, tick);
+
+        // Time priority, against displayed volume only, as in the book
+        shared_ptr<Order>* front = nullptr;
+        while (!order.isFilled() && (front = frontOrder(level)) != nullptr) {
+            Order& resting_order = ownOrder(*front);
+            Volume trade_volume = min(order.getRemainingVolume(),
+                                      resting_order.getVisibleVolume());
+            order.addFilledVolume(trade_volume);
+            resting_order.addFilledVolume(trade_volume);
+            level.total_volume -= trade_volume;
+            trades.push_back(Trade{
+                .buy_order_id = buyer ? order.getOrderId()
+                                      : resting_order.getOrderId(),
+                .sell_order_id = buyer ? resting_order.getOrderId()
+                                       : order.getOrderId(),
+                .price = book_.ticks_.ToPrice(tick),
+                .volume = trade_volume});
+
+            if (resting_order.isFilled()) {
+                if (added_orders_.erase(resting_order.getOrderId()) == 0) {
+                    removed_orders_.insert(resting_order.getOrderId());
+                }
+                owned_orders_.erase(&resting_order);
+                level.taken.pop_front();
+            } else if (resting_order.isIceberg() &&
+                       resting_order.getVisibleVolume() == 0) {
+                level.hidden_volume -= resting_order.replenishVisibleVolume();
+                level.appended.push_back(std::move(level.taken.front()));
+                level.taken.pop_front();
+            }
+        }
+    }
+}
+
+template <typename Touched, typename Levels>
+uint64_t BookFork::availableVolume(const Order& order, const Touched& touched,
+                                   const Levels& live) const {
+    // Volume a fill-or-kill order could reach within its limit
+    bool buyer = order.getSide() == BUY;
+    uint64_t available = 0;
+    visitLevels(touched, live, [&](Price tick, Volume total_volume) {
+        if (order.getOrderType() == LIMIT &&
+            (buyer ? tick > order.getPrice() : tick < order.getPrice())) {
+            return false;
+        }
+        available += total_volume;
+        return available < order.getRemainingVolume();
+    });
+    return available;
+}
+
+void BookFork::addOrder(const Order& order) {
+    auto order_ptr = make_shared<Order>(order);
+    if (order_ptr->isIceberg()) {
+        order_ptr->replenishVisibleVolume();
+    }
+    ForkLevel& level =
+        order.getSide() == BUY
+            ? touchLevel(buy_levels_, book_.buy_orders_by_price_,
+                         order.getPrice())
+            : touchLevel(sell_levels_, book_.sell_orders_by_price_,
+                         order.getPrice());
+    level.appended.push_back(order_ptr);
+    level.total_volume += order_ptr->getRemainingVolume();
+    level.hidden_volume += order_ptr->getHiddenVolume();
+    owned_orders_.insert(order_ptr.get());
+    added_orders_[order.getOrderId()] = order_ptr;
+}
+
+vector<Trade> BookFork::PlaceOrder(Order order) {
+    vector<Trade> trades;
+
+    // Same validation as the book; kinds the fork cannot follow are refused
+    last_reject_reason_ = book_.normalizePrices(order);
+    if (last_reject_reason_ == NOT_REJECTED) {
+        last_reject_reason_ = book_.applyTimeInForce(order);
+    }
+    if (last_reject_reason_ == NOT_REJECTED &&
+        (order.isPegged() || order.getOrderType() == STOP ||
+         order.getOrderType() == STOP_LIMIT)) {
+        last_reject_reason_ = NOT_SIMULATED;
+    }
+    if (last_reject_reason_ != NOT_REJECTED) {
+        return trades;
+    }
+
+    bool immediate =
+        order.getTimeInForce() == IOC || order.getTimeInForce() == FOK;
+    if (book_.in_auction_) {
+        // Orders accumulate without matching until the uncross; market
+        // orders are rejected, as in the book
+        if (order.getOrderType() == MARKET) {
+            last_reject_reason_ = MARKET_IN_AUCTION;
+            return trades;
+        }
+        if (order.getTimeInForce() == FOK) {
+            last_reject_reason_ = INSUFFICIENT_LIQUIDITY;
+        }
+        if (!immediate && order.getOrderType() == LIMIT) {
+            addOrder(order);
+        }
+        return trades;
+    }
+
+    if (order.getTimeInForce() == FOK &&
+        (order.getSide() == BUY
+             ? availableVolume(order, sell_levels_,
+                               book_.sell_orders_by_price_)
+             : availableVolume(order, buy_levels_,
+                               book_.buy_orders_by_price_)) <
+            order.getRemainingVolume()) {
+        last_reject_reason_ = INSUFFICIENT_LIQUIDITY;
+        return trades;
+    }
+
+    if (order.getSide() == BUY) {
+        matchAgainst(order, sell_levels_, book_.sell_orders_by_price_,
+                     trades);
+    } else {
+        matchAgainst(order, buy_levels_, book_.buy_orders_by_price_, trades);
+    }
+    if (!order.isFilled() && !immediate && order.getOrderType() == LIMIT) {
+        addOrder(order);
+    }
+    return trades;
+}
+
+template <typename Touched, typename Levels>
+bool BookFork::removeOrder(Touched& touched, const Levels& live, Price tick,
+                           OrderID order_id) {
+    ForkLevel& level = touchLevel(touched, live, tick);
+    auto matches = [&](const shared_ptr<Order>& o) {
+        return o->getOrderId() == order_id;
+    };
+    auto release = [&](const Order& order) {
+        level.total_volume -= order.getRemainingVolume();
+        level.hidden_volume -= order.getHiddenVolume();
+        owned_orders_.erase(&order);
+    };
+    for (deque<shared_ptr<Order>>* queue : {&level.taken, &level.appended}) {
+        auto it = ranges::find_if(*queue, matches);
+        if (it != queue->end()) {
+            release(**it);
+            queue->erase(it);
+            return true;
+        }
+    }
+
+    // A book order not taken yet stays in the book's queue; once it is
+    // marked removed, frontOrder skips it
+    if (level.live == nullptr) {
+        return false;
+    }
+    const auto& orders = level.live->orders;
+    auto it = find_if(orders.begin() + level.next, orders.end(), matches);
+    if (it == orders.end()) {
+        return false;
+    }
+    release(**it);
+    return true;
+}
+
+void BookFork::CancelOrder(OrderID orderId) {
+    // The fork's own orders first, then the book's displayed orders
+    const Order* order = nullptr;
+    auto added_it = added_orders_.find(orderId);
+    if (added_it != added_orders_.end()) {
+        order = added_it->second.get();
+    } else if (!removed_orders_.contains(orderId)) {
+        const shared_ptr<Order>* live = book_.orders_by_id_.Find(orderId);
+        if (live == nullptr || (*live)->isPegged()) {
+            return;
+        }
+        order = live->get();
+    }
+    if (order == nullptr) {
+        return;
+    }
+
+    Side side = order->getSide();
+    Price tick = order->getPrice();
+    bool removed =
+        side == BUY ? removeOrder(buy_levels_, book_.buy_orders_by_price_,
+                                  tick, orderId)
+                    : removeOrder(sell_levels_, book_.sell_orders_by_price_,
+                                  tick, orderId);
+    if (!removed) {
+        return;
+    }
+    if (added_orders_.erase(orderId) == 0) {
+        removed_orders_.insert(orderId);
+    }
+}
+
+void BookFork::Reset() {
+    buy_levels_.clear();
+    sell_levels_.clear();
+    owned_orders_.clear();
+    added_orders_.clear();
+    removed_orders_.clear();
+    copied_orders_ = 0;
+    taken_orders_ = 0;
+    last_reject_reason_ = NOT_REJECTED;
+}
+
+bool BookFork::ContainsOrder(OrderID orderId) const {
+    if (added_orders_.contains(orderId)) {
+        return true;
+    }
+    return !removed_orders_.contains(orderId) && book_.ContainsOrder(orderId);
+}
+
+RejectReason BookFork::GetLastRejectReason() const {
+    return last_reject_reason_;
+}
+
+Volume BookFork::GetVolumeAtPrice(Price price, Side side) const {
+    Price tick = 0;
+    if (book_.ticks_.ToTick(price, tick) != NOT_REJECTED) {
+        return 0;
+    }
+    if (side == BUY) {
+        auto it = buy_levels_.find(tick);
+        return it != buy_levels_.end() ? it->second.total_volume
+                                       : book_.GetVolumeAtPrice(price, side);
+    }
+    auto it = sell_levels_.find(tick);
+    return it != sell_levels_.end() ? it->second.total_volume
+                                    : book_.GetVolumeAtPrice(price, side);
+}
+
+size_t BookFork::GetTouchedLevelCount() const {
+    return buy_levels_.size() + sell_levels_.size();
+}
+
+size_t BookFork::GetCopiedOrderCount() const {
+    return copied_orders_;
+}
+
+size_t BookFork::GetTakenOrderCount() const {
+    return taken_orders_;
+}
@@ -0,0 +1,74 @@
+#include "common/Types.hpp"
+#include "matching_engine/ConsolidatedBbo.hpp"
+
+using namespace std;
+
+ConsolidatedBbo::ConsolidatedBbo(size_t books) : slots_(books) {}
+
+TopOfBookSlot& ConsolidatedBbo::GetSlot(size_t book) {
+    return slots_[book];
+}
+
+size_t ConsolidatedBbo::GetBookCount() const {
+    return slots_.size();
+}
+
+ConsolidatedQuote ConsolidatedBbo::GetBbo() const {
+    ConsolidatedQuote quote;
+    for (const TopOfBookSlot& slot : slots_) {
+        TopOfBook top = slot.Load();
+        if (top.in_auction) {
+            continue;
+        }
+
+        const TopLevel& bid = top.bids[0];
+        if (bid.volume != 0) {
+            if (quote.bid_books == 0 || bid.price > quote.bid_price) {
+                quote.bid_price = bid.price;
+                quote.bid_volume = 0;
+                quote.bid_books = 0;
+            }
+            if (bid.price == quote.bid_price) {
+                quote.bid_volume += bid.volume;
+                quote.bid_books++;
+            }
+        }
+
+        const TopLevel& ask = top.asks[0];
+        if (ask.volume != 0) {
+            if (quote.ask_books == 0 || ask.price < quote.ask_price) {
+                quote.ask_price = ask.price;
+                quote.ask_volume = 0;
+                quote.ask_books = 0;
+            }
+            if (ask.price == quote.ask_price) {
+                quote.ask_volume += ask.volume;
+                quote.ask_books++;
+            }
+        }
+    }
+    return quote;
+}
+
+uint64_t ConsolidatedBbo::GetVolumeAtPrice(Price price, Side side) const {
+    // Only the published levels are seen: a price deeper than
+    // kTopOfBookLevels into some book is missing that book's volume
+    uint64_t volume = 0;
+    for (const TopOfBookSlot& slot : slots_) {
+        TopOfBook top = slot.Load();
+        if (top.in_auction) {
+            continue;
+        }
+        for (const TopLevel& level : side == BUY ? top.bids : top.asks) {
+            if (level.volume != 0 && level.price == price) {
+                volume += level.volume;
+                break;
+            }
+        }
+    }
+    return volume;
+}
+
+TopOfBook ConsolidatedBbo::GetTopOfBook(size_t book) const {
+    return slots_[book].Load();
+}
@@ -0,0 +1,483 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "common/Types.hpp"
+#include "matching_engine/DropCopy.hpp"
+
+using namespace std;
+
+const uint32_t kDropCopyRecordSize = sizeof(DropCopyRecord);
+const size_t kDropCopyHeaderBytes =
+    sizeof(kDropCopyMagic) + sizeof(kDropCopyRecordSize);
+
+// How long the writer sleeps between drains of the ring
+const chrono::microseconds kDropCopyPollInterval(500);
+
+// Monotonic clock for the sync interval
+static uint64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Wall clock for the records, so they line up with other systems' logs
+static uint64_t wallClockNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+               chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+static bool syncFile(int fd) {
+#ifdef __APPLE__
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+// Writes all of data at offset, retrying short writes
+static bool writeFully(int fd, const char* data, size_t bytes,
+                       uint64_t offset) {
+    while (bytes > 0) {
+        ssize_t written = pwrite(fd, data, bytes, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        bytes -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+// io_uring over the raw system calls (no liburing), holding at most one
+// write and its linked data sync in flight
+#ifdef __linux__
+class UringFile {
+   private:
+    static const unsigned kEntries = 4;
+    static const uint64_t kWriteTag = 0;
+    static const uint64_t kSyncTag = 1;
+
+    int fd_;
+    int ring_fd_ = -1;
+    void* sq_ring_ = MAP_FAILED;
+    size_t sq_ring_bytes_ = 0;
+    void* cq_ring_ = MAP_FAILED;
+    size_t cq_ring_bytes_ = 0;
+    io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_bytes_ = 0;
+
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    // The write in flight
+    const char* data_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t offset_ = 0;
+    bool sync_ = false;
+    unsigned pending_ = 0;  // completions still to reap
+
+    template <typename T>
+    T* at(void* ring, unsigned offset) {
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+
+    io_uring_sqe* nextSqe() {
+        unsigned tail = *sq_tail_ + pending_;
+        unsigned index = tail & sq_mask_;
+        sq_array_[index] = index;
+        io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+   public:
+    explicit UringFile(int fd) : fd_(fd) {
+        io_uring_params params{};
+        ring_fd_ =
+            static_cast<int>(syscall(__NR_io_uring_setup, kEntries, &params));
+        if (ring_fd_ < 0) {
+            return;
+        }
+
+        sq_ring_bytes_ =
+            params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_bytes_ =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sq_ring_ = mmap(nullptr, sq_ring_bytes_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_SQ_RING);
+        cq_ring_ = mmap(nullptr, cq_ring_bytes_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_CQ_RING);
+        sqes_ = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqes_bytes_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+        if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED ||
+            sqes_ == MAP_FAILED) {
+            return;
+        }
+
+        sq_tail_ = at<unsigned>(sq_ring_, params.sq_off.tail);
+        sq_mask_ = *at<unsigned>(sq_ring_, params.sq_off.ring_mask);
+        sq_array_ = at<unsigned>(sq_ring_, params.sq_off.array);
+        cq_head_ = at<unsigned>(cq_ring_, params.cq_off.head);
+        cq_tail_ = at<unsigned>(cq_ring_, params.cq_off.tail);
+        cq_mask_ = *at<unsigned>(cq_ring_, params.cq_off.ring_mask);
+        cqes_ = at<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+    }
+
+    ~UringFile() {
+        Wait();
+        if (sqes_ != MAP_FAILED) {
+            munmap(sqes_, sqes_bytes_);
+        }
+        if (cq_ring_ != MAP_FAILED) {
+            munmap(cq_ring_, cq_ring_bytes_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            munmap(sq_ring_, sq_ring_bytes_);
+        }
+        if (ring_fd_ >= 0) {
+            close(ring_fd_);
+        }
+    }
+
+    UringFile(const UringFile&) = delete;
+    UringFile& operator=(const UringFile&) = delete;
+
+    bool IsOpen() const { return cqes_ != nullptr; }
+
+    // Starts writing data at offset, followed by a data sync if asked for.
+    // data must stay untouched until Wait returns.
+    bool Submit(const char* data, size_t bytes, uint64_t offset, bool sync) {
+        data_ = data;
+        bytes_ = bytes;
+        offset_ = offset;
+        sync_ = sync;
+
+        io_uring_sqe* write = nextSqe();
+        write->opcode = IORING_OP_WRITE;
+        write->fd = fd_;
+        write->addr = reinterpret_cast<uint64_t>(data);
+        write->len = static_cast<uint32_t>(bytes);
+        write->off = offset;
+        write->user_data = kWriteTag;
+        pending_ = 1;
+        if (sync) {
+            write->flags = IOSQE_IO_LINK;  // sync only after the write
+            io_uring_sqe* fsync = nextSqe();
+            fsync->opcode = IORING_OP_FSYNC;
+            fsync->fd = fd_;
+            fsync->fsync_flags = IORING_FSYNC_DATASYNC;
+            fsync->user_data = kSyncTag;
+            pending_ = 2;
+        }
+
+        unsigned tail = *sq_tail_;
+        atomic_ref<unsigned>(*sq_tail_).store(tail + pending_,
+                                              memory_order_release);
+        while (syscall(__NR_io_uring_enter, ring_fd_, pending_, 0, 0, nullptr,
+                       0) < 0) {
+            if (errno != EINTR) {
+                // Not submitted: take the entries back and write directly
+                atomic_ref<unsigned>(*sq_tail_).store(tail,
+                                                      memory_order_release);
+                pending_ = 0;
+                bytes_ = 0;
+                sync_ = false;
+                return writeFully(fd_, data, bytes, offset) &&
+                       (!sync || syncFile(fd_));
+            }
+        }
+        return true;
+    }
+
+    // Waits for the write in flight. A short or failed write is finished
+    // with pwrite, and a sync the kernel cancelled is redone.
+    bool Wait() {
+        bool written = true;
+        bool synced = true;
+        while (pending_ > 0) {
+            unsigned head = *cq_head_;
+            if (head ==
+                atomic_ref<unsigned>(*cq_tail_).load(memory_order_acquire)) {
+                syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                        IORING_ENTER_GETEVENTS, nullptr, 0);
+                continue;
+            }
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data == kWriteTag) {
+                size_t done = cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+                if (done < bytes_) {
+                    written = writeFully(fd_, data_ + done, bytes_ - done,
+                                         offset_ + done);
+                }
+            } else {
+                synced = cqe.res >= 0;
+            }
+            atomic_ref<unsigned>(*cq_head_).store(head + 1,
+                                                  memory_order_release);
+            pending_--;
+        }
+        if (sync_ && !synced) {
+            synced = syncFile(fd_);
+        }
+        sync_ = false;
+        bytes_ = 0;
+        return written && synced;
+    }
+};
+#else
+class UringFile {
+   public:
+    explicit UringFile(int) {}
+    bool IsOpen() const { return false; }
+    bool Submit(const char*, size_t, uint64_t, bool) { return false; }
+    bool Wait() { return true; }
+};
+#endif
+
+// Drop-copy writer implementations
+
+DropCopyWriter::DropCopyWriter(const string& path,
+                               const DropCopyOptions& options)
+    : options_(options) {
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        throw runtime_error("Cannot open drop-copy file " + path);
+    }
+
+    char header[kDropCopyHeaderBytes];
+    memcpy(header, kDropCopyMagic, sizeof(kDropCopyMagic));
+    memcpy(header + sizeof(kDropCopyMagic), &kDropCopyRecordSize,
+           sizeof(kDropCopyRecordSize));
+    if (!writeFully(fd_, header, sizeof(header), 0)) {
+        close(fd_);
+        throw runtime_error("Cannot write drop-copy file " + path);
+    }
+    file_offset_ = sizeof(header);
+
+    if (options_.use_io_uring) {
+        uring_ = make_unique<UringFile>(fd_);
+        io_uring_ = uring_->IsOpen();
+        if (!io_uring_) {
+            uring_.reset();
+        }
+    }
+    size_t batch_bytes =
+        max<size_t>(options_.batch_bytes / sizeof(DropCopyRecord), 1) *
+        sizeof(DropCopyRecord);
+    for (vector<char>& batch : batches_) {
+        batch.reserve(batch_bytes);
+    }
+    last_sync_ns_ = nowNs();
+    thread_ = thread([this]() { run(); });
+}
+
+DropCopyWriter::~DropCopyWriter() {
+    Close();
+}
+
+void DropCopyWriter::push(const Trade& trade, uint64_t timestamp) {
+    DropCopyRecord record{.sequence = ++sequence_,
+                          .timestamp_ns = timestamp,
+                          .buy_order_id = trade.buy_order_id,
+                          .sell_order_id = trade.sell_order_id,
+                          .price = trade.price,
+                          .volume = trade.volume};
+    while (!ring_->TryPush(record)) {
+        stalls_.fetch_add(1, memory_order_relaxed);
+        this_thread::yield();
+    }
+}
+
+void DropCopyWriter::Record(const Trade& trade) {
+    if (fd_ >= 0) {
+        push(trade, wallClockNs());
+    }
+}
+
+void DropCopyWriter::Record(const vector<Trade>& trades) {
+    if (trades.empty() || fd_ < 0) {
+        return;
+    }
+    uint64_t timestamp = wallClockNs();
+    for (const Trade& trade : trades) {
+        push(trade, timestamp);
+    }
+}
+
+uint64_t DropCopyWriter::GetSequence() const {
+    return sequence_;
+}
+
+void DropCopyWriter::run() {
+    // Drains the ring into the filling batch, writing the batch when it is
+    // full or its oldest fill has waited the flush interval, so writes stay
+    // large at any trade rate. Between drains the writer sleeps, so it does
+    // not compete with the matching thread for the core.
+    size_t batch_capacity = batches_[0].capacity();
+    uint64_t batch_start_ns = 0;
+    DropCopyRecord record;
+    while (true) {
+        // Seen before the drain, so the drain gets every recorded fill
+        bool closing = closing_.load(memory_order_acquire);
+        while (ring_->TryPop(record)) {
+            vector<char>& batch = batches_[filling_];
+            if (batch.empty()) {
+                batch_start_ns = nowNs();
+            }
+            const char* bytes = reinterpret_cast<const char*>(&record);
+            batch.insert(batch.end(), bytes, bytes + sizeof(record));
+            if (batch.size() + sizeof(record) > batch_capacity) {
+                writeBatch();
+            }
+        }
+
+        uint64_t now = nowNs();
+        if (!batches_[filling_].empty() &&
+            (closing || now - batch_start_ns >= options_.flush_interval_ns)) {
+            writeBatch();
+        }
+        if (closing) {
+            break;
+        }
+        if (unsynced_ && options_.sync == SYNC_INTERVAL &&
+            now - last_sync_ns_ >= options_.sync_interval_ns) {
+            finishWrite();
+            syncNow();
+        }
+        this_thread::sleep_for(kDropCopyPollInterval);
+    }
+
+    finishWrite();
+    if (unsynced_ && options_.sync != SYNC_NONE) {
+        syncNow();
+    }
+}
+
+void DropCopyWriter::writeBatch() {
+    vector<char>& batch = batches_[filling_];
+    uint64_t now = nowNs();
+    bool sync = options_.sync == SYNC_EVERY_BATCH ||
+                (options_.sync == SYNC_INTERVAL &&
+                 now - last_sync_ns_ >= options_.sync_interval_ns);
+
+    finishWrite();
+    if (uring_) {
+        // Written in the background while the other batch fills
+        if (!uring_->Submit(batch.data(), batch.size(), file_offset_, sync)) {
+            errors_.fetch_add(1, memory_order_relaxed);
+        }
+        in_flight_records_ = batch.size() / sizeof(DropCopyRecord);
+        filling_ ^= 1;
+    } else {
+        if (!writeFully(fd_, batch.data(), batch.size(), file_offset_) ||
+            (sync && !syncFile(fd_))) {
+            errors_.fetch_add(1, memory_order_relaxed);
+        }
+        records_.fetch_add(batch.size() / sizeof(DropCopyRecord),
+                           memory_order_relaxed);
+    }
+    file_offset_ += batch.size();
+    writes_.fetch_add(1, memory_order_relaxed);
+    if (sync) {
+        syncs_.fetch_add(1, memory_order_relaxed);
+        last_sync_ns_ = now;
+    }
+    unsynced_ = !sync;
+    batches_[filling_].clear();
+}
+
+void DropCopyWriter::finishWrite() {
+    if (!uring_ || in_flight_records_ == 0) {
+        return;
+    }
+    if (!uring_->Wait()) {
+        errors_.fetch_add(1, memory_order_relaxed);
+    }
+    records_.fetch_add(in_flight_records_, memory_order_relaxed);
+    in_flight_records_ = 0;
+}
+
+void DropCopyWriter::syncNow() {
+    if (!syncFile(fd_)) {
+        errors_.fetch_add(1, memory_order_relaxed);
+    }
+    syncs_.fetch_add(1, memory_order_relaxed);
+    last_sync_ns_ = nowNs();
+    unsynced_ = false;
+}
+
+void DropCopyWriter::Close() {
+    if (fd_ < 0) {
+        return;
+    }
+    closing_.store(true, memory_order_release);
+    thread_.join();
+    uring_.reset();
+    close(fd_);
+    fd_ = -1;
+}
+
+DropCopyStats DropCopyWriter::GetStats() const {
+    return DropCopyStats{.records = records_.load(memory_order_relaxed),
+                         .writes = writes_.load(memory_order_relaxed),
+                         .syncs = syncs_.load(memory_order_relaxed),
+                         .stalls = stalls_.load(memory_order_relaxed),
+                         .errors = errors_.load(memory_order_relaxed),
+                         .io_uring = io_uring_};
+}
+
+vector<DropCopyRecord> ReadDropCopy(const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw runtime_error("Cannot open drop-copy file " + path);
+    }
+
+    char magic[sizeof(kDropCopyMagic)];
+    uint32_t record_size = 0;
+    bool valid = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 memcmp(magic, kDropCopyMagic, sizeof(magic)) == 0 &&
+                 fread(&record_size, sizeof(record_size), 1, file) == 1 &&
+                 record_size == kDropCopyRecordSize;
+    if (!valid) {
+        fclose(file);
+        throw runtime_error("Not a drop-copy file: " + path);
+    }
+
+    // A record cut short by a crash mid-write is left out
+    vector<DropCopyRecord> records;
+    DropCopyRecord record;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        records.push_back(record);
+    }
+    fclose(file);
+    return records;
+}
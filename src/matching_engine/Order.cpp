@@ -1,6 +1,10 @@
+#include <algorithm>
+
 #include "matching_engine/Order.hpp"
 #include "common/Types.hpp"
 
+using namespace std;
+
 // Constructor implementations
 
 Order::Order() = default;
@@ -13,7 +17,18 @@ Order::Order(OrderID order_id, Side side, OrderType order_type, Price price,
       price_(price),
       volume_(volume),
       filled_volume_(0),
-      cancel_order_id_(cancel_order_id) {}
+      cancel_order_id_(cancel_order_id),
+      trigger_price_(0),
+      peak_volume_(0),
+      visible_volume_(0),
+      time_in_force_(GTC),
+      peg_type_(NO_PEG),
+      peg_offset_(0),
+      participant_id_(0),
+      expire_time_(0),
+      queue_volume_mark_(0),
+      queue_order_mark_(0),
+      queue_watched_(false) {}
 
 // Getter method implementations
 
@@ -49,16 +64,117 @@ OrderID Order::getCancelOrderId() const {
     return cancel_order_id_;
 }
 
+Price Order::getTriggerPrice() const {
+    return trigger_price_;
+}
+
+Volume Order::getPeakVolume() const {
+    return peak_volume_;
+}
+
+Volume Order::getVisibleVolume() const {
+    return isIceberg() ? visible_volume_ : getRemainingVolume();
+}
+
+Volume Order::getHiddenVolume() const {
+    return getRemainingVolume() - getVisibleVolume();
+}
+
+TimeInForce Order::getTimeInForce() const {
+    return time_in_force_;
+}
+
+Timestamp Order::getExpireTime() const {
+    return expire_time_;
+}
+
+PegType Order::getPegType() const {
+    return peg_type_;
+}
+
+Price Order::getPegOffset() const {
+    return peg_offset_;
+}
+
+ParticipantID Order::getParticipantId() const {
+    return participant_id_;
+}
+
+bool Order::isIceberg() const {
+    return peak_volume_ != 0;
+}
+
+bool Order::isPegged() const {
+    return peg_type_ != NO_PEG;
+}
+
 bool Order::isFilled() const {
     return filled_volume_ >= volume_;
 }
 
+uint64_t Order::getQueueVolumeMark() const {
+    return queue_volume_mark_;
+}
+
+uint64_t Order::getQueueOrderMark() const {
+    return queue_order_mark_;
+}
+
+bool Order::isQueueWatched() const {
+    return queue_watched_;
+}
+
 // Setter method implementations
 
+void Order::setPrice(Price price) {
+    price_ = price;
+}
+
 void Order::setVolume(Volume volume) {
     volume_ = volume;
 }
 
 void Order::addFilledVolume(Volume volume) {
     filled_volume_ += volume;
-}
\ No newline at end of file
+    visible_volume_ -= min(volume, visible_volume_);
+}
+
+void Order::setTriggerPrice(Price trigger_price) {
+    trigger_price_ = trigger_price;
+}
+
+void Order::setPeakVolume(Volume peak_volume) {
+    peak_volume_ = peak_volume;
+    visible_volume_ = min(peak_volume_, getRemainingVolume());
+}
+
+void Order::setTimeInForce(TimeInForce time_in_force, Timestamp expire_time) {
+    time_in_force_ = time_in_force;
+    expire_time_ = expire_time;
+}
+
+void Order::setPeg(PegType peg_type, Price peg_offset) {
+    peg_type_ = peg_type;
+    peg_offset_ = peg_offset;
+}
+
+void Order::setParticipantId(ParticipantID participant_id) {
+    participant_id_ = participant_id;
+}
+
+Volume Order::replenishVisibleVolume() {
+    // Show a fresh slice from the hidden reserve, returns the amount shown
+    Volume replenished = min(peak_volume_, getRemainingVolume());
+    Volume added = replenished - visible_volume_;
+    visible_volume_ = replenished;
+    return added;
+}
+
+void Order::setQueueMarks(uint64_t volume_mark, uint64_t order_mark) {
+    queue_volume_mark_ = volume_mark;
+    queue_order_mark_ = order_mark;
+}
+
+void Order::setQueueWatched(bool watched) {
+    queue_watched_ = watched;
+}
@@ -1,5 +1,9 @@
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "common/Types.hpp"
@@ -8,87 +12,355 @@
 
 using namespace std;
 
-OrderBook::OrderBook() = default;
+// Allocation layout assumed by GetMemoryUsage (libstdc++): red-black tree and
+// hash nodes carry their link pointers, deques allocate fixed 512-byte chunks
+// plus a chunk pointer map, make_shared puts a two-counter control block with
+// a vtable pointer in front of the order
+const size_t kTreeNodeLinkBytes = 4 * sizeof(void*);
+const size_t kHashNodeLinkBytes = sizeof(void*);
+const size_t kDequeChunkBytes = 512;
+const size_t kDequeMinMapSlots = 8;
+const size_t kOrderRecordBytes = sizeof(Order) + 2 * sizeof(void*);
 
-vector<Trade> OrderBook::matchOrder(Order& order) {
-    vector<Trade> trades;
+// Heap bytes of an order queue: {slots in use, idle slack}
+static pair<size_t, size_t> queueBytes(const deque<shared_ptr<Order>>& queue) {
+    const size_t slot_bytes = sizeof(shared_ptr<Order>);
+    size_t chunks = queue.size() * slot_bytes / kDequeChunkBytes + 1;
+    size_t map_bytes = max(kDequeMinMapSlots, chunks + 2) * sizeof(void*);
+    size_t used = queue.size() * slot_bytes;
+    return {used, chunks * kDequeChunkBytes - used + map_bytes};
+}
+static pair<size_t, size_t> queueBytes(
+    const RingDeque<shared_ptr<Order>>& queue) {
+    const size_t slot_bytes = sizeof(shared_ptr<Order>);
+    return {queue.size() * slot_bytes,
+            (queue.capacity() - queue.size()) * slot_bytes};
+}
 
-    if (order.getSide() == BUY) {
-        // Match against sell orders
-        auto& opposite_book = sell_orders_by_price_;
+// The order queue of a price level or of a stop trigger level
+template <typename Queue>
+static const Queue& queueOf(const BasicPriceLevel<Queue>& level) {
+    return level.orders;
+}
+static const deque<shared_ptr<Order>>& queueOf(
+    const deque<shared_ptr<Order>>& stops) {
+    return stops;
+}
 
-        while (!order.isFilled() && !opposite_book.empty()) {
-            // Get best price level from opposite side
-            auto& [price, orders_at_price] = *opposite_book.begin();
+// The level at a price, or nullptr
+template <typename Levels>
+static auto findLevel(Levels& book, Price price)
+    -> decltype(&book.begin()->second) {
+    auto level_it = book.find(price);
+    return level_it == book.end() ? nullptr : &level_it->second;
+}
 
-            // Check if prices are matchable
-            if (!canMatch(order, price)) {
-                break;
-            }
+template <typename MatchingPolicy, typename Containers>
+BasicOrderBook<MatchingPolicy, Containers>::BasicOrderBook() = default;
 
-            // Get front order from queue
-            shared_ptr<Order> resting_order = orders_at_price.front();
+template <typename MatchingPolicy, typename Containers>
+BasicOrderBook<MatchingPolicy, Containers>::BasicOrderBook(
+    const InstrumentConfig& config)
+    : ticks_(config) {}
 
-            // Execute trade
-            Trade trade = executeMatch(order, *resting_order);
-            trades.push_back(trade);
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::executeOrder(
+    Order& order, vector<Trade>& trades, bool expiry_scheduled) {
+    size_t first_trade = trades.size();
 
-            // If resting order is filled, remove from book + hashmap
-            if (resting_order->isFilled()) {
-                orders_at_price.pop_front();
-                orders_by_id_.erase(resting_order->getOrderId());
+    // A pegged order matches at its current peg price; without a reference
+    // yet it can only rest
+    bool can_match = true;
+    if (order.isPegged()) {
+        Price peg_price = 0;
+        can_match = pegPrice(order.getSide(), order.getPegType(),
+                             order.getPegOffset(), peg_price);
+        order.setPrice(peg_price);
+    }
 
-                if (orders_at_price.empty()) {
-                    opposite_book.erase(opposite_book.begin());
-                }
-            }
+    // Fill-or-kill decides from the level aggregates before touching the book
+    TimeInForce time_in_force = order.getTimeInForce();
+    if (time_in_force == FOK) {
+        bool limited = order.getOrderType() == LIMIT;
+        if (!can_match ||
+            availableVolume(order.getSide(), limited, order.getPrice(),
+                            order.getRemainingVolume()) <
+                order.getRemainingVolume()) {
+            last_reject_reason_ = INSUFFICIENT_LIQUIDITY;
+            return;
+        }
+    }
+
+    // Match the order against opposite side
+    if (can_match) {
+        matchOrder(order, trades);
+    }
+
+    // If limit order has remaining volume, add to book + hashmap (IOC and
+    // FOK orders drop whatever is left)
+    if (!order.isFilled() && order.getOrderType() == LIMIT &&
+        time_in_force != IOC && time_in_force != FOK) {
+        if (order.isPegged()) {
+            addPeggedOrder(order);
+        } else {
+            addOrderToBook(order, expiry_scheduled);
         }
+    }
+
+    // Arm any stops the new trades have reached
+    triggerStops(trades, first_trade);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::matchOrder(
+    Order& order, vector<Trade>& trades) {
+    if (order.getSide() == BUY) {
+        // Match against sell orders
+        matchAgainst(order, sell_orders_by_price_, trades);
     } else {
         // Match against buy orders
-        auto& opposite_book = buy_orders_by_price_;
+        matchAgainst(order, buy_orders_by_price_, trades);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels>
+void BasicOrderBook<MatchingPolicy, Containers>::matchAgainst(
+    Order& order, Levels& opposite_book, vector<Trade>& trades) {
+    size_t first_trade = trades.size();
+    Side resting_side = order.getSide() == BUY ? SELL : BUY;
+    while (!order.isFilled()) {
+        // Pegged orders trade ahead of the displayed level only at a strictly
+        // better price; at the same price the displayed orders go first
+        Price peg_price = 0;
+        PegLevels* pegs = bestPegLevels(resting_side, peg_price);
+        if (pegs != nullptr &&
+            (opposite_book.empty() ||
+             opposite_book.key_comp()(peg_price,
+                                      opposite_book.begin()->first))) {
+            if (!canMatch(order, peg_price)) {
+                break;
+            }
+            matchPegged(order, *pegs, peg_price, first_trade, trades);
+            continue;
+        }
+        if (opposite_book.empty()) {
+            break;
+        }
+
+        // Get best price level from opposite side
+        auto level_it = opposite_book.begin();
+        auto& [price, level] = *level_it;
 
-        while (!order.isFilled() && !opposite_book.empty()) {
-            // Get best price level from opposite side
-            auto& [price, orders_at_price] = *opposite_book.begin();
+        // Check if prices are matchable
+        if (!canMatch(order, price)) {
+            break;
+        }
 
-            // Check if prices are matchable
-            if (!canMatch(order, price)) {
+        // A pro-rata level shares out an order smaller than its displayed
+        // volume; an order that takes the whole level fills it in time order
+        if constexpr (MatchingPolicy::kFifoPercent < 100) {
+            if (order.getRemainingVolume() <
+                level.total_volume - level.hidden_volume) {
+                allocateLevel(order, level_it, first_trade, trades);
                 break;
             }
+        }
 
-            // Get front order from queue
-            shared_ptr<Order> resting_order = orders_at_price.front();
+        // Get front order from queue
+        Order& resting_order = *level.orders.front();
+        state_hash_ -= orderHash(resting_order) +
+                       levelHash(resting_order.getSide(), price, level);
 
-            // Execute trade
-            Trade trade = executeMatch(order, *resting_order);
-            trades.push_back(trade);
+        // Execute trade at the resting order's price, against its displayed
+        // volume only (an iceberg's reserve is shown slice by slice)
+        Volume trade_volume = min(order.getRemainingVolume(),
+                                  resting_order.getVisibleVolume());
+        Trade trade = executeMatch(order, resting_order, price, trade_volume);
+        level.total_volume -= trade.volume;
+        level.departed_volume += trade.volume;
+        reportFill(order, trade, first_trade, trades);
 
-            // If resting order is filled, remove from book + hashmap
-            if (resting_order->isFilled()) {
-                orders_by_id_.erase(resting_order->getOrderId());
-                orders_at_price.pop_front();
+        settleFrontOrder(opposite_book, level_it);
+    }
+}
 
-                if (orders_at_price.empty()) {
-                    opposite_book.erase(opposite_book.begin());
-                }
+template <typename MatchingPolicy, typename Containers>
+template <typename LevelIterator>
+void BasicOrderBook<MatchingPolicy, Containers>::allocateLevel(
+    Order& order, LevelIterator level_it, size_t first_trade,
+    vector<Trade>& trades) {
+    auto& [price, level] = *level_it;
+    Side side = level.orders.front()->getSide();
+    size_t count = level.orders.size();
+    uint64_t volume = order.getRemainingVolume();
+    state_hash_ -= levelHash(side, price, level) + queueHash(level);
+
+    // Gather the displayed sizes into contiguous arrays, taking the FIFO
+    // share (if any) off the oldest orders on the way
+    prorata_sizes_.resize(count);
+    prorata_shares_.resize(count);
+    prorata_allocations_.assign(count, 0);
+    uint64_t fifo_volume = volume * MatchingPolicy::kFifoPercent / 100;
+    uint64_t allocated = 0;
+    uint64_t pro_rata_total = 0;
+    for (size_t i = 0; i < count; i++) {
+        Volume visible = level.orders[i]->getVisibleVolume();
+        auto fifo = static_cast<Volume>(
+            min<uint64_t>(visible, fifo_volume - allocated));
+        prorata_allocations_[i] = fifo;
+        prorata_sizes_[i] = visible - fifo;
+        allocated += fifo;
+        pro_rata_total += visible - fifo;
+    }
+
+    // Pro-rata shares of the rest, then rounding leftovers in time priority
+    ComputeProRataShares(prorata_sizes_.data(), prorata_shares_.data(), count,
+                         static_cast<Volume>(volume - allocated),
+                         pro_rata_total);
+    for (size_t i = 0; i < count; i++) {
+        auto share = static_cast<Volume>(prorata_shares_[i]);
+        prorata_allocations_[i] += share;
+        allocated += share;
+    }
+    for (size_t i = 0; i < count && allocated < volume; i++) {
+        auto spare = static_cast<Volume>(prorata_sizes_[i]) -
+                     static_cast<Volume>(prorata_shares_[i]);
+        auto extra =
+            static_cast<Volume>(min<uint64_t>(spare, volume - allocated));
+        prorata_allocations_[i] += extra;
+        allocated += extra;
+    }
+
+    // Execute in time priority, then drop filled orders and re-queue
+    // icebergs that showed a new slice, keeping everyone else in place
+    prorata_requeued_.clear();
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        shared_ptr<Order>& resting_order = level.orders[i];
+        if (prorata_allocations_[i] != 0) {
+            state_hash_ -= orderHash(*resting_order);
+            Trade trade = executeMatch(order, *resting_order, price,
+                                       prorata_allocations_[i]);
+            level.total_volume -= trade.volume;
+            reportFill(order, trade, first_trade, trades);
+
+            if (resting_order->isFilled()) {
+                orders_by_id_.Erase(resting_order->getOrderId());
+                level.watched -= resting_order->isQueueWatched();
+                continue;
             }
+            if (resting_order->isIceberg() &&
+                resting_order->getVisibleVolume() == 0) {
+                level.hidden_volume -= resting_order->replenishVisibleVolume();
+                state_hash_ += orderHash(*resting_order);
+                prorata_requeued_.push_back(std::move(resting_order));
+                continue;
+            }
+            state_hash_ += orderHash(*resting_order);
+        }
+        if (kept != i) {
+            level.orders[kept] = std::move(resting_order);
         }
+        kept++;
     }
+    level.orders.resize(kept);
+    ranges::move(prorata_requeued_, back_inserter(level.orders));
+    prorata_requeued_.clear();
 
-    return trades;
+    // Fills anywhere in the queue: recount every position
+    rebaseQueue(level);
+    noteQueueMoved(side, price, level);
+
+    // The order was smaller than the level, so the level survives
+    state_hash_ += levelHash(side, price, level) + queueHash(level);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::reportFill(
+    const Order& order, const Trade& trade, size_t first_trade,
+    vector<Trade>& trades) {
+    if (report_mode_ == PER_ORDER_REPORTS) {
+        trades.push_back(trade);
+        return;
+    }
+
+    // The aggressor sees one print per level (prices only get worse, so a
+    // new price means a new level); each resting order's fill goes to the
+    // passive channel
+    passive_fills_.push_back(trade);
+    if (trades.size() > first_trade && trades.back().price == trade.price) {
+        trades.back().volume += trade.volume;
+    } else {
+        bool buyer = order.getSide() == BUY;
+        trades.push_back(Trade{
+            .buy_order_id = buyer ? order.getOrderId() : kConflatedOrderId,
+            .sell_order_id = buyer ? kConflatedOrderId : order.getOrderId(),
+            .price = trade.price,
+            .volume = trade.volume});
+    }
 }
 
-Trade OrderBook::executeMatch(Order& incoming_order, Order& resting_order) {
-    // Determine trade volume
-    Volume trade_volume = min(incoming_order.getRemainingVolume(),
-                              resting_order.getRemainingVolume());
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels>
+void BasicOrderBook<MatchingPolicy, Containers>::settleFrontOrder(
+    Levels& book, typename Levels::iterator level_it) {
+    auto& [price, level] = *level_it;
+    shared_ptr<Order>& resting_order = level.orders.front();
+    Side side = resting_order->getSide();
+    noteQueueMoved(side, price, level);
+
+    if (resting_order->isFilled()) {
+        // If resting order is filled, remove from book + hashmap
+        orders_by_id_.Erase(resting_order->getOrderId());
+        level.watched -= resting_order->isQueueWatched();
+        if (level.orders.size() > 1) {
+            state_hash_ -= linkHash(*resting_order, *level.orders[1]);
+        }
+        level.orders.pop_front();
+        level.departed_orders++;
+
+        // If no more orders at this price, remove the price level
+        if (level.orders.empty()) {
+            book.erase(level_it);
+            return;
+        }
+    } else {
+        // An iceberg whose shown slice is used up shows a new slice from its
+        // reserve and re-queues at the back, reusing the same order record
+        Order& order = *resting_order;
+        if (order.isIceberg() && order.getVisibleVolume() == 0) {
+            level.hidden_volume -= order.replenishVisibleVolume();
+            // It leaves the front and joins behind everyone else
+            level.departed_orders++;
+            Volume displayed = level.total_volume - level.hidden_volume;
+            order.setQueueMarks(
+                level.departed_volume + displayed - order.getVisibleVolume(),
+                level.departed_orders + level.orders.size() - 1);
+            size_t count = level.orders.size();
+            if (count > 1) {
+                state_hash_ += linkHash(*level.orders[count - 1], order) -
+                               linkHash(order, *level.orders[1]);
+            }
+            level.orders.push_back(std::move(resting_order));
+            level.orders.pop_front();
+        }
+        state_hash_ += orderHash(order);
+    }
 
-    // Determine trade price (use resting order price)
-    Price trade_price = resting_order.getPrice();
+    // Re-add the level's (and surviving order's) share of the state hash
+    state_hash_ += levelHash(side, price, level);
+}
 
+template <typename MatchingPolicy, typename Containers>
+Trade BasicOrderBook<MatchingPolicy, Containers>::executeMatch(
+    Order& incoming_order, Order& resting_order, Price trade_price,
+    Volume trade_volume) {
     // Update filled volumes
     incoming_order.addFilledVolume(trade_volume);
     resting_order.addFilledVolume(trade_volume);
+    last_trade_price_ = trade_price;
+    trade_stats_.RecordTrade(now_, ticks_.ToPrice(trade_price), trade_volume);
 
     // Create and return Trade record
     Trade trade{.buy_order_id = (incoming_order.getSide() == BUY)
@@ -103,7 +375,9 @@ Trade OrderBook::executeMatch(Order& incoming_order, Order& resting_order) {
     return trade;
 }
 
-bool OrderBook::canMatch(const Order& incoming, Price resting_price) const {
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::canMatch(
+    const Order& incoming, Price resting_price) const {
     if (incoming.getOrderType() == MARKET) {
         return true;
     }
@@ -115,42 +389,206 @@ bool OrderBook::canMatch(const Order& incoming, Price resting_price) const {
     }
 }
 
-void OrderBook::addOrderToBook(const Order& order) {
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::addOrderToBook(
+    const Order& order, bool expiry_scheduled) {
     // Create a shared pointer for the order
     auto order_ptr = make_shared<Order>(order);
 
-    // Add to appropriate book based on side
-    if (order.getSide() == BUY) {
-        buy_orders_by_price_[order.getPrice()].push_back(order_ptr);
-    } else {
-        sell_orders_by_price_[order.getPrice()].push_back(order_ptr);
+    // An iceberg rests with a full slice shown, whatever it filled on entry
+    if (order_ptr->isIceberg()) {
+        order_ptr->replenishVisibleVolume();
     }
 
+    // Add to appropriate book based on side
+    linkOrder(order_ptr);
+    state_hash_ += orderHash(*order_ptr);
+
     // Add to hashmap
-    orders_by_id_[order.getOrderId()] = order_ptr;
+    orders_by_id_.Insert(order.getOrderId(), order_ptr);
+    if (!expiry_scheduled) {
+        scheduleExpiry(order);
+    }
 }
 
-vector<Trade> OrderBook::PlaceOrder(Order order) {
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::linkOrder(
+    const shared_ptr<Order>& order) {
+    // Queues an order record at the back of its price level
+    Side side = order->getSide();
+    Price price = order->getPrice();
+    Level& level = (side == BUY) ? buy_orders_by_price_[price]
+                                      : sell_orders_by_price_[price];
+    state_hash_ -= levelHash(side, price, level);
+    order->setQueueMarks(
+        level.departed_volume + level.total_volume - level.hidden_volume,
+        level.departed_orders + level.orders.size());
+    level.watched += order->isQueueWatched();
+    if (!level.orders.empty()) {
+        state_hash_ +=
+            linkHash(*level.orders[level.orders.size() - 1], *order);
+    }
+    level.orders.push_back(order);
+    level.total_volume += order->getRemainingVolume();
+    level.hidden_volume += order->getHiddenVolume();
+    state_hash_ += levelHash(side, price, level);
+}
 
-    // Match the order against opposite side
-    vector<Trade> trades = matchOrder(order);
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels>
+void BasicOrderBook<MatchingPolicy, Containers>::unlinkOrder(
+    Levels& book, const Order& order) {
+    // Takes an order record off its price level (the ID index is untouched)
+    auto level_it = book.find(order.getPrice());
+    if (level_it == book.end()) {
+        return;
+    }
+    Level& level = level_it->second;
+    state_hash_ -= levelHash(order.getSide(), level_it->first, level);
+    noteQueueMoved(order.getSide(), level_it->first, level);
+    eraseQueued(level, order);
+    level.total_volume -= order.getRemainingVolume();
+    level.hidden_volume -= order.getHiddenVolume();
+    state_hash_ += levelHash(order.getSide(), level_it->first, level);
+    if (level.orders.empty()) {
+        book.erase(level_it);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+RejectReason BasicOrderBook<MatchingPolicy, Containers>::normalizePrices(
+    Order& order) const {
+    OrderType type = order.getOrderType();
+    Price tick = 0;
+
+    // A pegged order's price comes from the reference, not the message
+    if (order.isPegged()) {
+        return type == LIMIT && !order.isIceberg() ? NOT_REJECTED
+                                                   : INVALID_PEG;
+    }
+
+    if (type == LIMIT || type == STOP_LIMIT) {
+        RejectReason reason = ticks_.ToTick(order.getPrice(), tick);
+        if (reason != NOT_REJECTED) {
+            return reason;
+        }
+        order.setPrice(tick);
+    }
+    if (type == STOP || type == STOP_LIMIT) {
+        RejectReason reason = ticks_.ToTick(order.getTriggerPrice(), tick);
+        if (reason != NOT_REJECTED) {
+            return reason;
+        }
+        order.setTriggerPrice(tick);
+    }
+
+    return NOT_REJECTED;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::toExternalPrices(
+    vector<Trade>& trades) const {
+    if (ticks_.IsIdentity()) {
+        return;
+    }
+    for (Trade& trade : trades) {
+        trade.price = ticks_.ToPrice(trade.price);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<Trade> BasicOrderBook<MatchingPolicy, Containers>::PlaceOrder(
+    Order order) {
+    vector<Trade> trades;
 
-    // If limit order has remaining volume, add to book + hashmap
-    if (!order.isFilled() && order.getOrderType() == LIMIT) {
-        addOrderToBook(order);
+    // Prices enter the book as tick indices; off-grid orders are rejected
+    last_reject_reason_ = normalizePrices(order);
+    if (last_reject_reason_ == NOT_REJECTED) {
+        last_reject_reason_ = applyTimeInForce(order);
+    }
+    if (last_reject_reason_ != NOT_REJECTED) {
+        return trades;
     }
 
+    placeOrder(order, trades);
+    toExternalPrices(trades);
+    trade_stats_.Publish();
+    publishTopOfBook();
+    publishQueuePositions();
     return trades;
 }
 
-void OrderBook::CancelOrder(OrderID orderId) {
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::placeOrder(
+    Order& order, vector<Trade>& trades) {
+    // Stop orders wait in the trigger book instead of matching
+    if (order.getOrderType() == STOP || order.getOrderType() == STOP_LIMIT) {
+        if (!order.isFilled()) {
+            addStopOrder(order);
+        }
+        if (!in_auction_) {
+            processTriggeredStops(trades);
+            repricePegs(trades);
+        }
+        return;
+    }
+
+    // During a call auction orders accumulate without matching; IOC and FOK
+    // orders have nothing to fill against until the uncross, and market
+    // orders, which have no price to queue at, are rejected
+    if (in_auction_) {
+        if (order.getOrderType() == MARKET) {
+            last_reject_reason_ = MARKET_IN_AUCTION;
+            return;
+        }
+        if (order.getTimeInForce() == FOK) {
+            last_reject_reason_ = INSUFFICIENT_LIQUIDITY;
+        }
+        if (order.getTimeInForce() == IOC || order.getTimeInForce() == FOK) {
+            return;
+        }
+        if (!order.isFilled() && order.isPegged()) {
+            addPeggedOrder(order);
+        } else if (!order.isFilled() && order.getOrderType() == LIMIT) {
+            addOrderToBook(order);
+        }
+        return;
+    }
+
+    // Stops triggered by earlier messages go ahead of this order, then the
+    // order itself, then whatever it triggers (each bounded by the budget)
+    processTriggeredStops(trades);
+    executeOrder(order, trades);
+    processTriggeredStops(trades);
+
+    // The pegged orders move with the BBO this message left behind
+    repricePegs(trades);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::CancelOrder(OrderID orderId) {
     // Find the order in the hashmap
-    auto it = orders_by_id_.find(orderId);
-    if (it == orders_by_id_.end()) {
+    const shared_ptr<Order>* found = orders_by_id_.Find(orderId);
+    if (found == nullptr) {
         // Order not found
         return;
     }
-    shared_ptr<Order> order = it->second;
+    shared_ptr<Order> order = *found;
+    state_hash_ -= orderHash(*order);
+
+    // Stop orders live in the trigger book, not on the price levels
+    if (order->getOrderType() == STOP || order->getOrderType() == STOP_LIMIT) {
+        cancelStopOrder(*order);
+        orders_by_id_.Erase(orderId);
+        return;
+    }
+
+    // Pegged orders have their own levels and never move the reference
+    if (order->isPegged()) {
+        cancelPeggedOrder(*order);
+        orders_by_id_.Erase(orderId);
+        return;
+    }
 
     Price price = order->getPrice();
     Side side = order->getSide();
@@ -160,11 +598,13 @@ void OrderBook::CancelOrder(OrderID orderId) {
         auto book_it = buy_orders_by_price_.find(price);
         if (book_it != buy_orders_by_price_.end()) {
             // Remove order from deque at this price level
-            auto& orders_at_price = book_it->second;
-            erase_if(orders_at_price,
-                     [orderId](const shared_ptr<Order>& current_order) {
-                         return current_order->getOrderId() == orderId;
-                     });
+            auto& orders_at_price = book_it->second.orders;
+            state_hash_ -= levelHash(side, price, book_it->second);
+            noteQueueMoved(side, price, book_it->second);
+            eraseQueued(book_it->second, *order);
+            book_it->second.total_volume -= order->getRemainingVolume();
+            book_it->second.hidden_volume -= order->getHiddenVolume();
+            state_hash_ += levelHash(side, price, book_it->second);
 
             // If no more orders at this price, remove the price level
             if (orders_at_price.empty()) {
@@ -175,11 +615,13 @@ void OrderBook::CancelOrder(OrderID orderId) {
         auto book_it = sell_orders_by_price_.find(price);
         if (book_it != sell_orders_by_price_.end()) {
             // Remove order from deque at this price level
-            auto& orders_at_price = book_it->second;
-            erase_if(orders_at_price,
-                     [orderId](const shared_ptr<Order>& current_order) {
-                         return current_order->getOrderId() == orderId;
-                     });
+            auto& orders_at_price = book_it->second.orders;
+            state_hash_ -= levelHash(side, price, book_it->second);
+            noteQueueMoved(side, price, book_it->second);
+            eraseQueued(book_it->second, *order);
+            book_it->second.total_volume -= order->getRemainingVolume();
+            book_it->second.hidden_volume -= order->getHiddenVolume();
+            state_hash_ += levelHash(side, price, book_it->second);
 
             // If no more orders at this price, remove the price level
             if (orders_at_price.empty()) {
@@ -189,57 +631,1672 @@ void OrderBook::CancelOrder(OrderID orderId) {
     }
 
     // Remove from hashmap
-    orders_by_id_.erase(it);
+    orders_by_id_.Erase(orderId);
+    updatePegReference();
+    publishTopOfBook();
+    publishQueuePositions();
+}
+
+template <typename MatchingPolicy, typename Containers>
+RangeCancelReport BasicOrderBook<MatchingPolicy, Containers>::CancelRange(
+    Side side, Price from_price, Price to_price) {
+    // Inclusive range in either order; bounds need not be on the tick grid
+    Price low = min(from_price, to_price);
+    Price high = max(from_price, to_price);
+    return cancelTickRange(side, ticks_.CeilTick(low), ticks_.FloorTick(high));
 }
 
-bool OrderBook::ContainsOrder(OrderID orderId) const {
-    return orders_by_id_.contains(orderId);
+template <typename MatchingPolicy, typename Containers>
+RangeCancelReport BasicOrderBook<MatchingPolicy, Containers>::CancelWorseThan(
+    Side side, Price price) {
+    // Worse means strictly lower for bids and strictly higher for asks
+    const InstrumentConfig& config = ticks_.GetConfig();
+    if (side == BUY) {
+        if (price > config.max_price) {
+            return cancelTickRange(BUY, 0, UINT32_MAX);
+        }
+        Price first_kept = ticks_.CeilTick(price);
+        if (first_kept == 0) {
+            return {};
+        }
+        return cancelTickRange(BUY, 0, first_kept - 1);
+    }
+
+    if (price < config.min_price) {
+        return cancelTickRange(SELL, 0, UINT32_MAX);
+    }
+    if (price >= config.max_price) {
+        return {};  // no ask can be worse; the next tick would wrap
+    }
+    return cancelTickRange(SELL, ticks_.FloorTick(price) + 1, UINT32_MAX);
 }
 
-Volume OrderBook::GetVolumeAtPrice(Price price, Side side) const {
-    // Initialize total volume
-    Volume total_volume = 0;
+template <typename MatchingPolicy, typename Containers>
+RangeCancelReport BasicOrderBook<MatchingPolicy, Containers>::cancelTickRange(
+    Side side, Price low_tick, Price high_tick) {
+    RangeCancelReport report;
+    if (low_tick > high_tick) {
+        return report;
+    }
 
+    // Each side's map is ordered best first, so the range is contiguous
     if (side == BUY) {
-        auto it = buy_orders_by_price_.find(price);
-        if (it != buy_orders_by_price_.end()) {
-            const auto& orders_at_price = it->second;
-            for (const auto& order : orders_at_price) {
-                total_volume += order->getRemainingVolume();
+        cancelLevels(buy_orders_by_price_,
+                     buy_orders_by_price_.lower_bound(high_tick),
+                     buy_orders_by_price_.upper_bound(low_tick), BUY, report);
+    } else {
+        cancelLevels(sell_orders_by_price_,
+                     sell_orders_by_price_.lower_bound(low_tick),
+                     sell_orders_by_price_.upper_bound(high_tick), SELL,
+                     report);
+    }
+    updatePegReference();
+    publishTopOfBook();
+    return report;
+}
+
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels>
+void BasicOrderBook<MatchingPolicy, Containers>::cancelLevels(
+    Levels& book, typename Levels::iterator first,
+    typename Levels::iterator last, Side side, RangeCancelReport& report) {
+    // Whole levels go at once: no per-order level lookup or queue scan, just
+    // one index erase per order
+    for (auto it = first; it != last; ++it) {
+        auto& [price, level] = *it;
+        state_hash_ -= levelHash(side, price, level) + queueHash(level);
+
+        for (const shared_ptr<Order>& order : level.orders) {
+            state_hash_ -= orderHash(*order);
+            orders_by_id_.Erase(order->getOrderId());
+            report.order_ids.push_back(order->getOrderId());
+        }
+        report.volume += level.total_volume;
+        report.levels++;
+    }
+
+    book.erase(first, last);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::addStopOrder(
+    const Order& order) {
+    auto order_ptr = make_shared<Order>(order);
+    Price trigger_price = order.getTriggerPrice();
+
+    // A stop whose trigger price has already traded fires straight away
+    bool already_triggered =
+        last_trade_price_ != 0 &&
+        ((order.getSide() == BUY && last_trade_price_ >= trigger_price) ||
+         (order.getSide() == SELL && last_trade_price_ <= trigger_price));
+
+    if (already_triggered) {
+        triggered_stops_.push_back(order_ptr);
+    } else if (order.getSide() == BUY) {
+        buy_stops_by_trigger_[trigger_price].push_back(order_ptr);
+    } else {
+        sell_stops_by_trigger_[trigger_price].push_back(order_ptr);
+    }
+
+    // Add to hashmap so the stop can be cancelled like any other order
+    orders_by_id_.Insert(order.getOrderId(), order_ptr);
+    state_hash_ += orderHash(*order_ptr);
+    scheduleExpiry(order);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::cancelStopOrder(
+    const Order& order) {
+    OrderID order_id = order.getOrderId();
+    auto matches_id = [order_id](const shared_ptr<Order>& current_order) {
+        return current_order->getOrderId() == order_id;
+    };
+
+    // Remove from the trigger book if it has not fired yet
+    if (order.getSide() == BUY) {
+        auto stop_it = buy_stops_by_trigger_.find(order.getTriggerPrice());
+        if (stop_it != buy_stops_by_trigger_.end() &&
+            erase_if(stop_it->second, matches_id) > 0) {
+            if (stop_it->second.empty()) {
+                buy_stops_by_trigger_.erase(stop_it);
             }
+            return;
         }
     } else {
-        auto it = sell_orders_by_price_.find(price);
-        if (it != sell_orders_by_price_.end()) {
-            const auto& orders_at_price = it->second;
-            for (const auto& order : orders_at_price) {
-                total_volume += order->getRemainingVolume();
+        auto stop_it = sell_stops_by_trigger_.find(order.getTriggerPrice());
+        if (stop_it != sell_stops_by_trigger_.end() &&
+            erase_if(stop_it->second, matches_id) > 0) {
+            if (stop_it->second.empty()) {
+                sell_stops_by_trigger_.erase(stop_it);
             }
+            return;
         }
     }
 
-    return total_volume;
+    // Otherwise it is triggered but still waiting to be injected
+    erase_if(triggered_stops_, matches_id);
 }
 
-void OrderBook::GetOrderBookStats() const {
-    cout << "Order Book Stats:\n";
-    cout << "Buy Side:\n";
-    for (const auto& [price, orders_at_price] : buy_orders_by_price_) {
-        Volume total_volume = 0;
-        for (const auto& order : orders_at_price) {
-            total_volume += order->getRemainingVolume();
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::triggerStops(
+    const vector<Trade>& trades, size_t first_trade) {
+    if (first_trade == trades.size()) {
+        return;
+    }
+
+    // Price range printed by the new trades
+    Price high = trades[first_trade].price;
+    Price low = trades[first_trade].price;
+    for (size_t i = first_trade + 1; i < trades.size(); i++) {
+        high = max(high, trades[i].price);
+        low = min(low, trades[i].price);
+    }
+
+    // Buy stops with a trigger at or below the high fire, lowest trigger
+    // first; sell stops with a trigger at or above the low, highest first.
+    // Both are a range at the front of their map, so nothing is scanned.
+    auto buy_end = buy_stops_by_trigger_.upper_bound(high);
+    for (auto it = buy_stops_by_trigger_.begin(); it != buy_end; ++it) {
+        ranges::move(it->second, back_inserter(triggered_stops_));
+    }
+    buy_stops_by_trigger_.erase(buy_stops_by_trigger_.begin(), buy_end);
+
+    auto sell_end = sell_stops_by_trigger_.upper_bound(low);
+    for (auto it = sell_stops_by_trigger_.begin(); it != sell_end; ++it) {
+        ranges::move(it->second, back_inserter(triggered_stops_));
+    }
+    sell_stops_by_trigger_.erase(sell_stops_by_trigger_.begin(), sell_end);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::processTriggeredStops(
+    vector<Trade>& trades) {
+    // Inject at most max_stop_cascade_ stops; any remaining cascade stays
+    // queued for the next message (or an explicit ProcessTriggeredStops call)
+    for (size_t injected = 0;
+         injected < max_stop_cascade_ && !triggered_stops_.empty();
+         injected++) {
+        shared_ptr<Order> stop = triggered_stops_.front();
+        triggered_stops_.pop_front();
+        orders_by_id_.Erase(stop->getOrderId());
+        state_hash_ -= orderHash(*stop);
+
+        // Convert into the order it represents, keeping ID, volume and
+        // owner; its expiry was scheduled when the stop was placed
+        Order order(stop->getOrderId(), stop->getSide(),
+                    stop->getOrderType() == STOP ? MARKET : LIMIT,
+                    stop->getPrice(), stop->getRemainingVolume());
+        order.setPeakVolume(stop->getPeakVolume());
+        order.setTimeInForce(stop->getTimeInForce(), stop->getExpireTime());
+        order.setParticipantId(stop->getParticipantId());
+        order.setQueueWatched(stop->isQueueWatched());
+        executeOrder(order, trades, true);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<Trade>
+BasicOrderBook<MatchingPolicy, Containers>::ProcessTriggeredStops() {
+    vector<Trade> trades;
+    processTriggeredStops(trades);
+    repricePegs(trades);
+    toExternalPrices(trades);
+    trade_stats_.Publish();
+    publishTopOfBook();
+    publishQueuePositions();
+    return trades;
+}
+
+template <typename MatchingPolicy, typename Containers>
+typename BasicOrderBook<MatchingPolicy, Containers>::PegLevels&
+BasicOrderBook<MatchingPolicy, Containers>::pegLevels(Side side, PegType peg) {
+    return (side == BUY ? buy_pegs_ : sell_pegs_)[peg - 1];
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::pegPrice(
+    Side side, PegType peg, Price offset, Price& price) const {
+    // No reference (an empty side) means the pegged order cannot trade
+    Price reference = 0;
+    if (peg == PEG_PRIMARY) {
+        if (side == BUY ? !peg_has_bid_ : !peg_has_ask_) {
+            return false;
         }
-        cout << "Price: " << price << ", Total Volume: " << total_volume
-             << ", Orders: " << orders_at_price.size() << "\n";
+        reference = side == BUY ? peg_best_bid_ : peg_best_ask_;
+    } else {
+        if (!peg_has_bid_ || !peg_has_ask_) {
+            return false;
+        }
+        // A midpoint between two ticks rounds to the passive side
+        uint64_t sum = uint64_t{peg_best_bid_} + peg_best_ask_;
+        reference = static_cast<Price>(side == BUY ? sum / 2 : (sum + 1) / 2);
     }
 
-    cout << "Sell Side:\n";
-    for (const auto& [price, orders_at_price] : sell_orders_by_price_) {
-        Volume total_volume = 0;
-        for (const auto& order : orders_at_price) {
-            total_volume += order->getRemainingVolume();
+    // The offset always moves the order away from the other side
+    if (side == BUY) {
+        if (offset > reference) {
+            return false;
+        }
+        price = reference - offset;
+    } else {
+        if (offset > UINT32_MAX - reference) {
+            return false;
+        }
+        price = reference + offset;
+    }
+    return true;
+}
+
+template <typename MatchingPolicy, typename Containers>
+typename BasicOrderBook<MatchingPolicy, Containers>::PegLevels*
+BasicOrderBook<MatchingPolicy, Containers>::bestPegLevels(Side side,
+                                                          Price& price) {
+    // The front level of each peg type is its best; the better of the two
+    // wins, midpoint pegs first at the same price
+    PegLevels* best = nullptr;
+    for (PegType peg : {PEG_MID, PEG_PRIMARY}) {
+        PegLevels& pegs = pegLevels(side, peg);
+        Price candidate = 0;
+        if (pegs.empty() ||
+            !pegPrice(side, peg, pegs.begin()->first, candidate)) {
+            continue;
+        }
+        if (best == nullptr ||
+            (side == BUY ? candidate > price : candidate < price)) {
+            best = &pegs;
+            price = candidate;
+        }
+    }
+    return best;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::addPeggedOrder(
+    const Order& order) {
+    auto order_ptr = make_shared<Order>(order);
+    order_ptr->setPrice(0);  // priced from the reference while it rests
+
+    Level& level =
+        pegLevels(order.getSide(), order.getPegType())[order.getPegOffset()];
+    if (!level.orders.empty()) {
+        state_hash_ +=
+            linkHash(*level.orders[level.orders.size() - 1], *order_ptr);
+    }
+    level.orders.push_back(order_ptr);
+    level.total_volume += order_ptr->getRemainingVolume();
+    state_hash_ += orderHash(*order_ptr);
+
+    orders_by_id_.Insert(order.getOrderId(), order_ptr);
+    scheduleExpiry(order);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::cancelPeggedOrder(
+    const Order& order) {
+    PegLevels& pegs = pegLevels(order.getSide(), order.getPegType());
+    auto level_it = pegs.find(order.getPegOffset());
+    if (level_it == pegs.end()) {
+        return;
+    }
+
+    Level& level = level_it->second;
+    OrderID order_id = order.getOrderId();
+    state_hash_ -= queueHash(level);
+    erase_if(level.orders, [order_id](const shared_ptr<Order>& current) {
+        return current->getOrderId() == order_id;
+    });
+    state_hash_ += queueHash(level);
+    level.total_volume -= order.getRemainingVolume();
+    if (level.orders.empty()) {
+        pegs.erase(level_it);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::matchPegged(
+    Order& order, PegLevels& pegs, Price peg_price, size_t first_trade,
+    vector<Trade>& trades) {
+    // Pegged levels always allocate in time priority
+    Level& level = pegs.begin()->second;
+    Order& resting_order = *level.orders.front();
+    state_hash_ -= orderHash(resting_order);
+
+    Volume trade_volume =
+        min(order.getRemainingVolume(), resting_order.getRemainingVolume());
+    Trade trade = executeMatch(order, resting_order, peg_price, trade_volume);
+    level.total_volume -= trade.volume;
+    reportFill(order, trade, first_trade, trades);
+
+    settlePeggedFront(pegs);
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::settlePeggedFront(
+    PegLevels& pegs) {
+    auto level_it = pegs.begin();
+    Level& level = level_it->second;
+    const Order& resting_order = *level.orders.front();
+    if (!resting_order.isFilled()) {
+        state_hash_ += orderHash(resting_order);
+        return;
+    }
+
+    orders_by_id_.Erase(resting_order.getOrderId());
+    if (level.orders.size() > 1) {
+        state_hash_ -= linkHash(resting_order, *level.orders[1]);
+    }
+    level.orders.pop_front();
+    if (level.orders.empty()) {
+        pegs.erase(level_it);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::updatePegReference() {
+    // The auction book may be crossed: pegs keep their pre-auction reference
+    if (in_auction_) {
+        return;
+    }
+    peg_has_bid_ = !buy_orders_by_price_.empty();
+    peg_has_ask_ = !sell_orders_by_price_.empty();
+    peg_best_bid_ = peg_has_bid_ ? buy_orders_by_price_.begin()->first : 0;
+    peg_best_ask_ = peg_has_ask_ ? sell_orders_by_price_.begin()->first : 0;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::repricePegs(
+    vector<Trade>& trades) {
+    updatePegReference();
+
+    // Buy and sell midpoint pegs meet when the spread becomes an even number
+    // of ticks; they trade with each other at the midpoint. Both were
+    // resting, so the buy peg is reported as the aggressor and the sell
+    // fill goes to the passive channel.
+    size_t first_trade = trades.size();
+    size_t buyer_first_trade = first_trade;
+    OrderID buyer_id = 0;
+    while (true) {
+        Price bid = 0;
+        Price ask = 0;
+        PegLevels* buy_pegs = bestPegLevels(BUY, bid);
+        PegLevels* sell_pegs = bestPegLevels(SELL, ask);
+        if (buy_pegs == nullptr || sell_pegs == nullptr || bid < ask) {
+            break;
+        }
+
+        Level& buy_level = buy_pegs->begin()->second;
+        Level& sell_level = sell_pegs->begin()->second;
+        Order& buy_order = *buy_level.orders.front();
+        Order& sell_order = *sell_level.orders.front();
+        state_hash_ -= orderHash(buy_order) + orderHash(sell_order);
+
+        Volume trade_volume = min(buy_order.getRemainingVolume(),
+                                  sell_order.getRemainingVolume());
+        Trade trade = executeMatch(buy_order, sell_order, ask, trade_volume);
+        if (buy_order.getOrderId() != buyer_id) {
+            buyer_id = buy_order.getOrderId();
+            buyer_first_trade = trades.size();  // conflate per buy peg
+        }
+        reportFill(buy_order, trade, buyer_first_trade, trades);
+        buy_level.total_volume -= trade.volume;
+        sell_level.total_volume -= trade.volume;
+
+        settlePeggedFront(*buy_pegs);
+        settlePeggedFront(*sell_pegs);
+    }
+    triggerStops(trades, first_trade);
+}
+
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels, typename Visitor>
+void BasicOrderBook<MatchingPolicy, Containers>::visitLiquidity(
+    const Levels& book, Side side, Visitor visit) const {
+    // Displayed levels and both peg types merged into one walk, in the order
+    // an incoming order would reach them; visit(price, volume) returns false
+    // to stop. Only level aggregates are read, never individual orders.
+    const array<PegLevels, 2>& pegs = side == BUY ? buy_pegs_ : sell_pegs_;
+    auto level_it = book.begin();
+    array<typename PegLevels::const_iterator, 2> peg_its = {pegs[0].begin(),
+                                                   pegs[1].begin()};
+    while (true) {
+        bool found = level_it != book.end();
+        Price price = found ? level_it->first : 0;
+        Volume volume = found ? level_it->second.total_volume : 0;
+        int source = -1;  // displayed, or the index of a peg type
+
+        for (int peg = 0; peg < 2; peg++) {
+            Price peg_price = 0;
+            if (peg_its[peg] == pegs[peg].end() ||
+                !pegPrice(side, static_cast<PegType>(peg + 1),
+                          peg_its[peg]->first, peg_price)) {
+                continue;
+            }
+            if (!found || book.key_comp()(peg_price, price)) {
+                found = true;
+                price = peg_price;
+                volume = peg_its[peg]->second.total_volume;
+                source = peg;
+            }
+        }
+
+        if (!found || !visit(price, volume)) {
+            return;
+        }
+        if (source < 0) {
+            ++level_it;
+        } else {
+            ++peg_its[source];
+        }
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::availableVolume(
+    Side side, bool limited, Price limit_tick, uint64_t enough) const {
+    // Volume an incoming order on this side could reach, up to its limit;
+    // the walk stops as soon as enough is found
+    uint64_t available = 0;
+    auto add_level = [&](Price price, Volume volume) {
+        bool beyond_limit =
+            side == BUY ? price > limit_tick : price < limit_tick;
+        if (limited && beyond_limit) {
+            return false;
+        }
+        available += volume;
+        return available < enough;
+    };
+    if (side == BUY) {
+        visitLiquidity(sell_orders_by_price_, SELL, add_level);
+    } else {
+        visitLiquidity(buy_orders_by_price_, BUY, add_level);
+    }
+    return available;
+}
+
+template <typename MatchingPolicy, typename Containers>
+RejectReason BasicOrderBook<MatchingPolicy, Containers>::applyTimeInForce(
+    Order& order) const {
+    // DAY orders take the session end in force when they arrive
+    if (order.getTimeInForce() == DAY) {
+        order.setTimeInForce(DAY, session_end_);
+    }
+    bool expires = order.getTimeInForce() == GTD ||
+                   (order.getTimeInForce() == DAY && session_end_ != 0);
+    if (expires && order.getExpireTime() <= now_) {
+        return ALREADY_EXPIRED;
+    }
+    return NOT_REJECTED;
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::isExpired(
+    const Order& order) const {
+    return order.getTimeInForce() != GTC && order.getExpireTime() != 0 &&
+           order.getExpireTime() <= now_;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::scheduleExpiry(
+    const Order& order) {
+    if (order.getTimeInForce() != GTC && order.getExpireTime() != 0) {
+        expiry_wheel_.Schedule(order.getOrderId(), order.getExpireTime());
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+RejectReason BasicOrderBook<MatchingPolicy, Containers>::normalizeQuote(
+    vector<QuoteEntry>& entries) const {
+    // The whole quote is checked before any leg is applied
+    bool has_bid = false;
+    bool has_ask = false;
+    Price best_bid = 0;
+    Price best_ask = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        QuoteEntry& entry = entries[i];
+        RejectReason reason = ticks_.ToTick(entry.price, entry.price);
+        if (reason != NOT_REJECTED) {
+            return reason;
+        }
+        if (entry.volume == 0) {
+            return INVALID_QUOTE;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (entries[j].order_id == entry.order_id) {
+                return INVALID_QUOTE;
+            }
+        }
+        if (entry.side == BUY) {
+            best_bid = has_bid ? max(best_bid, entry.price) : entry.price;
+            has_bid = true;
+        } else {
+            best_ask = has_ask ? min(best_ask, entry.price) : entry.price;
+            has_ask = true;
         }
-        cout << "Price: " << price << ", Total Volume: " << total_volume
-             << ", Orders: " << orders_at_price.size() << "\n";
     }
-}
\ No newline at end of file
+    return has_bid && has_ask && best_bid >= best_ask ? INVALID_QUOTE
+                                                      : NOT_REJECTED;
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::requoteInPlace(
+    Order& leg, const QuoteEntry& entry) {
+    // A leg left at its price and not grown keeps its time priority
+    if (leg.getSide() != entry.side || leg.getPrice() != entry.price ||
+        entry.volume > leg.getRemainingVolume()) {
+        return false;
+    }
+    Volume reduction = leg.getRemainingVolume() - entry.volume;
+    if (reduction == 0) {
+        return true;
+    }
+    Level& level = entry.side == BUY ? buy_orders_by_price_[entry.price]
+                                          : sell_orders_by_price_[entry.price];
+    state_hash_ -= orderHash(leg) + levelHash(entry.side, entry.price, level);
+    noteQueueMoved(entry.side, entry.price, level);
+    shrinkQueued(level, leg, reduction);
+    leg.setVolume(leg.getVolume() - reduction);
+    level.total_volume -= reduction;
+    state_hash_ += orderHash(leg) + levelHash(entry.side, entry.price, level);
+    return true;
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<Trade> BasicOrderBook<MatchingPolicy, Containers>::MassQuote(
+    ParticipantID participant_id, const vector<QuoteEntry>& entries) {
+    vector<Trade> trades;
+    quote_entries_.assign(entries.begin(), entries.end());
+    last_reject_reason_ = normalizeQuote(quote_entries_);
+    if (last_reject_reason_ != NOT_REJECTED) {
+        return trades;
+    }
+
+    // The participant's legs that are still resting. The scratch vectors
+    // swap with the participant's, so requoting does not allocate.
+    vector<shared_ptr<Order>>& legs = quotes_[participant_id];
+    vector<shared_ptr<Order>>& old_legs = quote_old_legs_;
+    old_legs.swap(legs);
+    legs.clear();
+    erase_if(old_legs, [this](const shared_ptr<Order>& leg) {
+        const shared_ptr<Order>* found = orders_by_id_.Find(leg->getOrderId());
+        return found == nullptr || found->get() != leg.get();
+    });
+
+    // A new leg may not reuse the ID of another resting order
+    for (const QuoteEntry& entry : quote_entries_) {
+        const shared_ptr<Order>* found = orders_by_id_.Find(entry.order_id);
+        if (found != nullptr &&
+            ranges::find(old_legs, *found) == old_legs.end()) {
+            legs.swap(old_legs);
+            last_reject_reason_ = INVALID_QUOTE;
+            return trades;
+        }
+    }
+
+    // First every leg that does not stay put leaves its level, so new legs
+    // can never trade against the participant's own old ones. A moved leg
+    // keeps its record and index entry; records of dropped legs are reused
+    // for new order IDs.
+    vector<shared_ptr<Order>>& records = quote_records_;
+    vector<shared_ptr<Order>>& spare = quote_spare_;
+    records.assign(quote_entries_.size(), nullptr);
+    spare.clear();
+    for (shared_ptr<Order>& leg : old_legs) {
+        auto entry_it =
+            ranges::find_if(quote_entries_, [&](const QuoteEntry& entry) {
+                return entry.order_id == leg->getOrderId();
+            });
+        if (entry_it != quote_entries_.end() &&
+            requoteInPlace(*leg, *entry_it)) {
+            legs.push_back(std::move(leg));
+            entry_it->volume = 0;  // done
+            continue;
+        }
+        state_hash_ -= orderHash(*leg);
+        if (leg->getSide() == BUY) {
+            unlinkOrder(buy_orders_by_price_, *leg);
+        } else {
+            unlinkOrder(sell_orders_by_price_, *leg);
+        }
+        if (entry_it != quote_entries_.end()) {
+            records[entry_it - quote_entries_.begin()] = std::move(leg);
+        } else {
+            orders_by_id_.Erase(leg->getOrderId());
+            spare.push_back(std::move(leg));
+        }
+    }
+    old_legs.clear();
+
+    for (size_t i = 0; i < quote_entries_.size(); i++) {
+        const QuoteEntry& entry = quote_entries_[i];
+        if (entry.volume == 0) {
+            continue;
+        }
+        Order order(entry.order_id, entry.side, LIMIT, entry.price,
+                    entry.volume);
+        order.setParticipantId(participant_id);
+
+        // A leg that crosses the book trades like any limit order
+        if (!in_auction_ &&
+            availableVolume(entry.side, true, entry.price, 1) > 0) {
+            if (records[i] != nullptr) {
+                orders_by_id_.Erase(entry.order_id);
+            }
+            updatePegReference();
+            placeOrder(order, trades);
+            const shared_ptr<Order>* rested =
+                orders_by_id_.Find(entry.order_id);
+            if (rested != nullptr) {
+                legs.push_back(*rested);
+            }
+            continue;
+        }
+
+        shared_ptr<Order> record = std::move(records[i]);
+        bool watched = record != nullptr && record->isQueueWatched();
+        if (record == nullptr) {
+            if (spare.empty()) {
+                record = make_shared<Order>();
+            } else {
+                record = std::move(spare.back());
+                spare.pop_back();
+            }
+            orders_by_id_.Insert(entry.order_id, record);
+        }
+        *record = order;
+        record->setQueueWatched(watched);  // a moved leg stays watched
+        linkOrder(record);
+        state_hash_ += orderHash(*record);
+        legs.push_back(std::move(record));
+    }
+    spare.clear();
+
+    // The pegged orders move with the BBO the quote left behind
+    repricePegs(trades);
+    toExternalPrices(trades);
+    trade_stats_.Publish();
+    publishTopOfBook();
+    publishQueuePositions();
+    return trades;
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<OrderID> BasicOrderBook<MatchingPolicy, Containers>::AdvanceTime(
+    Timestamp now) {
+    vector<OrderID> expired;
+    if (now <= now_) {
+        return expired;  // engine time never goes backwards
+    }
+    now_ = now;
+
+    vector<OrderID> due;
+    expiry_wheel_.Advance(now_, due);
+    expireOrders(due, expired);
+    updatePegReference();
+    publishTopOfBook();
+    publishQueuePositions();
+    return expired;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::expireOrders(
+    const vector<OrderID>& due, vector<OrderID>& expired) {
+    // Wheel entries of cancelled or filled orders are stale and skipped;
+    // resting orders are grouped by level so each level is compacted once
+    vector<uint64_t> levels;  // side << 32 | price, sorts as one integer
+    for (OrderID order_id : due) {
+        const shared_ptr<Order>* found = orders_by_id_.Find(order_id);
+        if (found == nullptr || !isExpired(**found)) {
+            continue;
+        }
+        const Order& order = **found;
+        if (order.getOrderType() == STOP ||
+            order.getOrderType() == STOP_LIMIT || order.isPegged()) {
+            CancelOrder(order_id);
+            expired.push_back(order_id);
+        } else {
+            levels.push_back(static_cast<uint64_t>(order.getSide()) << 32 |
+                             order.getPrice());
+        }
+    }
+    ranges::sort(levels);
+    auto [first_duplicate, last] = ranges::unique(levels);
+    levels.erase(first_duplicate, last);
+
+    // One pass over each touched level removes every expired order in it
+    auto expire_level = [this, &expired](auto& book, Side side, Price price) {
+        auto level_it = book.find(price);
+        if (level_it == book.end()) {
+            return;
+        }
+        Level& level = level_it->second;
+        state_hash_ -= levelHash(side, price, level) + queueHash(level);
+        erase_if(level.orders, [&](const shared_ptr<Order>& order) {
+            if (!isExpired(*order)) {
+                return false;
+            }
+            state_hash_ -= orderHash(*order);
+            level.total_volume -= order->getRemainingVolume();
+            level.hidden_volume -= order->getHiddenVolume();
+            level.watched -= order->isQueueWatched();
+            expired.push_back(order->getOrderId());
+            return true;
+        });
+        state_hash_ += levelHash(side, price, level) + queueHash(level);
+        rebaseQueue(level);
+        noteQueueMoved(side, price, level);
+
+        if (level.orders.empty()) {
+            book.erase(level_it);
+        }
+    };
+    size_t first_resting = expired.size();
+    for (uint64_t level_key : levels) {
+        auto price = static_cast<Price>(level_key);
+        if (level_key >> 32 == BUY) {
+            expire_level(buy_orders_by_price_, BUY, price);
+        } else {
+            expire_level(sell_orders_by_price_, SELL, price);
+        }
+    }
+
+    // Index entries (and the last reference to each order) go in ID order,
+    // which follows allocation order and so walks memory mostly forwards
+    sort(expired.begin() + first_resting, expired.end());
+    for (size_t i = first_resting; i < expired.size(); i++) {
+        orders_by_id_.Erase(expired[i]);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::SetSessionEnd(
+    Timestamp session_end) {
+    session_end_ = session_end;
+}
+
+template <typename MatchingPolicy, typename Containers>
+size_t
+BasicOrderBook<MatchingPolicy, Containers>::GetScheduledExpiryCount() const {
+    return expiry_wheel_.Size();
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::SetReportMode(
+    ReportMode report_mode) {
+    report_mode_ = report_mode;
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<Trade> BasicOrderBook<MatchingPolicy, Containers>::TakePassiveFills() {
+    // Hand over the buffer; drain it after every message to keep it small
+    vector<Trade> fills;
+    fills.swap(passive_fills_);
+    toExternalPrices(fills);
+    return fills;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::SetMaxStopCascade(
+    size_t max_stop_cascade) {
+    max_stop_cascade_ = max_stop_cascade;
+}
+
+template <typename MatchingPolicy, typename Containers>
+size_t BasicOrderBook<MatchingPolicy, Containers>::GetPendingStopCount() const {
+    return triggered_stops_.size();
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::StartAuction() {
+    in_auction_ = true;
+    publishTopOfBook();
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::IsInAuction() const {
+    return in_auction_;
+}
+
+template <typename MatchingPolicy, typename Containers>
+AuctionResult
+BasicOrderBook<MatchingPolicy, Containers>::GetIndicativeUncross() const {
+    AuctionResult result = computeUncross();
+    if (result.matched_volume != 0) {
+        result.price = ticks_.ToPrice(result.price);
+    }
+    return result;
+}
+
+template <typename MatchingPolicy, typename Containers>
+AuctionResult
+BasicOrderBook<MatchingPolicy, Containers>::computeUncross() const {
+    AuctionResult result{.price = 0, .matched_volume = 0, .imbalance = 0};
+
+    // Nothing executes unless the best bid reaches the best ask
+    if (buy_orders_by_price_.empty() || sell_orders_by_price_.empty()) {
+        return result;
+    }
+    Price low = sell_orders_by_price_.begin()->first;
+    Price high = buy_orders_by_price_.begin()->first;
+    if (high < low) {
+        return result;
+    }
+
+    // Total buy volume in the crossed range [low, high]
+    auto buy_end = buy_orders_by_price_.upper_bound(low);  // first bid < low
+    uint64_t demand = 0;
+    for (auto it = buy_orders_by_price_.begin(); it != buy_end; ++it) {
+        demand += it->second.total_volume;
+    }
+
+    // Tie-break 1: minimum absolute imbalance among the max-volume prices.
+    // Tie-break 2: market pressure; a buy surplus on every remaining
+    // candidate pushes the price up, a sell surplus pushes it down.
+    // Tie-break 3: closest to the reference (last trade or range midpoint)
+    Price reference = last_trade_price_ != 0 ? last_trade_price_
+                                             : low + (high - low) / 2;
+    auto distance = [reference](Price price) {
+        return price > reference ? price - reference : reference - price;
+    };
+    uint64_t max_executable = 0;
+    uint64_t min_surplus = UINT64_MAX;
+    bool all_buy_surplus = true;
+    bool all_sell_surplus = true;
+    AuctionResult first = result;
+    AuctionResult last = result;
+    AuctionResult closest = result;
+    auto consider = [&](Price price, uint64_t bids, uint64_t asks) {
+        uint64_t executable = min(bids, asks);
+        int64_t imbalance =
+            static_cast<int64_t>(bids) - static_cast<int64_t>(asks);
+        auto surplus = static_cast<uint64_t>(abs(imbalance));
+        AuctionResult candidate{.price = price,
+                                .matched_volume = executable,
+                                .imbalance = imbalance};
+        if (executable > max_executable ||
+            (executable == max_executable && surplus < min_surplus)) {
+            // A strictly better candidate restarts the tie set
+            max_executable = executable;
+            min_surplus = surplus;
+            all_buy_surplus = imbalance > 0;
+            all_sell_surplus = imbalance < 0;
+            first = last = closest = candidate;
+        } else if (executable == max_executable && surplus == min_surplus) {
+            all_buy_surplus = all_buy_surplus && imbalance > 0;
+            all_sell_surplus = all_sell_surplus && imbalance < 0;
+            last = candidate;
+            if (distance(price) < distance(closest.price)) {
+                closest = candidate;
+            }
+        }
+    };
+
+    // One merged walk over both sides' crossed levels in ascending price:
+    // supply accumulates from the bottom up, while demand drops by each
+    // bid level once the walk has passed it
+    auto buy_it = buy_end;  // bids are kept descending; walk them backwards
+    auto sell_it = sell_orders_by_price_.begin();
+    auto sell_end = sell_orders_by_price_.upper_bound(high);
+    uint64_t supply = 0;
+    while (buy_it != buy_orders_by_price_.begin() || sell_it != sell_end) {
+        Price price = sell_it != sell_end ? sell_it->first : high;
+        if (buy_it != buy_orders_by_price_.begin()) {
+            price = min(price, prev(buy_it)->first);
+        }
+        if (sell_it != sell_end && sell_it->first == price) {
+            supply += sell_it->second.total_volume;
+            ++sell_it;
+        }
+        uint64_t bid_volume = 0;
+        if (buy_it != buy_orders_by_price_.begin() &&
+            prev(buy_it)->first == price) {
+            --buy_it;
+            bid_volume = buy_it->second.total_volume;
+        }
+        consider(price, demand, supply);
+        demand -= bid_volume;
+    }
+    if (max_executable == 0) {
+        return result;
+    }
+
+    if (all_buy_surplus) {
+        return last;
+    }
+    if (all_sell_surplus) {
+        return first;
+    }
+    return closest;
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<Trade> BasicOrderBook<MatchingPolicy, Containers>::Uncross() {
+    vector<Trade> trades;
+
+    AuctionResult result = computeUncross();
+    in_auction_ = false;
+    if (result.matched_volume == 0) {
+        updatePegReference();
+        publishTopOfBook();
+        return trades;
+    }
+
+    // Single pass: pair off the best buy and sell orders, all executing at the
+    // equilibrium price, until either side runs out of eligible volume
+    while (!buy_orders_by_price_.empty() && !sell_orders_by_price_.empty()) {
+        auto buy_it = buy_orders_by_price_.begin();
+        auto sell_it = sell_orders_by_price_.begin();
+        if (buy_it->first < result.price || sell_it->first > result.price) {
+            break;
+        }
+
+        Order& buy_order = *buy_it->second.orders.front();
+        Order& sell_order = *sell_it->second.orders.front();
+        state_hash_ -= orderHash(buy_order) +
+                       levelHash(BUY, buy_it->first, buy_it->second) +
+                       orderHash(sell_order) +
+                       levelHash(SELL, sell_it->first, sell_it->second);
+
+        Volume trade_volume =
+            min(buy_order.getVisibleVolume(), sell_order.getVisibleVolume());
+        Trade trade =
+            executeMatch(buy_order, sell_order, result.price, trade_volume);
+        trades.push_back(trade);
+        buy_it->second.total_volume -= trade.volume;
+        buy_it->second.departed_volume += trade.volume;
+        sell_it->second.total_volume -= trade.volume;
+        sell_it->second.departed_volume += trade.volume;
+
+        settleFrontOrder(buy_orders_by_price_, buy_it);
+        settleFrontOrder(sell_orders_by_price_, sell_it);
+    }
+
+    // The uncross print can trigger stops like any other trade
+    triggerStops(trades, 0);
+    processTriggeredStops(trades);
+    repricePegs(trades);
+
+    toExternalPrices(trades);
+    trade_stats_.Publish();
+    publishTopOfBook();
+    publishQueuePositions();
+    return trades;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::SetBarInterval(
+    Timestamp bar_interval_ns) {
+    trade_stats_.SetBarInterval(bar_interval_ns);
+}
+
+template <typename MatchingPolicy, typename Containers>
+const TradeStatistics&
+BasicOrderBook<MatchingPolicy, Containers>::GetTradeStatistics()
+    const {
+    return trade_stats_;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::SetTopOfBookSlot(
+    TopOfBookSlot* slot) {
+    // The new slot gets the current levels right away
+    top_slot_ = slot;
+    if (top_slot_ != nullptr) {
+        published_top_ = TopOfBook();
+        top_slot_->Store(published_top_);
+        publishTopOfBook();
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels>
+void BasicOrderBook<MatchingPolicy, Containers>::topLevels(
+    const Levels& book, array<TopLevel, kTopOfBookLevels>& levels) const {
+    size_t count = 0;
+    for (auto it = book.begin(); it != book.end() && count < levels.size();
+         ++it) {
+        const Level& level = it->second;
+        levels[count++] = {.price = ticks_.ToPrice(it->first),
+                           .volume = level.total_volume - level.hidden_volume};
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::publishTopOfBook() {
+    // Called once at the end of every message that can change the levels;
+    // a few map nodes from each side and a compare when nothing moved
+    if (top_slot_ == nullptr) {
+        return;
+    }
+    TopOfBook top;
+    topLevels(buy_orders_by_price_, top.bids);
+    topLevels(sell_orders_by_price_, top.asks);
+    top.in_auction = in_auction_;
+    if (top != published_top_) {
+        published_top_ = top;
+        top_slot_->Store(top);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::eraseQueued(
+    Level& level, const Order& order) {
+    // Everyone behind moves up by the order's displayed volume and one
+    // order: that counts as departed for all, and is credited back to the
+    // orders ahead of it on the way
+    Volume visible = order.getVisibleVolume();
+    bool watched = order.isQueueWatched();
+    const Order* ahead = nullptr;
+    for (auto it = level.orders.begin(); it != level.orders.end(); ++it) {
+        Order& queued = **it;
+        if (&queued == &order) {
+            // Its neighbours become each other's
+            auto behind = next(it);
+            if (ahead != nullptr) {
+                state_hash_ -= linkHash(*ahead, order);
+            }
+            if (behind != level.orders.end()) {
+                state_hash_ -= linkHash(order, **behind);
+                if (ahead != nullptr) {
+                    state_hash_ += linkHash(*ahead, **behind);
+                }
+            }
+            level.orders.erase(it);
+            level.departed_volume += visible;
+            level.departed_orders++;
+            level.watched -= watched;
+            return;
+        }
+        queued.setQueueMarks(queued.getQueueVolumeMark() + visible,
+                             queued.getQueueOrderMark() + 1);
+        ahead = &queued;
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::shrinkQueued(
+    Level& level, const Order& order, Volume reduction) {
+    // Like an erase, for part of the order's displayed volume: the orders
+    // up to and including it are credited back
+    level.departed_volume += reduction;
+    for (const shared_ptr<Order>& queued : level.orders) {
+        queued->setQueueMarks(queued->getQueueVolumeMark() + reduction,
+                              queued->getQueueOrderMark());
+        if (queued.get() == &order) {
+            break;
+        }
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::rebaseQueue(Level& level) {
+    // Recounts every mark from the front, after a pass that filled or
+    // removed orders anywhere in the queue
+    uint64_t volume = level.departed_volume;
+    uint64_t orders = level.departed_orders;
+    for (const shared_ptr<Order>& queued : level.orders) {
+        queued->setQueueMarks(volume, orders++);
+        volume += queued->getVisibleVolume();
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::noteQueueMoved(
+    Side side, Price price, const Level& level) {
+    // Levels are noted as the message reaches them, so a repeat is usually
+    // the last one noted
+    if (level.watched == 0) {
+        return;
+    }
+    uint64_t key = static_cast<uint64_t>(side) << 32 | price;
+    if (moved_queues_.empty() || moved_queues_.back() != key) {
+        moved_queues_.push_back(key);
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+QueuePosition BasicOrderBook<MatchingPolicy, Containers>::queuePosition(
+    const Level& level, const Order& order) {
+    // The front order's own fills count as departed, so its marks can fall
+    // behind the counters
+    uint64_t volume_mark = order.getQueueVolumeMark();
+    uint64_t order_mark = order.getQueueOrderMark();
+    return QueuePosition{
+        .volume_ahead = volume_mark > level.departed_volume
+                            ? volume_mark - level.departed_volume
+                            : 0,
+        .orders_ahead = order_mark > level.departed_orders
+                            ? order_mark - level.departed_orders
+                            : 0};
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::publishQueuePositions() {
+    // Called once at the end of every message that can move a queue; walks
+    // each moved level only as far as its last watched order
+    if (moved_queues_.empty()) {
+        return;
+    }
+    ranges::sort(moved_queues_);
+    auto [first_duplicate, last] = ranges::unique(moved_queues_);
+    moved_queues_.erase(first_duplicate, last);
+
+    for (uint64_t key : moved_queues_) {
+        auto price = static_cast<Price>(key);
+        const Level* level = key >> 32 == BUY
+                                 ? findLevel(buy_orders_by_price_, price)
+                                 : findLevel(sell_orders_by_price_, price);
+        if (level == nullptr) {
+            continue;
+        }
+        uint32_t watched = level->watched;
+        for (auto it = level->orders.begin(); watched > 0; ++it) {
+            const Order& queued = **it;
+            if (queued.isQueueWatched()) {
+                queue_updates_.push_back(
+                    {.order_id = queued.getOrderId(),
+                     .participant_id = queued.getParticipantId(),
+                     .position = queuePosition(*level, queued)});
+                watched--;
+            }
+        }
+    }
+    moved_queues_.clear();
+}
+
+// Whether an order rests in a price level's queue (stop orders wait in the
+// trigger book, pegged orders in their own peg levels)
+static bool restsOnPriceLevel(const Order& order) {
+    return order.getOrderType() != STOP && order.getOrderType() != STOP_LIMIT &&
+           !order.isPegged();
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::GetQueuePosition(
+    OrderID orderId, QueuePosition& position) const {
+    const shared_ptr<Order>* found = orders_by_id_.Find(orderId);
+    if (found == nullptr || !restsOnPriceLevel(**found)) {
+        return false;
+    }
+    const Order& order = **found;
+    const Level* level =
+        order.getSide() == BUY
+            ? findLevel(buy_orders_by_price_, order.getPrice())
+            : findLevel(sell_orders_by_price_, order.getPrice());
+    if (level == nullptr) {
+        return false;
+    }
+    position = queuePosition(*level, order);
+    return true;
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::WatchQueuePosition(
+    OrderID orderId) {
+    const shared_ptr<Order>* found = orders_by_id_.Find(orderId);
+    if (found == nullptr || !restsOnPriceLevel(**found)) {
+        return false;
+    }
+    Order& order = **found;
+    Level* level = order.getSide() == BUY
+                       ? findLevel(buy_orders_by_price_, order.getPrice())
+                       : findLevel(sell_orders_by_price_, order.getPrice());
+    if (level == nullptr) {
+        return false;
+    }
+    if (!order.isQueueWatched()) {
+        order.setQueueWatched(true);
+        level->watched++;
+    }
+
+    // The owner starts from the current position
+    queue_updates_.push_back({.order_id = orderId,
+                              .participant_id = order.getParticipantId(),
+                              .position = queuePosition(*level, order)});
+    return true;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::UnwatchQueuePosition(
+    OrderID orderId) {
+    const shared_ptr<Order>* found = orders_by_id_.Find(orderId);
+    if (found == nullptr || !(*found)->isQueueWatched()) {
+        return;
+    }
+    Order& order = **found;
+    Level* level = order.getSide() == BUY
+                       ? findLevel(buy_orders_by_price_, order.getPrice())
+                       : findLevel(sell_orders_by_price_, order.getPrice());
+    order.setQueueWatched(false);
+    if (level != nullptr) {
+        level->watched--;
+    }
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<QueuePositionUpdate>
+BasicOrderBook<MatchingPolicy, Containers>::TakeQueuePositionUpdates() {
+    // Hand over the buffer; drain it after every message to keep it small
+    vector<QueuePositionUpdate> updates;
+    updates.swap(queue_updates_);
+    return updates;
+}
+
+template <typename MatchingPolicy, typename Containers>
+MemoryUsage BasicOrderBook<MatchingPolicy, Containers>::GetMemoryUsage() const {
+    MemoryUsage usage;
+
+    // Walks every level, so this is a reporting call, not a per-message one
+    auto add_levels = [&usage](const auto& book) {
+        using Node = typename remove_cvref_t<decltype(book)>::value_type;
+        for (const auto& [price, level] : book) {
+            auto [used, slack] = queueBytes(queueOf(level));
+            usage.levels += kTreeNodeLinkBytes + sizeof(Node) + used;
+            usage.overhead += slack;
+        }
+    };
+    add_levels(buy_orders_by_price_);
+    add_levels(sell_orders_by_price_);
+    add_levels(buy_stops_by_trigger_);
+    add_levels(sell_stops_by_trigger_);
+    for (const PegLevels& pegs : buy_pegs_) {
+        add_levels(pegs);
+    }
+    for (const PegLevels& pegs : sell_pegs_) {
+        add_levels(pegs);
+    }
+    auto [used, slack] = queueBytes(triggered_stops_);
+    usage.levels += used;
+    usage.overhead += slack;
+
+    // Every live order (stops included) has one record and one index entry
+    size_t entry_bytes =
+        kHashNodeLinkBytes + sizeof(pair<const OrderID, shared_ptr<Order>>);
+    size_t needed_buckets =
+        min(orders_by_id_.NeededBucketCount(), orders_by_id_.BucketCount());
+    usage.orders = orders_by_id_.Size() * kOrderRecordBytes;
+    usage.index = orders_by_id_.Size() * entry_bytes +
+                  needed_buckets * sizeof(void*);
+    usage.overhead +=
+        (orders_by_id_.BucketCount() - needed_buckets) * sizeof(void*);
+    return usage;
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::Compact(size_t work_budget) {
+    // One pass: rebuild the index at its live size, then shrink each level's
+    // queue, doing at most work_budget units (index entries moved or levels
+    // shrunk) per call. Orders keep flowing between calls; the pass resumes
+    // where it stopped. Returns true once the pass has finished.
+    size_t work = 0;
+    if (compaction_phase_ == COMPACTION_IDLE) {
+        orders_by_id_.BeginCompaction();
+        compaction_phase_ = COMPACTING_INDEX;
+    }
+
+    if (compaction_phase_ == COMPACTING_INDEX) {
+        work += orders_by_id_.CompactStep(work_budget);
+        if (orders_by_id_.IsCompacting()) {
+            return false;
+        }
+        compaction_cursor_ = UINT32_MAX;  // best bid first
+        compaction_phase_ = COMPACTING_BIDS;
+    }
+
+    if (compaction_phase_ == COMPACTING_BIDS) {
+        if (!shrinkLevels(buy_orders_by_price_, work_budget, work)) {
+            return false;
+        }
+        compaction_cursor_ = 0;  // best ask first
+        compaction_phase_ = COMPACTING_ASKS;
+    }
+
+    if (!shrinkLevels(sell_orders_by_price_, work_budget, work)) {
+        return false;
+    }
+    triggered_stops_.shrink_to_fit();
+    compaction_phase_ = COMPACTION_IDLE;
+    return true;
+}
+
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels>
+bool BasicOrderBook<MatchingPolicy, Containers>::shrinkLevels(
+    Levels& book, size_t work_budget, size_t& work) {
+    // Resume at the first level not yet visited; levels added or removed
+    // since the last call are simply picked up or skipped
+    for (auto it = book.lower_bound(compaction_cursor_); it != book.end();
+         ++it) {
+        if (work >= work_budget) {
+            compaction_cursor_ = it->first;
+            return false;
+        }
+        it->second.orders.shrink_to_fit();
+        work++;
+    }
+    return true;
+}
+
+template <typename MatchingPolicy, typename Containers>
+template <typename Levels>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::warmLevels(
+    const Levels& book) const {
+    // Reads the front of the best levels the way matching would: the level,
+    // its first order records and their ID index entries
+    uint64_t touched = 0;
+    size_t levels = 0;
+    for (auto level_it = book.begin();
+         level_it != book.end() && levels < kWarmLevels; ++level_it, levels++) {
+        const Level& level = level_it->second;
+        touched += level.total_volume;
+        size_t count = min(level.orders.size(), kWarmOrdersPerLevel);
+        for (size_t i = 0; i < count; i++) {
+            const Order& order = *level.orders[i];
+            touched += order.getRemainingVolume();
+            touched += orders_by_id_.Find(order.getOrderId()) != nullptr;
+        }
+    }
+    return touched;
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::KeepWarm() const {
+    // Side-effect-free dry run for an idle matching thread: walks the data an
+    // incoming order would touch first, so the next order after a quiet
+    // period does not pay for cache misses. Returns a checksum of what was
+    // read, which the caller should consume so the reads are not optimized
+    // away.
+    uint64_t touched = warmLevels(buy_orders_by_price_) +
+                       warmLevels(sell_orders_by_price_);
+    for (size_t peg = 0; peg < 2; peg++) {
+        touched += warmLevels(buy_pegs_[peg]) + warmLevels(sell_pegs_[peg]);
+    }
+
+    // A dry sweep of each side through the matching walk, pegs included
+    size_t levels = 0;
+    auto sweep = [&](Price price, Volume volume) {
+        touched += price + volume;
+        return ++levels < kWarmLevels;
+    };
+    visitLiquidity(buy_orders_by_price_, BUY, sweep);
+    levels = 0;
+    visitLiquidity(sell_orders_by_price_, SELL, sweep);
+
+    // The first trigger level on each side is checked after every trade
+    if (!buy_stops_by_trigger_.empty()) {
+        touched += buy_stops_by_trigger_.begin()->second.size();
+    }
+    if (!sell_stops_by_trigger_.empty()) {
+        touched += sell_stops_by_trigger_.begin()->second.size();
+    }
+    return touched;
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::mixHash(uint64_t value) {
+    // splitmix64 finalizer: every input bit affects every output bit
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::orderHash(
+    const Order& order) {
+    uint64_t hash = mixHash(order.getOrderId());
+    hash = mixHash(hash ^ (static_cast<uint64_t>(order.getPrice()) << 32 |
+                           order.getRemainingVolume()));
+    hash = mixHash(hash ^
+                   (static_cast<uint64_t>(order.getTriggerPrice()) << 32 |
+                    order.getVisibleVolume()));
+    hash = mixHash(hash ^ (static_cast<uint64_t>(order.getPegOffset()) << 32 |
+                           static_cast<uint64_t>(order.getPegType()) << 24 |
+                           static_cast<uint64_t>(order.getTimeInForce()) << 16 |
+                           static_cast<uint64_t>(order.getSide()) << 8 |
+                           order.getOrderType()));
+    hash = mixHash(hash ^ order.getExpireTime());
+    return hash;
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::levelHash(
+    Side side, Price price, const Level& level) {
+    // An empty (or not yet created) level contributes nothing
+    if (level.orders.empty()) {
+        return 0;
+    }
+
+    uint64_t hash = mixHash(static_cast<uint64_t>(side) << 32 | price);
+    hash = mixHash(hash ^ (static_cast<uint64_t>(level.total_volume) << 32 |
+                           level.hidden_volume));
+    hash = mixHash(hash ^ level.orders.size());
+    return hash;
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::linkHash(
+    const Order& ahead, const Order& behind) {
+    // One term per pair of neighbours: the same orders in another time
+    // priority leave a different set of pairs
+    return mixHash(mixHash(~ahead.getOrderId()) ^ behind.getOrderId());
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::queueHash(
+    const Level& level) {
+    uint64_t hash = 0;
+    for (size_t i = 1; i < level.orders.size(); i++) {
+        hash += linkHash(*level.orders[i - 1], *level.orders[i]);
+    }
+    return hash;
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::GetStateHash() const {
+    return state_hash_;
+}
+
+template <typename MatchingPolicy, typename Containers>
+double BasicOrderBook<MatchingPolicy, Containers>::GetIndexLoadFactor() const {
+    // Entries per bucket (both tables while a compaction is draining)
+    return static_cast<double>(orders_by_id_.Size()) /
+           static_cast<double>(orders_by_id_.BucketCount());
+}
+
+template <typename MatchingPolicy, typename Containers>
+RejectReason
+BasicOrderBook<MatchingPolicy, Containers>::GetLastRejectReason() const {
+    return last_reject_reason_;
+}
+
+template <typename MatchingPolicy, typename Containers>
+bool BasicOrderBook<MatchingPolicy, Containers>::ContainsOrder(
+    OrderID orderId) const {
+    return orders_by_id_.Contains(orderId);
+}
+
+template <typename MatchingPolicy, typename Containers>
+Volume BasicOrderBook<MatchingPolicy, Containers>::GetVolumeAtPrice(
+    Price price, Side side) const {
+    Price tick = 0;
+    if (ticks_.ToTick(price, tick) != NOT_REJECTED) {
+        return 0;
+    }
+
+    if (side == BUY) {
+        auto it = buy_orders_by_price_.find(tick);
+        if (it != buy_orders_by_price_.end()) {
+            return it->second.total_volume;
+        }
+    } else {
+        auto it = sell_orders_by_price_.find(tick);
+        if (it != sell_orders_by_price_.end()) {
+            return it->second.total_volume;
+        }
+    }
+
+    return 0;
+}
+
+template <typename MatchingPolicy, typename Containers>
+Volume BasicOrderBook<MatchingPolicy, Containers>::GetDisplayedVolumeAtPrice(
+    Price price, Side side) const {
+    return GetVolumeAtPrice(price, side) - GetHiddenVolumeAtPrice(price, side);
+}
+
+template <typename MatchingPolicy, typename Containers>
+Volume BasicOrderBook<MatchingPolicy, Containers>::GetHiddenVolumeAtPrice(
+    Price price, Side side) const {
+    Price tick = 0;
+    if (ticks_.ToTick(price, tick) != NOT_REJECTED) {
+        return 0;
+    }
+
+    if (side == BUY) {
+        auto it = buy_orders_by_price_.find(tick);
+        if (it != buy_orders_by_price_.end()) {
+            return it->second.hidden_volume;
+        }
+    } else {
+        auto it = sell_orders_by_price_.find(tick);
+        if (it != sell_orders_by_price_.end()) {
+            return it->second.hidden_volume;
+        }
+    }
+
+    return 0;
+}
+
+template <typename MatchingPolicy, typename Containers>
+Volume BasicOrderBook<MatchingPolicy, Containers>::GetPeggedVolume(
+    Side side) const {
+    Volume volume = 0;
+    for (const PegLevels& pegs : side == BUY ? buy_pegs_ : sell_pegs_) {
+        for (const auto& [offset, level] : pegs) {
+            volume += level.total_volume;
+        }
+    }
+    return volume;
+}
+
+template <typename MatchingPolicy, typename Containers>
+Price BasicOrderBook<MatchingPolicy, Containers>::GetPegPrice(PegType peg,
+                                                              Side side) const {
+    // Where a zero-offset pegged order would trade now (0 without reference)
+    Price tick = 0;
+    if (peg == NO_PEG || !pegPrice(side, peg, 0, tick)) {
+        return 0;
+    }
+    return ticks_.ToPrice(tick);
+}
+
+template <typename MatchingPolicy, typename Containers>
+uint64_t BasicOrderBook<MatchingPolicy, Containers>::GetAvailableVolume(
+    Side side, Price limit_price) const {
+    // Resting volume an order on this side limited at limit_price could fill
+    // now (off-grid limits round to the tick they allow)
+    const InstrumentConfig& config = ticks_.GetConfig();
+    if (side == BUY) {
+        if (limit_price < config.min_price) {
+            return 0;
+        }
+        return availableVolume(BUY, true, ticks_.FloorTick(limit_price),
+                               UINT64_MAX);
+    }
+    if (limit_price > config.max_price) {
+        return 0;
+    }
+    return availableVolume(SELL, true, ticks_.CeilTick(limit_price),
+                           UINT64_MAX);
+}
+
+template <typename MatchingPolicy, typename Containers>
+FillCost BasicOrderBook<MatchingPolicy, Containers>::GetCostToFill(
+    Side side, uint64_t volume) const {
+    // What a market order of this size would pay (or receive) right now
+    FillCost cost;
+    if (volume == 0) {
+        return cost;
+    }
+    auto fill_level = [&](Price tick, Volume level_volume) {
+        uint64_t taken = min<uint64_t>(level_volume, volume - cost.volume);
+        Price price = ticks_.ToPrice(tick);
+        cost.volume += taken;
+        cost.notional += taken * price;
+        cost.worst_price = price;
+        return cost.volume < volume;
+    };
+    if (side == BUY) {
+        visitLiquidity(sell_orders_by_price_, SELL, fill_level);
+    } else {
+        visitLiquidity(buy_orders_by_price_, BUY, fill_level);
+    }
+    return cost;
+}
+
+template <typename MatchingPolicy, typename Containers>
+vector<DepthLevel> BasicOrderBook<MatchingPolicy, Containers>::GetDepth(
+    Side side, size_t max_levels) const {
+    // Best first; pegged orders are not displayed and not included
+    vector<DepthLevel> depth;
+    auto add_levels = [&](const auto& book) {
+        for (const auto& [tick, level] : book) {
+            if (depth.size() == max_levels) {
+                break;
+            }
+            depth.push_back(DepthLevel{
+                .price = ticks_.ToPrice(tick),
+                .volume = level.total_volume,
+                .hidden_volume = level.hidden_volume,
+                .orders = static_cast<uint32_t>(level.orders.size())});
+        }
+    };
+    if (side == BUY) {
+        add_levels(buy_orders_by_price_);
+    } else {
+        add_levels(sell_orders_by_price_);
+    }
+    return depth;
+}
+
+template <typename MatchingPolicy, typename Containers>
+void BasicOrderBook<MatchingPolicy, Containers>::GetOrderBookStats() const {
+    cout << "Order Book Stats:\n";
+    cout << "Buy Side:\n";
+    for (const auto& [price, level] : buy_orders_by_price_) {
+        cout << "Price: " << ticks_.ToPrice(price)
+             << ", Total Volume: " << level.total_volume
+             << ", Hidden Volume: " << level.hidden_volume
+             << ", Orders: " << level.orders.size() << "\n";
+    }
+
+    cout << "Sell Side:\n";
+    for (const auto& [price, level] : sell_orders_by_price_) {
+        cout << "Price: " << ticks_.ToPrice(price)
+             << ", Total Volume: " << level.total_volume
+             << ", Hidden Volume: " << level.hidden_volume
+             << ", Orders: " << level.orders.size() << "\n";
+    }
+}
+
+template class BasicOrderBook<FifoMatching>;
+template class BasicOrderBook<ProRataMatching>;
+template class BasicOrderBook<FifoProRataMatching>;
+
+// Container variants of the FIFO book (benchmark_engine --all-containers)
+template class BasicOrderBook<
+    FifoMatching, BookContainers<MapLevels, DequeQueue, PooledHashIndex>>;
+template class BasicOrderBook<
+    FifoMatching, BookContainers<MapLevels, RingQueue, HashIndex>>;
+template class BasicOrderBook<
+    FifoMatching, BookContainers<MapLevels, RingQueue, PooledHashIndex>>;
+template class BasicOrderBook<
+    FifoMatching, BookContainers<PooledMapLevels, DequeQueue, HashIndex>>;
+template class BasicOrderBook<
+    FifoMatching, BookContainers<PooledMapLevels, DequeQueue, PooledHashIndex>>;
+template class BasicOrderBook<
+    FifoMatching, BookContainers<PooledMapLevels, RingQueue, HashIndex>>;
+template class BasicOrderBook<
+    FifoMatching, BookContainers<PooledMapLevels, RingQueue, PooledHashIndex>>;
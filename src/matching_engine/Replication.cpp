@@ -0,0 +1,397 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <new>
+#include <stdexcept>
+
+#include "common/Types.hpp"
+#include "matching_engine/Replication.hpp"
+
+using namespace std;
+
+// Longest the primary waits on a full ring before it detaches the standby
+const uint64_t kMaxPublishWaitNs = 1'000'000;  // 1 ms
+
+// Monotonic clock; CLOCK_MONOTONIC is shared by all processes on the host,
+// so publish and apply timestamps from both sides are comparable
+static uint64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Shared memory segment implementations
+
+SharedMemorySegment::SharedMemorySegment(const string& name, size_t size,
+                                         bool create)
+    : name_(name), size_(size), owner_(create) {
+    int flags = create ? (O_CREAT | O_RDWR | O_TRUNC) : O_RDWR;
+    int fd = shm_open(name_.c_str(), flags, 0600);
+    if (fd < 0) {
+        throw runtime_error("Cannot open shared memory segment " + name_);
+    }
+
+    struct stat segment_stat {};
+    bool sized = create ? ftruncate(fd, static_cast<off_t>(size_)) == 0
+                        : fstat(fd, &segment_stat) == 0 &&
+                              static_cast<size_t>(segment_stat.st_size) >=
+                                  size_;
+    if (sized) {
+        address_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+    }
+    close(fd);
+
+    if (!sized || address_ == MAP_FAILED) {
+        address_ = nullptr;
+        if (owner_) {
+            shm_unlink(name_.c_str());
+        }
+        throw runtime_error("Cannot map shared memory segment " + name_);
+    }
+}
+
+SharedMemorySegment::~SharedMemorySegment() {
+    munmap(address_, size_);
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+void* SharedMemorySegment::GetAddress() const {
+    return address_;
+}
+
+// Primary implementations
+
+PrimaryBook::PrimaryBook(const string& channel_name,
+                         const InstrumentConfig& config)
+    : segment_(channel_name, sizeof(ReplicationChannel), true),
+      channel_(new (segment_.GetAddress()) ReplicationChannel()),
+      book_(config) {
+    channel_->config = config;
+    Heartbeat();
+}
+
+bool PrimaryBook::publish(CommandType type, const Order& order,
+                          Timestamp time, Price to_price) {
+    uint32_t state = channel_->state.load(memory_order_acquire);
+    if (state == STANDBY_DETACHED) {
+        return true;  // keep trading, unreplicated
+    }
+    if (state != PRIMARY_ACTIVE) {
+        return false;  // fenced
+    }
+
+    uint64_t now = nowNs();
+    Command command{.sequence = sequence_ + 1,
+                    .publish_time_ns = now,
+                    .type = type,
+                    .order = order,
+                    .time = time,
+                    .to_price = to_price};
+
+    // The standby must see every command, so a full ring applies
+    // backpressure; a standby that stops consuming altogether is detached
+    // rather than stalling the primary
+    while (!channel_->commands.TryPush(command)) {
+        if (nowNs() - now >= kMaxPublishWaitNs) {
+            if (channel_->state.compare_exchange_strong(
+                    state, STANDBY_DETACHED, memory_order_acq_rel)) {
+                return true;
+            }
+            return state == STANDBY_DETACHED;  // false if promoted meanwhile
+        }
+    }
+
+    // The command only counts once the published sequence moves past it. A
+    // promoting standby freezes that word before its last drain, so a
+    // command is either committed here and applied by the standby, or
+    // refused here and never applied there.
+    uint64_t expected = sequence_;
+    if (!channel_->published_sequence.compare_exchange_strong(
+            expected, sequence_ + 1, memory_order_acq_rel)) {
+        return false;  // fenced
+    }
+    sequence_++;
+    channel_->primary_heartbeat_ns.store(now, memory_order_relaxed);
+    return true;
+}
+
+vector<Trade> PrimaryBook::PlaceOrder(const Order& order) {
+    if (!publish(PLACE_ORDER, order)) {
+        return {};
+    }
+    return book_.PlaceOrder(order);
+}
+
+void PrimaryBook::CancelOrder(OrderID orderId) {
+    if (publish(CANCEL_ORDER, Order(0, BUY, CANCEL, 0, 0, orderId))) {
+        book_.CancelOrder(orderId);
+    }
+}
+
+void PrimaryBook::StartAuction() {
+    if (publish(START_AUCTION, Order())) {
+        book_.StartAuction();
+    }
+}
+
+vector<Trade> PrimaryBook::Uncross() {
+    if (!publish(UNCROSS, Order())) {
+        return {};
+    }
+    return book_.Uncross();
+}
+
+vector<Trade> PrimaryBook::ProcessTriggeredStops() {
+    if (!publish(PROCESS_STOPS, Order())) {
+        return {};
+    }
+    return book_.ProcessTriggeredStops();
+}
+
+vector<OrderID> PrimaryBook::AdvanceTime(Timestamp now) {
+    if (!publish(ADVANCE_TIME, Order(), now)) {
+        return {};
+    }
+    return book_.AdvanceTime(now);
+}
+
+void PrimaryBook::SetSessionEnd(Timestamp session_end) {
+    if (publish(SET_SESSION_END, Order(), session_end)) {
+        book_.SetSessionEnd(session_end);
+    }
+}
+
+RangeCancelReport PrimaryBook::CancelRange(Side side, Price from_price,
+                                           Price to_price) {
+    if (!publish(CANCEL_RANGE, Order(0, side, CANCEL, from_price, 0), 0,
+                 to_price)) {
+        return {};
+    }
+    return book_.CancelRange(side, from_price, to_price);
+}
+
+RangeCancelReport PrimaryBook::CancelWorseThan(Side side, Price price) {
+    if (!publish(CANCEL_WORSE_THAN, Order(0, side, CANCEL, price, 0))) {
+        return {};
+    }
+    return book_.CancelWorseThan(side, price);
+}
+
+vector<Trade> PrimaryBook::MassQuote(ParticipantID participant_id,
+                                     const vector<QuoteEntry>& entries) {
+    // One command per leg, then the quote itself; the standby applies
+    // nothing until the last one, so a fenced quote is applied nowhere
+    for (const QuoteEntry& entry : entries) {
+        Order leg(entry.order_id, entry.side, LIMIT, entry.price,
+                  entry.volume);
+        if (!publish(QUOTE_LEG, leg)) {
+            return {};
+        }
+    }
+    Order quote;
+    quote.setParticipantId(participant_id);
+    if (!publish(MASS_QUOTE, quote)) {
+        return {};
+    }
+    return book_.MassQuote(participant_id, entries);
+}
+
+void PrimaryBook::Heartbeat() {
+    channel_->primary_heartbeat_ns.store(nowNs(), memory_order_release);
+}
+
+void PrimaryBook::RequestHandover() {
+    // Publish the final state hash first, so the standby can verify it
+    // before taking over
+    channel_->primary_state_hash.store(book_.GetStateHash(),
+                                       memory_order_relaxed);
+    uint32_t expected = PRIMARY_ACTIVE;
+    channel_->state.compare_exchange_strong(expected, HANDOVER_REQUESTED,
+                                            memory_order_release);
+}
+
+bool PrimaryBook::IsFenced() const {
+    uint32_t state = channel_->state.load(memory_order_acquire);
+    return state == HANDOVER_REQUESTED || state == STANDBY_PROMOTED;
+}
+
+ReplicationLag PrimaryBook::GetStandbyLag() const {
+    return ReplicationLag{
+        .sequences_behind =
+            sequence_ - channel_->applied_sequence.load(memory_order_acquire),
+        .apply_delay_ns = channel_->apply_delay_ns.load(memory_order_relaxed)};
+}
+
+bool PrimaryBook::IsStandbyInSync() const {
+    return channel_->applied_sequence.load(memory_order_acquire) ==
+               sequence_ &&
+           channel_->applied_state_hash.load(memory_order_relaxed) ==
+               book_.GetStateHash();
+}
+
+const OrderBook& PrimaryBook::GetBook() const {
+    return book_;
+}
+
+// Standby implementations
+
+StandbyBook::StandbyBook(const string& channel_name)
+    : segment_(channel_name, sizeof(ReplicationChannel), false),
+      channel_(readyChannel(segment_)),
+      book_(channel_->config) {}
+
+ReplicationChannel* StandbyBook::readyChannel(
+    const SharedMemorySegment& segment) {
+    // The segment can exist before the primary has filled it in
+    auto* channel = static_cast<ReplicationChannel*>(segment.GetAddress());
+    if (channel->primary_heartbeat_ns.load(memory_order_acquire) == 0) {
+        throw runtime_error("Replication channel is not initialised yet");
+    }
+    return channel;
+}
+
+void StandbyBook::apply(const Command& command) {
+    if (command.sequence != applied_sequence_ + 1) {
+        throw runtime_error("Replication sequence gap after " +
+                            to_string(applied_sequence_));
+    }
+
+    switch (command.type) {
+        case PLACE_ORDER:
+            book_.PlaceOrder(command.order);
+            break;
+        case CANCEL_ORDER:
+            book_.CancelOrder(command.order.getCancelOrderId());
+            break;
+        case START_AUCTION:
+            book_.StartAuction();
+            break;
+        case UNCROSS:
+            book_.Uncross();
+            break;
+        case PROCESS_STOPS:
+            book_.ProcessTriggeredStops();
+            break;
+        case ADVANCE_TIME:
+            book_.AdvanceTime(command.time);
+            break;
+        case SET_SESSION_END:
+            book_.SetSessionEnd(command.time);
+            break;
+        case CANCEL_RANGE:
+            book_.CancelRange(command.order.getSide(),
+                              command.order.getPrice(), command.to_price);
+            break;
+        case CANCEL_WORSE_THAN:
+            book_.CancelWorseThan(command.order.getSide(),
+                                  command.order.getPrice());
+            break;
+        case QUOTE_LEG:
+            quote_legs_.push_back({.order_id = command.order.getOrderId(),
+                                   .side = command.order.getSide(),
+                                   .price = command.order.getPrice(),
+                                   .volume = command.order.getVolume()});
+            break;
+        case MASS_QUOTE:
+            book_.MassQuote(command.order.getParticipantId(), quote_legs_);
+            quote_legs_.clear();
+            break;
+    }
+    applied_sequence_ = command.sequence;
+}
+
+size_t StandbyBook::Poll(size_t max_commands) {
+    Command command;
+    size_t applied = 0;
+    uint64_t last_publish_time_ns = 0;
+
+    // Only committed commands are applied; the primary pushes a command
+    // before committing it and may still refuse it
+    uint64_t committed =
+        channel_->published_sequence.load(memory_order_acquire) &
+        ~kSequenceFrozen;
+    while (applied < max_commands && applied_sequence_ < committed) {
+        if (!channel_->commands.TryPop(command)) {
+            throw runtime_error("Replication ring is missing command " +
+                                to_string(applied_sequence_ + 1));
+        }
+        apply(command);
+        last_publish_time_ns = command.publish_time_ns;
+        applied++;
+    }
+
+    // Report progress back to the primary
+    if (applied > 0) {
+        channel_->apply_delay_ns.store(nowNs() - last_publish_time_ns,
+                                       memory_order_relaxed);
+        channel_->applied_state_hash.store(book_.GetStateHash(),
+                                           memory_order_relaxed);
+        channel_->applied_sequence.store(applied_sequence_,
+                                         memory_order_release);
+    }
+    return applied;
+}
+
+ReplicationLag StandbyBook::GetLag() const {
+    return ReplicationLag{
+        .sequences_behind =
+            (channel_->published_sequence.load(memory_order_acquire) &
+             ~kSequenceFrozen) -
+            applied_sequence_,
+        .apply_delay_ns = channel_->apply_delay_ns.load(memory_order_relaxed)};
+}
+
+uint64_t StandbyBook::GetPrimaryHeartbeatAge() const {
+    return nowNs() - channel_->primary_heartbeat_ns.load(memory_order_relaxed);
+}
+
+bool StandbyBook::IsHandoverRequested() const {
+    return channel_->state.load(memory_order_acquire) == HANDOVER_REQUESTED;
+}
+
+bool StandbyBook::Promote() {
+    // A detached standby has missed commands and must not take over
+    uint32_t previous = channel_->state.load(memory_order_acquire);
+    if (previous == STANDBY_DETACHED || previous == STANDBY_PROMOTED) {
+        return false;
+    }
+
+    // Fence the primary first, then freeze the published sequence so it
+    // can commit nothing more, and apply everything it committed
+    if (!channel_->state.compare_exchange_strong(previous, STANDBY_PROMOTED,
+                                                 memory_order_acq_rel)) {
+        return false;
+    }
+    channel_->published_sequence.fetch_or(kSequenceFrozen,
+                                          memory_order_acq_rel);
+    Poll();
+    quote_legs_.clear();  // legs of a quote the primary never applied
+    channel_->epoch.fetch_add(1, memory_order_release);
+
+    // On a planned handover the books must match exactly; a forced promotion
+    // (primary dead) has nothing to compare against
+    if (previous == HANDOVER_REQUESTED) {
+        verified_ = book_.GetStateHash() ==
+                    channel_->primary_state_hash.load(memory_order_relaxed);
+        return verified_;
+    }
+    return true;
+}
+
+bool StandbyBook::IsPromoted() const {
+    return channel_->state.load(memory_order_acquire) == STANDBY_PROMOTED;
+}
+
+bool StandbyBook::IsPromotionVerified() const {
+    return verified_;
+}
+
+OrderBook& StandbyBook::GetBook() {
+    return book_;
+}
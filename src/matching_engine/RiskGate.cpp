@@ -0,0 +1,276 @@
+#include <algorithm>
+
+#include "common/Types.hpp"
+#include "matching_engine/RiskGate.hpp"
+
+using namespace std;
+
+RiskGate::RiskGate(const RiskConfig& risk_config,
+                   const InstrumentConfig& config)
+    : book_(config), risk_config_(risk_config) {}
+
+Price RiskGate::valuationPrice(const Order& order) const {
+    // Orders without a price of their own are valued at the last trade
+    if (order.isPegged()) {
+        return reference_price_;
+    }
+    switch (order.getOrderType()) {
+        case LIMIT:
+        case STOP_LIMIT:
+            return order.getPrice();
+        case STOP:
+            return order.getTriggerPrice();
+        default:
+            return reference_price_;
+    }
+}
+
+RejectReason RiskGate::CheckOrder(const Order& order) const {
+    ParticipantID participant_id = order.getParticipantId();
+    if (participant_id >= participants_.size() ||
+        !participants_[participant_id].registered) {
+        return UNKNOWN_PARTICIPANT;
+    }
+    // A reused ID would overwrite the open order's counters
+    if (open_orders_.contains(order.getOrderId())) {
+        return DUPLICATE_ORDER_ID;
+    }
+
+    const ParticipantState& state = participants_[participant_id];
+    const RiskLimits& limits = state.limits;
+    Volume volume = order.getVolume();
+
+    if ((risk_config_.max_order_volume != 0 &&
+         volume > risk_config_.max_order_volume) ||
+        (limits.max_order_volume != 0 && volume > limits.max_order_volume)) {
+        return ORDER_TOO_LARGE;
+    }
+
+    // Only orders with a limit price of their own are collared
+    bool priced = !order.isPegged() && (order.getOrderType() == LIMIT ||
+                                        order.getOrderType() == STOP_LIMIT);
+    if (priced && risk_config_.price_collar != 0 && reference_price_ != 0) {
+        uint64_t price = order.getPrice();
+        uint64_t reference = reference_price_;
+        if (price + risk_config_.price_collar < reference ||
+            price > reference + risk_config_.price_collar) {
+            return OUTSIDE_PRICE_COLLAR;
+        }
+    }
+
+    if (limits.max_open_notional != 0 &&
+        state.open_notional + uint64_t{valuationPrice(order)} * volume >
+            limits.max_open_notional) {
+        return OPEN_NOTIONAL_LIMIT;
+    }
+
+    // The position if every open order on this side filled, this one too
+    if (limits.max_position != 0) {
+        int64_t worst_position =
+            order.getSide() == BUY
+                ? state.position + state.open_buy_volume + volume
+                : state.open_sell_volume + volume - state.position;
+        if (worst_position > limits.max_position) {
+            return POSITION_LIMIT;
+        }
+    }
+
+    return NOT_REJECTED;
+}
+
+void RiskGate::openOrder(const Order& order) {
+    OpenOrder open{.participant_id = order.getParticipantId(),
+                   .side = order.getSide(),
+                   .price = valuationPrice(order),
+                   .remaining = order.getRemainingVolume()};
+    ParticipantState& state = participants_[open.participant_id];
+    state.open_notional += uint64_t{open.price} * open.remaining;
+    (open.side == BUY ? state.open_buy_volume : state.open_sell_volume) +=
+        open.remaining;
+    open_orders_[order.getOrderId()] = open;
+    if (order.getOrderType() == STOP || order.getOrderType() == STOP_LIMIT) {
+        open_stops_.insert(order.getOrderId());
+    }
+}
+
+void RiskGate::releaseOrder(OrderID order_id) {
+    open_stops_.erase(order_id);
+    auto it = open_orders_.find(order_id);
+    if (it == open_orders_.end()) {
+        return;
+    }
+    const OpenOrder& open = it->second;
+    ParticipantState& state = participants_[open.participant_id];
+    state.open_notional -= uint64_t{open.price} * open.remaining;
+    (open.side == BUY ? state.open_buy_volume : state.open_sell_volume) -=
+        open.remaining;
+    open_orders_.erase(it);
+}
+
+void RiskGate::applyFill(OrderID order_id, Volume volume) {
+    auto it = open_orders_.find(order_id);
+    if (it == open_orders_.end()) {
+        return;
+    }
+    OpenOrder& open = it->second;
+    ParticipantState& state = participants_[open.participant_id];
+    state.open_notional -= uint64_t{open.price} * volume;
+    if (open.side == BUY) {
+        state.open_buy_volume -= volume;
+        state.position += volume;
+    } else {
+        state.open_sell_volume -= volume;
+        state.position -= volume;
+    }
+
+    open.remaining -= volume;
+    if (open.remaining == 0) {
+        open_orders_.erase(it);
+    }
+}
+
+void RiskGate::applyTrades(const vector<Trade>& trades) {
+    for (const Trade& trade : trades) {
+        applyFill(trade.buy_order_id, trade.volume);
+        applyFill(trade.sell_order_id, trade.volume);
+    }
+    if (!trades.empty()) {
+        reference_price_ = trades.back().price;
+    }
+
+    // A partly filled order that is not resting (a triggered stop, a market
+    // or IOC remainder) no longer counts as open
+    for (const Trade& trade : trades) {
+        for (OrderID order_id : {trade.buy_order_id, trade.sell_order_id}) {
+            if (open_orders_.contains(order_id) &&
+                !book_.ContainsOrder(order_id)) {
+                releaseOrder(order_id);
+            }
+        }
+    }
+}
+
+void RiskGate::releaseDepartedStops(const vector<Trade>& trades,
+                                    size_t parked_stops) {
+    // A triggered stop can leave the book without a fill of its own (a
+    // market stop into an empty side), so the stops the gate tracks are
+    // checked against the book whenever stops may have been injected: after
+    // a trade, or while earlier triggered stops were parked by the budget
+    if (open_stops_.empty() || (trades.empty() && parked_stops == 0)) {
+        return;
+    }
+    for (auto it = open_stops_.begin(); it != open_stops_.end();) {
+        if (book_.ContainsOrder(*it)) {
+            ++it;
+            continue;
+        }
+        OrderID order_id = *it;
+        it = open_stops_.erase(it);
+        releaseOrder(order_id);
+    }
+}
+
+vector<Trade> RiskGate::PlaceOrder(const Order& order) {
+    last_reject_reason_ = CheckOrder(order);
+    if (last_reject_reason_ != NOT_REJECTED) {
+        return {};
+    }
+
+    openOrder(order);
+    size_t parked_stops = book_.GetPendingStopCount();
+    vector<Trade> trades = book_.PlaceOrder(order);
+    last_reject_reason_ = book_.GetLastRejectReason();
+    applyTrades(trades);
+    releaseDepartedStops(trades, parked_stops);
+
+    // Rejected, killed or unfilled market remainders never rest
+    if (!book_.ContainsOrder(order.getOrderId())) {
+        releaseOrder(order.getOrderId());
+    }
+    return trades;
+}
+
+void RiskGate::CancelOrder(OrderID orderId) {
+    book_.CancelOrder(orderId);
+    if (!book_.ContainsOrder(orderId)) {
+        releaseOrder(orderId);
+    }
+}
+
+RangeCancelReport RiskGate::CancelRange(Side side, Price from_price,
+                                       Price to_price) {
+    RangeCancelReport report = book_.CancelRange(side, from_price, to_price);
+    for (OrderID order_id : report.order_ids) {
+        releaseOrder(order_id);
+    }
+    return report;
+}
+
+RangeCancelReport RiskGate::CancelWorseThan(Side side, Price price) {
+    RangeCancelReport report = book_.CancelWorseThan(side, price);
+    for (OrderID order_id : report.order_ids) {
+        releaseOrder(order_id);
+    }
+    return report;
+}
+
+vector<OrderID> RiskGate::AdvanceTime(Timestamp now) {
+    vector<OrderID> expired = book_.AdvanceTime(now);
+    for (OrderID order_id : expired) {
+        releaseOrder(order_id);
+    }
+    return expired;
+}
+
+void RiskGate::StartAuction() {
+    book_.StartAuction();
+}
+
+vector<Trade> RiskGate::ProcessTriggeredStops() {
+    size_t parked_stops = book_.GetPendingStopCount();
+    vector<Trade> trades = book_.ProcessTriggeredStops();
+    applyTrades(trades);
+    releaseDepartedStops(trades, parked_stops);
+    return trades;
+}
+
+vector<Trade> RiskGate::Uncross() {
+    size_t parked_stops = book_.GetPendingStopCount();
+    vector<Trade> trades = book_.Uncross();
+    applyTrades(trades);
+    releaseDepartedStops(trades, parked_stops);
+    return trades;
+}
+
+void RiskGate::SetParticipantLimits(ParticipantID participant_id,
+                                    const RiskLimits& limits) {
+    if (participant_id >= participants_.size()) {
+        participants_.resize(participant_id + 1);
+    }
+    participants_[participant_id].limits = limits;
+    participants_[participant_id].registered = true;
+}
+
+void RiskGate::SetReferencePrice(Price price) {
+    reference_price_ = price;
+}
+
+uint64_t RiskGate::GetOpenNotional(ParticipantID participant_id) const {
+    return participant_id < participants_.size()
+               ? participants_[participant_id].open_notional
+               : 0;
+}
+
+int64_t RiskGate::GetPosition(ParticipantID participant_id) const {
+    return participant_id < participants_.size()
+               ? participants_[participant_id].position
+               : 0;
+}
+
+RejectReason RiskGate::GetLastRejectReason() const {
+    return last_reject_reason_;
+}
+
+const OrderBook& RiskGate::GetBook() const {
+    return book_;
+}
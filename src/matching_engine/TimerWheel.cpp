@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <bit>
+
+#include "common/Types.hpp"
+#include "matching_engine/TimerWheel.hpp"
+
+using namespace std;
+
+TimerWheel::TimerWheel(Timestamp resolution_ns)
+    : resolution_ns_(max<Timestamp>(resolution_ns, 1)) {}
+
+size_t TimerWheel::digit(uint64_t tick, int level) const {
+    return (tick >> (level * kSlotBits)) & (kSlots - 1);
+}
+
+void TimerWheel::place(const Entry& entry) {
+    if (entry.tick <= current_tick_) {
+        overdue_.push_back(entry.order_id);
+        size_--;
+        return;
+    }
+
+    // The level is the highest tick digit that differs from the current tick:
+    // the entry moves down a level each time the wheel enters its slot
+    int level = (bit_width(entry.tick ^ current_tick_) - 1) / kSlotBits;
+    if (level >= kLevels) {
+        overflow_.push_back(entry);
+        overflow_first_tick_ = min(overflow_first_tick_, entry.tick);
+        return;
+    }
+
+    size_t slot = digit(entry.tick, level);
+    slots_[level][slot].push_back(entry);
+    occupied_[level][slot / 64] |= uint64_t{1} << (slot % 64);
+}
+
+int TimerWheel::nextOccupiedSlot(int level, size_t from) const {
+    for (size_t word = from / 64; word < kWords; word++) {
+        uint64_t bits = occupied_[level][word];
+        if (word == from / 64) {
+            bits &= ~uint64_t{0} << (from % 64);
+        }
+        if (bits != 0) {
+            return static_cast<int>(word * 64 + countr_zero(bits));
+        }
+    }
+    return -1;
+}
+
+uint64_t TimerWheel::nextEventTick() const {
+    // The first occupied slot ahead on the lowest level that has one; a lower
+    // level's slots always come before the next slot of the level above
+    for (int level = 0; level < kLevels; level++) {
+        int slot = nextOccupiedSlot(level, digit(current_tick_, level) + 1);
+        if (slot >= 0) {
+            int shift = (level + 1) * kSlotBits;
+            return (current_tick_ >> shift << shift) |
+                   static_cast<uint64_t>(slot) << (level * kSlotBits);
+        }
+    }
+
+    // Otherwise the rotation of the top level that holds the first overflow
+    if (!overflow_.empty()) {
+        int shift = kLevels * kSlotBits;
+        uint64_t next_rotation = ((current_tick_ >> shift) + 1) << shift;
+        return max(next_rotation, overflow_first_tick_ >> shift << shift);
+    }
+    return UINT64_MAX;
+}
+
+void TimerWheel::land(vector<OrderID>& due) {
+    // A new top-level rotation: bring in the overflow entries that fall in it
+    uint64_t rotation_mask = (uint64_t{1} << (kLevels * kSlotBits)) - 1;
+    if ((current_tick_ & rotation_mask) == 0 && !overflow_.empty()) {
+        vector<Entry> overflow;
+        overflow.swap(overflow_);
+        overflow_first_tick_ = UINT64_MAX;
+        for (const Entry& entry : overflow) {
+            place(entry);
+        }
+    }
+
+    // Entering a higher-level slot spreads its entries over the levels below
+    for (int level = kLevels - 1; level >= 1; level--) {
+        uint64_t lower_mask = (uint64_t{1} << (level * kSlotBits)) - 1;
+        if ((current_tick_ & lower_mask) != 0) {
+            continue;
+        }
+        size_t slot = digit(current_tick_, level);
+        vector<Entry> entries;
+        entries.swap(slots_[level][slot]);
+        occupied_[level][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+        for (const Entry& entry : entries) {
+            place(entry);
+        }
+    }
+
+    // Everything in the current level-0 slot expires at exactly this tick
+    size_t slot = digit(current_tick_, 0);
+    vector<Entry>& entries = slots_[0][slot];
+    for (const Entry& entry : entries) {
+        due.push_back(entry.order_id);
+    }
+    size_ -= entries.size();
+    entries.clear();
+    occupied_[0][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+}
+
+void TimerWheel::Schedule(OrderID order_id, Timestamp expire_time) {
+    // Round up, so an order never expires before its expire time
+    uint64_t tick = expire_time / resolution_ns_ +
+                    (expire_time % resolution_ns_ != 0 ? 1 : 0);
+    size_++;
+    place(Entry{.order_id = order_id, .tick = tick});
+}
+
+void TimerWheel::Advance(Timestamp now, vector<OrderID>& due) {
+    uint64_t target = now / resolution_ns_;
+    while (current_tick_ < target) {
+        uint64_t next = size_ == 0 ? UINT64_MAX : nextEventTick();
+        if (next > target) {
+            current_tick_ = target;
+            break;
+        }
+        current_tick_ = next;
+        land(due);
+    }
+
+    // Entries scheduled in the past, or cascaded onto the current tick
+    due.insert(due.end(), overdue_.begin(), overdue_.end());
+    overdue_.clear();
+}
+
+size_t TimerWheel::Size() const {
+    return size_ + overdue_.size();
+}
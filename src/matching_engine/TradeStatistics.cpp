@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "common/Types.hpp"
+#include "matching_engine/TradeStatistics.hpp"
+
+using namespace std;
+
+TradeStatistics::TradeStatistics(Timestamp bar_interval_ns)
+    : bar_interval_ns_(max<Timestamp>(bar_interval_ns, 1)) {}
+
+void TradeStatistics::RecordTrade(Timestamp now, Price price,
+                                  Volume volume) {
+    TradeSummary& summary = current_.summary;
+    uint64_t notional = uint64_t{price} * volume;
+    if (summary.trades == 0) {
+        summary.high = price;
+        summary.low = price;
+    }
+    summary.last = price;
+    summary.high = max(summary.high, price);
+    summary.low = min(summary.low, price);
+    summary.volume += volume;
+    summary.notional += notional;
+    summary.trades++;
+
+    // A fill in a later interval closes the current bar
+    Timestamp start = now - now % bar_interval_ns_;
+    Bar& bar = current_.bar;
+    if (bar.trades != 0 && start != bar.start) {
+        closed_[current_.closed_bars % kBarHistory].Store(bar);
+        current_.closed_bars++;
+        bar = Bar();
+    }
+    if (bar.trades == 0) {
+        bar.start = start;
+        bar.open = price;
+        bar.high = price;
+        bar.low = price;
+    }
+    bar.high = max(bar.high, price);
+    bar.low = min(bar.low, price);
+    bar.close = price;
+    bar.volume += volume;
+    bar.notional += notional;
+    bar.trades++;
+
+    dirty_ = true;
+}
+
+void TradeStatistics::Publish() {
+    if (dirty_) {
+        published_.Store(current_);
+        dirty_ = false;
+    }
+}
+
+void TradeStatistics::SetBarInterval(Timestamp bar_interval_ns) {
+    // Takes effect from the next fill; the open bar keeps its start time
+    bar_interval_ns_ = max<Timestamp>(bar_interval_ns, 1);
+}
+
+TradeSummary TradeStatistics::GetSummary() const {
+    return published_.Load().summary;
+}
+
+Bar TradeStatistics::GetCurrentBar() const {
+    return published_.Load().bar;
+}
+
+uint64_t TradeStatistics::GetClosedBarCount() const {
+    return published_.Load().closed_bars;
+}
+
+bool TradeStatistics::GetClosedBar(size_t age, Bar& bar) const {
+    // Only the last kBarHistory closed bars are kept
+    uint64_t closed_bars = GetClosedBarCount();
+    if (age >= closed_bars || age >= kBarHistory) {
+        return false;
+    }
+    bar = closed_[(closed_bars - 1 - age) % kBarHistory].Load();
+    return true;
+}
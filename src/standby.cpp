@@ -0,0 +1,73 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "matching_engine/Replication.hpp"
+
+using namespace std;
+
+const string kDefaultChannelName = "/order_book_replication";
+
+// Hot standby process: busy-polls the primary's command ring, applying every
+// command to its own book (configured like the primary's, from the channel),
+// and takes over when the primary hands over or stops sending heartbeats.
+// The primary must heartbeat while idle (see PrimaryBook::Heartbeat).
+int main(int argc, char* argv[]) {
+    string channel_name = argc > 1 ? argv[1] : kDefaultChannelName;
+
+    // Attaching is retried until the primary has created and initialised
+    // the channel
+    cout << "Waiting for primary on " << channel_name << "..." << "\n";
+    unique_ptr<StandbyBook> standby;
+    while (!standby) {
+        try {
+            standby = make_unique<StandbyBook>(channel_name);
+        } catch (const exception& e) {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+    }
+    cout << "Attached to primary" << "\n";
+
+    // Once attached, any error (a sequence gap) means this book has
+    // diverged from the primary and must not be used
+    try {
+        auto next_report = chrono::steady_clock::now();
+        while (true) {
+            standby->Poll();
+
+            if (standby->IsHandoverRequested() ||
+                standby->GetPrimaryHeartbeatAge() >
+                    kDefaultHeartbeatTimeoutNs) {
+                bool in_sync = standby->Promote();
+                if (!standby->IsPromoted()) {
+                    cerr << "Promotion refused: this standby was detached "
+                            "or has already been promoted"
+                         << "\n";
+                    return EXIT_FAILURE;
+                }
+                // Only a planned handover has a primary hash to compare
+                const char* state =
+                    standby->IsPromotionVerified() ? "verified"
+                    : in_sync ? "forced, unverified"
+                              : "diverged from the primary";
+                cout << "Promoted to primary (state " << state << ", hash "
+                     << standby->GetBook().GetStateHash() << ")" << "\n";
+                return in_sync ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+
+            // Lag report once per second
+            if (chrono::steady_clock::now() >= next_report) {
+                ReplicationLag lag = standby->GetLag();
+                cout << "- Lag: " << lag.sequences_behind
+                     << " commands, last apply delay " << lag.apply_delay_ns
+                     << " ns" << "\n";
+                next_report += chrono::seconds(1);
+            }
+        }
+    } catch (const exception& e) {
+        cerr << "Standby diverged from the primary: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
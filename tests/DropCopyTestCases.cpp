@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include "DropCopyTestCases.hpp"
+#include "TestUtils.hpp"
+#include "matching_engine/DropCopy.hpp"
+#include "matching_engine/OrderBook.hpp"
+
+using namespace std;
+
+// Records n one-lot fills, each with its own buy order ID
+static vector<Trade> recordFills(DropCopyWriter& writer, size_t n) {
+    vector<Trade> fills;
+    for (size_t i = 0; i < n; i++) {
+        fills.push_back(Trade{.buy_order_id = 1'000 + i,
+                              .sell_order_id = 7,
+                              .price = static_cast<Price>(100 + i % 5),
+                              .volume = 1});
+        writer.Record(fills.back());
+    }
+    return fills;
+}
+
+static void assertMatches(const vector<DropCopyRecord>& records,
+                          const vector<Trade>& trades) {
+    ASSERT_EQ(records.size(), trades.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        ASSERT_EQ(records[i].sequence, i + 1);
+        ASSERT_EQ(records[i].buy_order_id, trades[i].buy_order_id);
+        ASSERT_EQ(records[i].sell_order_id, trades[i].sell_order_id);
+        ASSERT_EQ(records[i].price, trades[i].price);
+        ASSERT_EQ(records[i].volume, trades[i].volume);
+        if (i > 0) {
+            ASSERT_TRUE(records[i].timestamp_ns >=
+                        records[i - 1].timestamp_ns);
+        }
+    }
+}
+
+void TestDropCopyRoundTrip(const string& path) {
+    OrderBook book;
+    DropCopyWriter writer(path);
+
+    book.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    book.PlaceOrder(createLimitOrder(SELL, 101, 10));
+    vector<Trade> trades = book.PlaceOrder(createLimitOrder(BUY, 101, 15));
+    writer.Record(trades);
+    writer.Record(vector<Trade>{});  // no fills, nothing recorded
+    vector<Trade> more = book.PlaceOrder(createMarketOrder(BUY, 5));
+    writer.Record(more);
+    trades.insert(trades.end(), more.begin(), more.end());
+    ASSERT_EQ(writer.GetSequence(), 3);
+    writer.Close();
+
+    vector<DropCopyRecord> records = ReadDropCopy(path);
+    remove(path.c_str());
+    assertMatches(records, trades);
+    // Fills of one message share its timestamp
+    ASSERT_EQ(records[0].timestamp_ns, records[1].timestamp_ns);
+
+    DropCopyStats stats = writer.GetStats();
+    ASSERT_EQ(stats.records, 3);
+    ASSERT_EQ(stats.errors, 0);
+    ASSERT_FALSE(stats.io_uring);
+    ASSERT_TRUE(stats.syncs >= 1);  // Close syncs what is left
+}
+
+void TestDropCopyIoUringBatches(const string& path) {
+    // Tiny batches: many writes, each with a linked sync
+    DropCopyOptions options{.sync = SYNC_EVERY_BATCH,
+                            .batch_bytes = 4 * sizeof(DropCopyRecord),
+                            .use_io_uring = true};
+    DropCopyWriter writer(path, options);
+    vector<Trade> trades = recordFills(writer, 1'000);
+    writer.Close();
+
+    vector<DropCopyRecord> records = ReadDropCopy(path);
+    remove(path.c_str());
+    assertMatches(records, trades);
+
+    DropCopyStats stats = writer.GetStats();
+    ASSERT_EQ(stats.records, 1'000);
+    ASSERT_EQ(stats.errors, 0);
+    ASSERT_TRUE(stats.writes >= 250);
+    ASSERT_EQ(stats.syncs, stats.writes);
+}
+
+void TestDropCopyWithoutSync(const string& path) {
+    DropCopyWriter writer(path, DropCopyOptions{.sync = SYNC_NONE});
+    vector<Trade> trades = recordFills(writer, 100'000);
+    writer.Close();
+
+    vector<DropCopyRecord> records = ReadDropCopy(path);
+    remove(path.c_str());
+    assertMatches(records, trades);
+    ASSERT_EQ(writer.GetStats().syncs, 0);
+}
+
+void TestDropCopyRejectsForeignFile(const string& path) {
+    FILE* file = fopen(path.c_str(), "wb");
+    fputs("not a drop copy", file);
+    fclose(file);
+
+    bool rejected = false;
+    try {
+        ReadDropCopy(path);
+    } catch (const runtime_error&) {
+        rejected = true;
+    }
+    remove(path.c_str());
+    ASSERT_TRUE(rejected);
+}
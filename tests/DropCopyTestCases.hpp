@@ -0,0 +1,9 @@
+#pragma once
+#include <string>
+
+using namespace std;
+
+void TestDropCopyRoundTrip(const string& path);
+void TestDropCopyIoUringBatches(const string& path);
+void TestDropCopyWithoutSync(const string& path);
+void TestDropCopyRejectsForeignFile(const string& path);
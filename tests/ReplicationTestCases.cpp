@@ -0,0 +1,194 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "ReplicationTestCases.hpp"
+#include "TestUtils.hpp"
+#include "matching_engine/Replication.hpp"
+
+using namespace std;
+
+void TestReplicationLockstep(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    primary.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    primary.PlaceOrder(createIcebergOrder(SELL, 101, 30, 10));
+    Order buy = createLimitOrder(BUY, 99, 10);
+    primary.PlaceOrder(buy);
+    primary.PlaceOrder(createMarketOrder(BUY, 15));
+    primary.CancelOrder(buy.getOrderId());
+    primary.StartAuction();
+    primary.PlaceOrder(createLimitOrder(BUY, 102, 20));
+    primary.Uncross();
+
+    ASSERT_EQ(standby.Poll(), 8);
+    ASSERT_EQ(standby.GetBook().GetStateHash(),
+              primary.GetBook().GetStateHash());
+    ASSERT_TRUE(primary.IsStandbyInSync());
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(101, SELL),
+              primary.GetBook().GetVolumeAtPrice(101, SELL));
+}
+
+void TestReplicationCarriesInstrumentConfig(const string& channel_name) {
+    // The standby builds its book from the config in the channel
+    PrimaryBook primary(channel_name, InstrumentConfig{.tick_size = 5,
+                                                       .min_price = 100,
+                                                       .max_price = 1000});
+    StandbyBook standby(channel_name);
+
+    primary.PlaceOrder(createLimitOrder(SELL, 105, 10));
+    primary.PlaceOrder(createLimitOrder(SELL, 107, 10));  // off tick
+    primary.PlaceOrder(createLimitOrder(BUY, 95, 10));    // below the band
+    primary.PlaceOrder(createLimitOrder(BUY, 100, 10));
+
+    ASSERT_EQ(standby.Poll(), 4);
+    ASSERT_EQ(standby.GetBook().GetStateHash(),
+              primary.GetBook().GetStateHash());
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(105, SELL), 10);
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(107, SELL), 0);
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(100, BUY), 10);
+}
+
+void TestReplicationRangeCancels(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    for (Price price = 95; price <= 105; price++) {
+        Side side = price < 100 ? BUY : SELL;
+        primary.PlaceOrder(createLimitOrder(side, price, 5));
+    }
+    RangeCancelReport report = primary.CancelRange(SELL, 104, 102);
+    ASSERT_EQ(report.levels, 3);
+    report = primary.CancelWorseThan(BUY, 97);
+    ASSERT_EQ(report.levels, 2);
+
+    ASSERT_EQ(standby.Poll(), 13);
+    ASSERT_TRUE(primary.IsStandbyInSync());
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(103, SELL), 0);
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(96, BUY), 0);
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(97, BUY), 5);
+}
+
+void TestReplicationMassQuotes(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    primary.MassQuote(7, {{101, BUY, 99, 10}, {102, SELL, 101, 10}});
+    primary.PlaceOrder(createLimitOrder(SELL, 99, 4));
+    primary.MassQuote(7, {{101, BUY, 98, 6}, {103, SELL, 102, 5}});
+    primary.MassQuote(7, {});  // pulls the whole quote
+
+    // Two legs and the quote, one order, two legs and the quote, the quote
+    ASSERT_EQ(standby.Poll(), 8);
+    ASSERT_TRUE(primary.IsStandbyInSync());
+    ASSERT_FALSE(standby.GetBook().ContainsOrder(101));
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(101, SELL), 0);
+}
+
+void TestReplicationLagReporting(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    for (int i = 0; i < 3; i++) {
+        primary.PlaceOrder(createLimitOrder(BUY, 100, 10));
+    }
+    ASSERT_EQ(primary.GetStandbyLag().sequences_behind, 3);
+    ASSERT_EQ(standby.GetLag().sequences_behind, 3);
+    ASSERT_FALSE(primary.IsStandbyInSync());
+
+    // Poll in bounded batches
+    ASSERT_EQ(standby.Poll(2), 2);
+    ASSERT_EQ(primary.GetStandbyLag().sequences_behind, 1);
+    ASSERT_EQ(standby.Poll(), 1);
+    ASSERT_EQ(standby.GetLag().sequences_behind, 0);
+    ASSERT_TRUE(primary.IsStandbyInSync());
+}
+
+void TestReplicationPlannedHandover(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    primary.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    primary.PlaceOrder(createLimitOrder(BUY, 100, 4));
+    primary.RequestHandover();
+    ASSERT_TRUE(primary.IsFenced());
+    ASSERT_TRUE(standby.IsHandoverRequested());
+
+    // A fenced primary no longer accepts orders
+    auto trades = primary.PlaceOrder(createLimitOrder(BUY, 100, 6));
+    ASSERT_EQ(trades.size(), 0);
+    ASSERT_EQ(primary.GetBook().GetVolumeAtPrice(100, SELL), 6);
+
+    // The standby drains the ring, verifies the final hash and takes over
+    ASSERT_TRUE(standby.Promote());
+    ASSERT_TRUE(standby.IsPromoted());
+    ASSERT_TRUE(standby.IsPromotionVerified());
+    trades = standby.GetBook().PlaceOrder(createLimitOrder(BUY, 100, 6));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(100, SELL), 0);
+}
+
+void TestReplicationForcedPromotion(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    primary.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ASSERT_FALSE(primary.IsFenced());
+
+    // Promotion without a handover fences the primary
+    ASSERT_TRUE(standby.Promote());
+    ASSERT_FALSE(standby.IsPromotionVerified());  // nothing to compare
+    ASSERT_TRUE(primary.IsFenced());
+    ASSERT_EQ(standby.GetBook().GetVolumeAtPrice(100, SELL), 10);
+
+    // Only one promotion per channel
+    ASSERT_FALSE(standby.Promote());
+}
+
+void TestReplicationPromotionDuringFlow(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    // The primary keeps sending while the standby takes over; every command
+    // the primary applied must reach the promoted book, and nothing else
+    atomic<bool> started{false};
+    thread sender([&]() {
+        for (int i = 0; i < 200'000 && !primary.IsFenced(); i++) {
+            primary.PlaceOrder(
+                createLimitOrder(i % 2 == 0 ? BUY : SELL, 100 + i % 7, 1));
+            started.store(true, memory_order_relaxed);
+        }
+    });
+    while (!started.load(memory_order_relaxed)) {
+        this_thread::yield();
+    }
+    standby.Poll(100);
+    ASSERT_TRUE(standby.Promote());
+    sender.join();
+
+    ASSERT_TRUE(primary.IsFenced());
+    ASSERT_EQ(standby.GetBook().GetStateHash(),
+              primary.GetBook().GetStateHash());
+}
+
+void TestReplicationDetachesStalledStandby(const string& channel_name) {
+    PrimaryBook primary(channel_name);
+    StandbyBook standby(channel_name);
+
+    // Fill the ring without consuming
+    for (size_t i = 0; i < kReplicationRingSize; i++) {
+        primary.PlaceOrder(createLimitOrder(BUY, 100, 1));
+    }
+
+    // The next command waits a bounded time, then trades unreplicated
+    auto start = chrono::steady_clock::now();
+    primary.PlaceOrder(createLimitOrder(BUY, 100, 1));
+    ASSERT_TRUE(chrono::steady_clock::now() - start < chrono::seconds(1));
+    ASSERT_EQ(primary.GetBook().GetVolumeAtPrice(100, BUY),
+              kReplicationRingSize + 1);
+    ASSERT_FALSE(primary.IsFenced());
+
+    // A detached standby may not take over
+    ASSERT_FALSE(standby.Promote());
+}
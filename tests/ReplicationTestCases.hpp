@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+using namespace std;
+
+void TestReplicationLockstep(const string& channel_name);
+void TestReplicationCarriesInstrumentConfig(const string& channel_name);
+void TestReplicationRangeCancels(const string& channel_name);
+void TestReplicationMassQuotes(const string& channel_name);
+void TestReplicationLagReporting(const string& channel_name);
+void TestReplicationPlannedHandover(const string& channel_name);
+void TestReplicationForcedPromotion(const string& channel_name);
+void TestReplicationPromotionDuringFlow(const string& channel_name);
+void TestReplicationDetachesStalledStandby(const string& channel_name);
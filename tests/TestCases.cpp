@@ -1,3 +1,14 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <thread>
+
 #include "TestCases.hpp"
 #include "TestUtils.hpp"
 
@@ -350,3 +361,2094 @@ void TestLargeVolumeArithmetic(OrderBook& ob) {
     ASSERT_EQ(trades[0].volume, large);
     ASSERT_EQ(ob.GetVolumeAtPrice(100, BUY), large);
 }
+
+void TestAuctionAccumulatesOrders(OrderBook& ob) {
+    ob.StartAuction();
+    ASSERT_TRUE(ob.IsInAuction());
+
+    // Crossing orders rest without matching during the auction
+    auto trades = ob.PlaceOrder(createLimitOrder(BUY, 101, 10));
+    ASSERT_EQ(trades.size(), 0);
+    trades = ob.PlaceOrder(createLimitOrder(SELL, 99, 10));
+    ASSERT_EQ(trades.size(), 0);
+
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, BUY), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, SELL), 10);
+}
+
+void TestAuctionUncrossMaxVolume(OrderBook& ob) {
+    ob.StartAuction();
+    Order buy1 = createLimitOrder(BUY, 102, 10);
+    ob.PlaceOrder(buy1);
+    ob.PlaceOrder(createLimitOrder(BUY, 100, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 99, 5));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 10));
+
+    // 10 executable at 101 and 102, both with a sell surplus of 5 -> lowest
+    AuctionResult indicative = ob.GetIndicativeUncross();
+    ASSERT_EQ(indicative.price, 101);
+    ASSERT_EQ(indicative.matched_volume, 10);
+    ASSERT_EQ(indicative.imbalance, -5);
+
+    auto trades = ob.Uncross();
+    ASSERT_FALSE(ob.IsInAuction());
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].price, 101);
+    ASSERT_EQ(trades[0].volume, 5);
+    ASSERT_EQ(trades[1].price, 101);
+    ASSERT_EQ(trades[1].volume, 5);
+    ASSERT_EQ(trades[0].buy_order_id, buy1.getOrderId());
+
+    ASSERT_FALSE(ob.ContainsOrder(buy1.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, BUY), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 5);
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, SELL), 0);
+}
+
+void TestAuctionReferencePriceTieBreak(OrderBook& ob) {
+    ob.StartAuction();
+    ob.PlaceOrder(createLimitOrder(BUY, 105, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+
+    // Same volume and no surplus at 100 and 105: closest to the midpoint wins
+    AuctionResult indicative = ob.GetIndicativeUncross();
+    ASSERT_EQ(indicative.price, 100);
+    ASSERT_EQ(indicative.matched_volume, 10);
+    ASSERT_EQ(indicative.imbalance, 0);
+
+    auto trades = ob.Uncross();
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].price, 100);
+}
+
+void TestAuctionNoCross(OrderBook& ob) {
+    ob.StartAuction();
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 10));
+
+    ASSERT_EQ(ob.GetIndicativeUncross().matched_volume, 0);
+
+    auto trades = ob.Uncross();
+    ASSERT_EQ(trades.size(), 0);
+    ASSERT_FALSE(ob.IsInAuction());
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, BUY), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 10);
+
+    // Continuous matching resumes after the auction
+    trades = ob.PlaceOrder(createLimitOrder(BUY, 101, 10));
+    ASSERT_EQ(trades.size(), 1);
+}
+
+void TestAuctionRejectsMarketOrders(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ob.StartAuction();
+
+    // A market order has no price to queue at for the uncross
+    Order market = createMarketOrder(BUY, 5);
+    auto trades = ob.PlaceOrder(market);
+    ASSERT_EQ(trades.size(), 0);
+    ASSERT_EQ(ob.GetLastRejectReason(), MARKET_IN_AUCTION);
+    ASSERT_FALSE(ob.ContainsOrder(market.getOrderId()));
+    ASSERT_EQ(ob.GetIndicativeUncross().matched_volume, 0);
+
+    // Limit orders still queue, and market orders trade again afterwards
+    ob.PlaceOrder(createLimitOrder(BUY, 100, 4));
+    ASSERT_EQ(ob.GetLastRejectReason(), NOT_REJECTED);
+    ob.Uncross();
+    trades = ob.PlaceOrder(createMarketOrder(BUY, 5));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].volume, 5);
+    ASSERT_EQ(ob.GetLastRejectReason(), NOT_REJECTED);
+}
+
+// Random crossed books; the uncross must equal an exhaustive search over
+// every level price in the crossed range under the same rules
+void TestAuctionUncrossMatchesBruteForce() {
+    mt19937 generator(5);
+    uniform_int_distribution<Price> price(95, 105);
+    uniform_int_distribution<Volume> volume(1, 20);
+
+    for (int round = 0; round < 500; round++) {
+        OrderBook book;
+        book.StartAuction();
+        map<Price, uint64_t> bids;
+        map<Price, uint64_t> asks;
+        for (int i = 0; i < 12; i++) {
+            Order order = createLimitOrder(generator() % 2 == 0 ? BUY : SELL,
+                                           price(generator), volume(generator));
+            book.PlaceOrder(order);
+            auto& side = order.getSide() == BUY ? bids : asks;
+            side[order.getPrice()] += order.getVolume();
+        }
+
+        AuctionResult expected{.price = 0, .matched_volume = 0, .imbalance = 0};
+        if (!bids.empty() && !asks.empty() &&
+            bids.rbegin()->first >= asks.begin()->first) {
+            Price low = asks.begin()->first;
+            Price high = bids.rbegin()->first;
+            vector<AuctionResult> candidates;
+            for (Price p = low; p <= high; p++) {
+                if (!bids.contains(p) && !asks.contains(p)) {
+                    continue;
+                }
+                uint64_t demand = 0;
+                uint64_t supply = 0;
+                for (auto [level, size] : bids) {
+                    demand += level >= p ? size : 0;
+                }
+                for (auto [level, size] : asks) {
+                    supply += level <= p ? size : 0;
+                }
+                candidates.push_back(
+                    {.price = p,
+                     .matched_volume = min(demand, supply),
+                     .imbalance = static_cast<int64_t>(demand) -
+                                  static_cast<int64_t>(supply)});
+            }
+
+            // Max volume, then min surplus, then pressure, then reference
+            uint64_t best = 0;
+            for (const AuctionResult& c : candidates) {
+                best = max(best, c.matched_volume);
+            }
+            erase_if(candidates, [best](const AuctionResult& c) {
+                return c.matched_volume != best;
+            });
+            int64_t surplus = INT64_MAX;
+            for (const AuctionResult& c : candidates) {
+                surplus = min(surplus, abs(c.imbalance));
+            }
+            erase_if(candidates, [surplus](const AuctionResult& c) {
+                return abs(c.imbalance) != surplus;
+            });
+            Price reference = low + (high - low) / 2;
+            expected = candidates.front();
+            if (ranges::all_of(candidates, [](const AuctionResult& c) {
+                    return c.imbalance > 0;
+                })) {
+                expected = candidates.back();
+            } else if (!ranges::all_of(candidates, [](const AuctionResult& c) {
+                           return c.imbalance < 0;
+                       })) {
+                for (const AuctionResult& c : candidates) {
+                    if (abs(static_cast<int64_t>(c.price) - reference) <
+                        abs(static_cast<int64_t>(expected.price) - reference)) {
+                        expected = c;
+                    }
+                }
+            }
+            if (best == 0) {
+                expected = {.price = 0, .matched_volume = 0, .imbalance = 0};
+            }
+        }
+
+        AuctionResult actual = book.GetIndicativeUncross();
+        ASSERT_EQ(actual.price, expected.price);
+        ASSERT_EQ(actual.matched_volume, expected.matched_volume);
+        ASSERT_EQ(actual.imbalance, expected.imbalance);
+    }
+}
+
+void TestStopOrderTriggers(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 102, 10));
+
+    Order stop = createStopOrder(BUY, 101, 5);
+    auto trades = ob.PlaceOrder(stop);
+    ASSERT_EQ(trades.size(), 0);
+    ASSERT_TRUE(ob.ContainsOrder(stop.getOrderId()));
+
+    // Trading at 100 does not reach the trigger
+    trades = ob.PlaceOrder(createMarketOrder(BUY, 10));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_TRUE(ob.ContainsOrder(stop.getOrderId()));
+
+    // A print at 101 fires the stop, which buys as a market order
+    trades = ob.PlaceOrder(createLimitOrder(BUY, 101, 5));
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[1].buy_order_id, stop.getOrderId());
+    ASSERT_EQ(trades[1].price, 101);
+    ASSERT_EQ(trades[1].volume, 5);
+    ASSERT_FALSE(ob.ContainsOrder(stop.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 0);
+}
+
+void TestStopLimitRestsAfterTrigger(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 5));
+
+    Order stop = createStopLimitOrder(SELL, 99, 98, 10);
+    ob.PlaceOrder(stop);
+    ASSERT_EQ(ob.GetVolumeAtPrice(98, SELL), 0);
+
+    // Print at 99 triggers the stop-limit, which finds no bids and rests
+    auto trades = ob.PlaceOrder(createMarketOrder(SELL, 5));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_TRUE(ob.ContainsOrder(stop.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(98, SELL), 10);
+}
+
+void TestTriggeredStopKeepsOwnerAndExpiry(OrderBook& ob) {
+    const Timestamp kMs = 1'000'000;
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 5));
+
+    Order stop = createStopLimitOrder(SELL, 99, 98, 10);
+    stop.setParticipantId(4);
+    stop.setTimeInForce(GTD, 5 * kMs);
+    ob.PlaceOrder(stop);
+    ASSERT_EQ(ob.GetScheduledExpiryCount(), 1);
+
+    // The stop-limit rests with its owner and its one expiry timer
+    ob.PlaceOrder(createMarketOrder(SELL, 5));
+    ASSERT_EQ(ob.GetVolumeAtPrice(98, SELL), 10);
+    ASSERT_EQ(ob.GetScheduledExpiryCount(), 1);
+    ASSERT_TRUE(ob.WatchQueuePosition(stop.getOrderId()));
+    vector<QueuePositionUpdate> updates = ob.TakeQueuePositionUpdates();
+    ASSERT_EQ(updates.size(), 1);
+    ASSERT_EQ(updates[0].participant_id, 4);
+
+    vector<OrderID> expired = ob.AdvanceTime(5 * kMs);
+    ASSERT_EQ(expired.size(), 1);
+    ASSERT_EQ(expired[0], stop.getOrderId());
+    ASSERT_EQ(ob.GetScheduledExpiryCount(), 0);
+}
+
+void TestCancelStopOrder(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 10));
+
+    Order stop = createStopOrder(BUY, 100, 5);
+    ob.PlaceOrder(stop);
+    ob.CancelOrder(stop.getOrderId());
+    ASSERT_FALSE(ob.ContainsOrder(stop.getOrderId()));
+
+    auto trades = ob.PlaceOrder(createLimitOrder(BUY, 100, 10));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 10);
+}
+
+void TestStopCascadeBudget(OrderBook& ob) {
+    ob.SetMaxStopCascade(1);
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 102, 10));
+
+    Order stop1 = createStopOrder(BUY, 100, 10);
+    Order stop2 = createStopOrder(BUY, 101, 10);
+    ob.PlaceOrder(stop1);
+    ob.PlaceOrder(stop2);
+
+    // The print at 100 fires stop1, whose print at 101 fires stop2; with a
+    // budget of one injection per call, stop2 is left pending
+    auto trades = ob.PlaceOrder(createLimitOrder(BUY, 100, 10));
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[1].buy_order_id, stop1.getOrderId());
+    ASSERT_EQ(ob.GetPendingStopCount(), 1);
+
+    trades = ob.ProcessTriggeredStops();
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].buy_order_id, stop2.getOrderId());
+    ASSERT_EQ(trades[0].price, 102);
+    ASSERT_EQ(ob.GetPendingStopCount(), 0);
+}
+
+void TestIcebergDisplaysPeakOnly(OrderBook& ob) {
+    ob.PlaceOrder(createIcebergOrder(BUY, 100, 50, 10));
+
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, BUY), 50);
+    ASSERT_EQ(ob.GetDisplayedVolumeAtPrice(100, BUY), 10);
+    ASSERT_EQ(ob.GetHiddenVolumeAtPrice(100, BUY), 40);
+}
+
+void TestIcebergReplenishLosesPriority(OrderBook& ob) {
+    Order iceberg = createIcebergOrder(SELL, 100, 30, 10);
+    Order plain = createLimitOrder(SELL, 100, 10);
+    ob.PlaceOrder(iceberg);
+    ob.PlaceOrder(plain);
+
+    // The iceberg's first slice fills, the refill queues behind the plain order
+    auto trades = ob.PlaceOrder(createLimitOrder(BUY, 100, 15));
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].sell_order_id, iceberg.getOrderId());
+    ASSERT_EQ(trades[0].volume, 10);
+    ASSERT_EQ(trades[1].sell_order_id, plain.getOrderId());
+    ASSERT_EQ(trades[1].volume, 5);
+
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 25);
+    ASSERT_EQ(ob.GetDisplayedVolumeAtPrice(100, SELL), 15);
+    ASSERT_EQ(ob.GetHiddenVolumeAtPrice(100, SELL), 10);
+
+    // A large order takes every slice in turn
+    trades = ob.PlaceOrder(createLimitOrder(BUY, 100, 25));
+    ASSERT_EQ(trades.size(), 3);
+    ASSERT_EQ(trades[0].sell_order_id, plain.getOrderId());
+    ASSERT_EQ(trades[1].sell_order_id, iceberg.getOrderId());
+    ASSERT_EQ(trades[2].sell_order_id, iceberg.getOrderId());
+    ASSERT_FALSE(ob.ContainsOrder(iceberg.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 0);
+}
+
+void TestIcebergAggressorRestsWithPeak(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 5));
+
+    Order iceberg = createIcebergOrder(BUY, 100, 30, 10);
+    auto trades = ob.PlaceOrder(iceberg);
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].volume, 5);
+
+    ASSERT_TRUE(ob.ContainsOrder(iceberg.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, BUY), 25);
+    ASSERT_EQ(ob.GetDisplayedVolumeAtPrice(100, BUY), 10);
+    ASSERT_EQ(ob.GetHiddenVolumeAtPrice(100, BUY), 15);
+}
+
+void TestCancelIceberg(OrderBook& ob) {
+    Order iceberg = createIcebergOrder(SELL, 100, 30, 10);
+    ob.PlaceOrder(iceberg);
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 5));
+
+    ob.CancelOrder(iceberg.getOrderId());
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 5);
+    ASSERT_EQ(ob.GetHiddenVolumeAtPrice(100, SELL), 0);
+}
+
+void TestStateHashRoundTrip(OrderBook& ob) {
+    ASSERT_EQ(ob.GetStateHash(), 0);
+
+    Order buy = createLimitOrder(BUY, 100, 10);
+    ob.PlaceOrder(buy);
+    ASSERT_TRUE(ob.GetStateHash() != 0);
+
+    ob.CancelOrder(buy.getOrderId());
+    ASSERT_EQ(ob.GetStateHash(), 0);
+
+    // Fills, iceberg refills and stops all leave no trace once gone
+    ob.PlaceOrder(createIcebergOrder(SELL, 100, 30, 10));
+    Order stop = createStopOrder(SELL, 90, 5);
+    ob.PlaceOrder(stop);
+    ob.PlaceOrder(createLimitOrder(BUY, 100, 30));
+    ob.CancelOrder(stop.getOrderId());
+    ASSERT_EQ(ob.GetStateHash(), 0);
+}
+
+void TestStateHashPathIndependent(OrderBook& ob) {
+    // Reach "sell 6 @ 100 from order 500" through a partial fill...
+    ob.PlaceOrder(Order(500, SELL, LIMIT, 100, 10));
+    ob.PlaceOrder(Order(501, BUY, MARKET, 0, 4));
+
+    // ...and directly on a second book
+    OrderBook replica;
+    replica.PlaceOrder(Order(500, SELL, LIMIT, 100, 6));
+    ASSERT_EQ(ob.GetStateHash(), replica.GetStateHash());
+
+    // Any divergence shows up
+    replica.PlaceOrder(Order(502, BUY, LIMIT, 99, 1));
+    ASSERT_TRUE(ob.GetStateHash() != replica.GetStateHash());
+    ob.PlaceOrder(Order(502, BUY, LIMIT, 99, 2));
+    ASSERT_TRUE(ob.GetStateHash() != replica.GetStateHash());
+}
+
+void TestStateHashCoversTimePriority(OrderBook& ob) {
+    // The same two asks, queued in the opposite order
+    ob.PlaceOrder(Order(600, SELL, LIMIT, 100, 5));
+    ob.PlaceOrder(Order(601, SELL, LIMIT, 100, 5));
+    OrderBook replica;
+    replica.PlaceOrder(Order(601, SELL, LIMIT, 100, 5));
+    replica.PlaceOrder(Order(600, SELL, LIMIT, 100, 5));
+    ASSERT_TRUE(ob.GetStateHash() != replica.GetStateHash());
+
+    // Once the queues agree again, so do the hashes
+    ob.CancelOrder(600);
+    replica.CancelOrder(600);
+    ASSERT_EQ(ob.GetStateHash(), replica.GetStateHash());
+
+    // Random flow through fills, iceberg re-queues, pegs and cancels from
+    // anywhere in a queue leaves nothing behind once every order is gone
+    OrderBook book;
+    default_random_engine generator(29);
+    uniform_int_distribution<int> kind_dist(0, 9);
+    uniform_int_distribution<Price> price_dist(97, 103);
+    uniform_int_distribution<Volume> volume_dist(1, 20);
+    vector<OrderID> ids;
+    for (int i = 0; i < 2'000; i++) {
+        Side side = i % 2 == 0 ? BUY : SELL;
+        Volume volume = volume_dist(generator);
+        int kind = kind_dist(generator);
+        Order order = createLimitOrder(side, price_dist(generator), volume);
+        if (kind == 0) {
+            order = createMarketOrder(side, volume);
+        } else if (kind == 1) {
+            order = createIcebergOrder(side, price_dist(generator),
+                                       volume * 3, volume);
+        } else if (kind == 2) {
+            order.setPeg(PEG_PRIMARY);
+        } else if (kind == 3 && !ids.empty()) {
+            book.CancelOrder(ids[uniform_int_distribution<size_t>(
+                0, ids.size() - 1)(generator)]);
+            continue;
+        }
+        book.PlaceOrder(order);
+        ids.push_back(order.getOrderId());
+    }
+    for (OrderID id : ids) {
+        book.CancelOrder(id);
+    }
+    ASSERT_EQ(book.GetStateHash(), 0);
+}
+
+void TestTickSizeRejectsOffTick(OrderBook& ob) {
+    // Book configured with a tick of 5 and a band of [100, 1000]
+    Order on_tick = createLimitOrder(BUY, 105, 10);
+    ob.PlaceOrder(on_tick);
+    ASSERT_EQ(ob.GetLastRejectReason(), NOT_REJECTED);
+    ASSERT_TRUE(ob.ContainsOrder(on_tick.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(105, BUY), 10);
+
+    Order off_tick = createLimitOrder(BUY, 107, 10);
+    ob.PlaceOrder(off_tick);
+    ASSERT_EQ(ob.GetLastRejectReason(), OFF_TICK);
+    ASSERT_FALSE(ob.ContainsOrder(off_tick.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(107, BUY), 0);
+
+    Order below_band = createLimitOrder(BUY, 95, 10);
+    ob.PlaceOrder(below_band);
+    ASSERT_EQ(ob.GetLastRejectReason(), OUTSIDE_PRICE_BAND);
+    ASSERT_FALSE(ob.ContainsOrder(below_band.getOrderId()));
+
+    Order off_tick_stop = createStopOrder(SELL, 101, 10);
+    ob.PlaceOrder(off_tick_stop);
+    ASSERT_EQ(ob.GetLastRejectReason(), OFF_TICK);
+    ASSERT_FALSE(ob.ContainsOrder(off_tick_stop.getOrderId()));
+}
+
+void TestTickSizeTradesReportPrices(OrderBook& ob) {
+    // Book configured with a tick of 5 and a band of [100, 1000]
+    ob.PlaceOrder(createLimitOrder(SELL, 120, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 125, 10));
+
+    auto trades = ob.PlaceOrder(createLimitOrder(BUY, 125, 15));
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].price, 120);
+    ASSERT_EQ(trades[1].price, 125);
+    ASSERT_EQ(ob.GetVolumeAtPrice(125, SELL), 5);
+
+    ob.StartAuction();
+    ob.PlaceOrder(createLimitOrder(BUY, 130, 5));
+    ASSERT_EQ(ob.GetIndicativeUncross().price, 125);
+    trades = ob.Uncross();
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].price, 125);
+}
+
+void TestTickConverterRoundTrip() {
+    // Power-of-ten tick takes the specialized path
+    TickConverter cents(InstrumentConfig{.tick_size = 100, .min_price = 0});
+    Price tick = 0;
+    ASSERT_EQ(cents.ToTick(12300, tick), NOT_REJECTED);
+    ASSERT_EQ(tick, 123);
+    ASSERT_EQ(cents.ToPrice(tick), 12300);
+    ASSERT_EQ(cents.ToTick(12350, tick), OFF_TICK);
+
+    // Any other tick takes the generic path
+    TickConverter nickels(InstrumentConfig{
+        .tick_size = 5, .min_price = 1000, .max_price = 2000});
+    ASSERT_EQ(nickels.ToTick(1015, tick), NOT_REJECTED);
+    ASSERT_EQ(tick, 3);
+    ASSERT_EQ(nickels.ToPrice(tick), 1015);
+    ASSERT_EQ(nickels.ToTick(1016, tick), OFF_TICK);
+    ASSERT_EQ(nickels.ToTick(2005, tick), OUTSIDE_PRICE_BAND);
+}
+
+void TestCancelRange(OrderBook& ob) {
+    vector<Order> bids;
+    for (Price price = 97; price <= 101; price++) {
+        bids.push_back(createLimitOrder(BUY, price, 10));
+        ob.PlaceOrder(bids.back());
+    }
+    Order extra = createLimitOrder(BUY, 99, 5);
+    ob.PlaceOrder(extra);
+
+    // Bounds may be given in either order
+    RangeCancelReport report = ob.CancelRange(BUY, 100, 98);
+    ASSERT_EQ(report.levels, 3);
+    ASSERT_EQ(report.volume, 35);
+    ASSERT_EQ(report.order_ids.size(), 4);
+    ASSERT_EQ(report.order_ids[0], bids[3].getOrderId());  // best price first
+    ASSERT_EQ(report.order_ids[2], extra.getOrderId());    // then time
+
+    ASSERT_FALSE(ob.ContainsOrder(extra.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, BUY), 0);
+    ASSERT_EQ(ob.GetVolumeAtPrice(97, BUY), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, BUY), 10);
+
+    // Cancelling what is left leaves an empty book and state hash
+    ob.CancelRange(BUY, 0, UINT32_MAX);
+    ASSERT_EQ(ob.GetStateHash(), 0);
+}
+
+void TestCancelWorseThan(OrderBook& ob) {
+    for (Price price = 100; price <= 104; price++) {
+        ob.PlaceOrder(createLimitOrder(SELL, price, 10));
+        ob.PlaceOrder(createLimitOrder(BUY, price - 10, 10));
+    }
+
+    // Asks above 102 and bids below 92 are pulled
+    RangeCancelReport asks = ob.CancelWorseThan(SELL, 102);
+    ASSERT_EQ(asks.levels, 2);
+    ASSERT_EQ(ob.GetVolumeAtPrice(102, SELL), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(103, SELL), 0);
+
+    RangeCancelReport bids = ob.CancelWorseThan(BUY, 92);
+    ASSERT_EQ(bids.levels, 2);
+    ASSERT_EQ(bids.volume, 20);
+    ASSERT_EQ(ob.GetVolumeAtPrice(91, BUY), 0);
+    ASSERT_EQ(ob.GetVolumeAtPrice(92, BUY), 10);
+
+    // Nothing worse left
+    ASSERT_EQ(ob.CancelWorseThan(SELL, 102).levels, 0);
+}
+
+void TestCancelWorseThanBandEdges(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 10));
+    ob.PlaceOrder(createLimitOrder(BUY, 90, 10));
+
+    // No price is worse than the top of the band, or below its bottom
+    ASSERT_EQ(ob.CancelWorseThan(SELL, UINT32_MAX).levels, 0);
+    ASSERT_EQ(ob.CancelWorseThan(BUY, 0).levels, 0);
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(90, BUY), 10);
+
+    OrderBook banded(
+        InstrumentConfig{.tick_size = 5, .min_price = 50, .max_price = 200});
+    banded.PlaceOrder(createLimitOrder(SELL, 200, 10));
+    ASSERT_EQ(banded.CancelWorseThan(SELL, 200).levels, 0);
+    ASSERT_EQ(banded.CancelWorseThan(SELL, 250).levels, 0);
+    ASSERT_EQ(banded.CancelWorseThan(SELL, 195).levels, 1);
+}
+
+void TestCompactionReleasesIdleMemory(OrderBook& ob) {
+    MemoryUsage empty = ob.GetMemoryUsage();
+
+    // A burst of resting orders, then everything is cancelled again
+    vector<Order> burst;
+    for (int i = 0; i < 20000; i++) {
+        burst.push_back(createLimitOrder(BUY, 100 + i % 50, 10));
+        ob.PlaceOrder(burst.back());
+    }
+    MemoryUsage busy = ob.GetMemoryUsage();
+    ASSERT_TRUE(busy.orders > 0 && busy.index > 0 && busy.levels > 0);
+
+    Order survivor = burst.back();
+    burst.pop_back();
+    for (const Order& order : burst) {
+        ob.CancelOrder(order.getOrderId());
+    }
+    MemoryUsage idle = ob.GetMemoryUsage();
+    ASSERT_TRUE(idle.orders < busy.orders);
+    ASSERT_TRUE(idle.overhead > busy.overhead);  // the index kept its buckets
+
+    // Small slices, so the pass takes several calls
+    int calls = 1;
+    while (!ob.Compact(1)) {
+        calls++;
+    }
+    ASSERT_TRUE(calls > 1);
+
+    MemoryUsage compacted = ob.GetMemoryUsage();
+    ASSERT_TRUE(compacted.Total() < idle.Total());
+    ASSERT_TRUE(compacted.overhead <= empty.overhead + 2048);
+    ASSERT_TRUE(ob.ContainsOrder(survivor.getOrderId()));
+}
+
+void TestCompactionInterleavedWithOrders(OrderBook& ob) {
+    // The same messages go to a book that is never compacted
+    OrderBook reference;
+    vector<Order> orders;
+    for (int i = 0; i < 5000; i++) {
+        orders.push_back(createLimitOrder(SELL, 200 + i % 20, 10));
+        ob.PlaceOrder(orders.back());
+        reference.PlaceOrder(orders.back());
+    }
+    for (size_t i = 0; i < orders.size(); i++) {
+        if (i % 10 != 1 && i % 10 != 3) {
+            ob.CancelOrder(orders[i].getOrderId());
+            reference.CancelOrder(orders[i].getOrderId());
+        }
+    }
+
+    // Orders arrive, cancel and trade while the index is half migrated
+    ASSERT_FALSE(ob.Compact(100));
+    Order late = createLimitOrder(SELL, 210, 7);
+    Order buy = createLimitOrder(BUY, 200, 25);
+    for (OrderBook* book : {&ob, &reference}) {
+        book->PlaceOrder(late);
+        book->CancelOrder(orders[1].getOrderId());
+        book->PlaceOrder(buy);
+    }
+    ASSERT_FALSE(ob.ContainsOrder(orders[1].getOrderId()));
+    ASSERT_TRUE(ob.ContainsOrder(orders[3].getOrderId()));
+    ASSERT_TRUE(ob.ContainsOrder(late.getOrderId()));
+
+    while (!ob.Compact(100)) {
+    }
+    ASSERT_EQ(ob.GetStateHash(), reference.GetStateHash());
+    ASSERT_EQ(ob.GetVolumeAtPrice(200, SELL),
+              reference.GetVolumeAtPrice(200, SELL));
+    ASSERT_EQ(ob.GetVolumeAtPrice(210, SELL), 7);
+}
+
+void TestConflatedSweepReports(OrderBook& ob) {
+    ob.SetReportMode(CONFLATED_REPORTS);
+    vector<Order> asks;
+    for (Price price : {100, 100, 100, 101, 101}) {
+        asks.push_back(createLimitOrder(SELL, price, 5));
+        ob.PlaceOrder(asks.back());
+    }
+
+    // One print per level for the aggressor
+    Order sweep = createMarketOrder(BUY, 25);
+    vector<Trade> trades = ob.PlaceOrder(sweep);
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].buy_order_id, sweep.getOrderId());
+    ASSERT_EQ(trades[0].sell_order_id, kConflatedOrderId);
+    ASSERT_EQ(trades[0].price, 100);
+    ASSERT_EQ(trades[0].volume, 15);
+    ASSERT_EQ(trades[1].price, 101);
+    ASSERT_EQ(trades[1].volume, 10);
+
+    // Every resting order's fill on the passive channel, once
+    vector<Trade> fills = ob.TakePassiveFills();
+    ASSERT_EQ(fills.size(), 5);
+    for (size_t i = 0; i < fills.size(); i++) {
+        ASSERT_EQ(fills[i].sell_order_id, asks[i].getOrderId());
+        ASSERT_EQ(fills[i].buy_order_id, sweep.getOrderId());
+        ASSERT_EQ(fills[i].volume, 5);
+    }
+    ASSERT_TRUE(ob.TakePassiveFills().empty());
+}
+
+void TestConflatedReportsMatchPerOrderBook(OrderBook& ob) {
+    OrderBook per_order;
+    ob.SetReportMode(CONFLATED_REPORTS);
+
+    vector<Order> orders;
+    for (Price price = 95; price <= 99; price++) {
+        orders.push_back(createLimitOrder(BUY, price, 10));
+        orders.push_back(createLimitOrder(BUY, price, 3));
+    }
+    orders.push_back(createLimitOrder(SELL, 96, 40));  // sweeps four levels
+
+    uint64_t per_order_volume = 0;
+    uint64_t conflated_volume = 0;
+    for (const Order& order : orders) {
+        for (const Trade& trade : per_order.PlaceOrder(order)) {
+            per_order_volume += trade.volume;
+        }
+        for (const Trade& trade : ob.PlaceOrder(order)) {
+            conflated_volume += trade.volume;
+        }
+    }
+
+    ASSERT_EQ(conflated_volume, per_order_volume);
+    ASSERT_EQ(ob.TakePassiveFills().size(), 7);
+    ASSERT_EQ(ob.GetStateHash(), per_order.GetStateHash());
+    ASSERT_EQ(ob.GetVolumeAtPrice(96, BUY), 12);
+}
+
+void TestGtdOrderExpires(OrderBook& ob) {
+    const Timestamp kMs = 1'000'000;
+    ob.AdvanceTime(1 * kMs);
+
+    Order gtd = createLimitOrder(BUY, 100, 10);
+    gtd.setTimeInForce(GTD, 5 * kMs);
+    Order gtc = createLimitOrder(BUY, 100, 7);
+    ob.PlaceOrder(gtd);
+    ob.PlaceOrder(gtc);
+
+    // Nothing expires before the expire time
+    ASSERT_TRUE(ob.AdvanceTime(5 * kMs - 1).empty());
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, BUY), 17);
+
+    vector<OrderID> expired = ob.AdvanceTime(5 * kMs);
+    ASSERT_EQ(expired.size(), 1);
+    ASSERT_EQ(expired[0], gtd.getOrderId());
+    ASSERT_FALSE(ob.ContainsOrder(gtd.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, BUY), 7);
+
+    // Same state as a book that only ever had the GTC order
+    OrderBook reference;
+    reference.PlaceOrder(gtc);
+    ASSERT_EQ(ob.GetStateHash(), reference.GetStateHash());
+
+    // An expire time that has already passed is rejected
+    Order late = createLimitOrder(SELL, 105, 10);
+    late.setTimeInForce(GTD, 5 * kMs);
+    ob.PlaceOrder(late);
+    ASSERT_EQ(ob.GetLastRejectReason(), ALREADY_EXPIRED);
+    ASSERT_FALSE(ob.ContainsOrder(late.getOrderId()));
+}
+
+void TestDayOrdersExpireAtSessionEnd(OrderBook& ob) {
+    const Timestamp kSessionEnd = 8ULL * 3600 * 1'000'000'000;
+    ob.SetSessionEnd(kSessionEnd);
+
+    vector<Order> orders;
+    for (int i = 0; i < 1000; i++) {
+        orders.push_back(createLimitOrder(SELL, 200 + i % 25, 10));
+        orders.back().setTimeInForce(DAY);
+        ob.PlaceOrder(orders.back());
+    }
+    Order stop = createStopOrder(BUY, 300, 5);
+    stop.setTimeInForce(DAY);
+    ob.PlaceOrder(stop);
+
+    // Orders that trade or are cancelled leave stale wheel entries behind
+    ob.PlaceOrder(createMarketOrder(BUY, 100));
+    ob.CancelOrder(orders[500].getOrderId());
+
+    ASSERT_TRUE(ob.AdvanceTime(kSessionEnd - 1).empty());
+    vector<OrderID> expired = ob.AdvanceTime(kSessionEnd);
+    ASSERT_EQ(expired.size(), 1000 - 10 - 1 + 1);  // filled, cancelled, stop
+    ASSERT_FALSE(ob.ContainsOrder(stop.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(210, SELL), 0);
+    ASSERT_EQ(ob.GetStateHash(), 0);
+    ASSERT_EQ(ob.GetScheduledExpiryCount(), 0);
+}
+
+void TestTimerWheelFiresOnTime() {
+    const Timestamp kResolution = 1'000'000;
+    TimerWheel wheel(kResolution);
+    default_random_engine generator(42);
+
+    // Expiries from microseconds to months ahead, so every level and the
+    // overflow list are used
+    Timestamp now = 1'700'000'000ULL * 1'000'000'000;
+    vector<OrderID> due;
+    wheel.Advance(now, due);
+    vector<Timestamp> expire_times;
+    for (OrderID id = 0; id < 20000; id++) {
+        int magnitude = uniform_int_distribution<int>(3, 16)(generator);
+        Timestamp delay = uniform_int_distribution<Timestamp>(
+            1, static_cast<Timestamp>(pow(10.0, magnitude)))(generator);
+        expire_times.push_back(now + delay);
+        wheel.Schedule(id, now + delay);
+    }
+
+    vector<int> fired(expire_times.size(), 0);
+    while (wheel.Size() > 0) {
+        Timestamp previous = now;
+        now += uniform_int_distribution<Timestamp>(1, 1ULL << 44)(generator);
+        due.clear();
+        wheel.Advance(now, due);
+        for (OrderID id : due) {
+            fired[id]++;
+            // Never early, and at most one resolution step late
+            ASSERT_TRUE(expire_times[id] <= now);
+            ASSERT_TRUE(previous < expire_times[id] + kResolution);
+        }
+    }
+    ASSERT_TRUE(ranges::all_of(fired, [](int count) { return count == 1; }));
+}
+
+void TestProRataSplitsByDisplayedSize() {
+    ProRataOrderBook ob;
+    vector<Order> asks;
+    for (Volume volume : {10, 30, 60}) {
+        asks.push_back(createLimitOrder(SELL, 100, volume));
+        ob.PlaceOrder(asks.back());
+    }
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 20));
+
+    // Each resting order gets its share of the level, in time order
+    vector<Trade> trades = ob.PlaceOrder(createMarketOrder(BUY, 50));
+    ASSERT_EQ(trades.size(), 3);
+    ASSERT_EQ(trades[0].sell_order_id, asks[0].getOrderId());
+    ASSERT_EQ(trades[0].volume, 5);
+    ASSERT_EQ(trades[1].volume, 15);
+    ASSERT_EQ(trades[2].volume, 30);
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 50);
+
+    // An order that takes the whole level fills it, then shares the next
+    trades = ob.PlaceOrder(createMarketOrder(BUY, 60));
+    ASSERT_EQ(trades.size(), 4);
+    ASSERT_EQ(trades[3].price, 101);
+    ASSERT_EQ(trades[3].volume, 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 0);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 10);
+}
+
+void TestProRataRoundingGoesToTimePriority() {
+    ProRataOrderBook ob;
+    vector<Order> bids;
+    for (int i = 0; i < 3; i++) {
+        bids.push_back(createLimitOrder(BUY, 100, 1));
+        ob.PlaceOrder(bids.back());
+    }
+
+    // Two lots over three equal orders: every share rounds down to zero, so
+    // both lots go to the oldest orders
+    vector<Trade> trades = ob.PlaceOrder(createMarketOrder(SELL, 2));
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].buy_order_id, bids[0].getOrderId());
+    ASSERT_EQ(trades[1].buy_order_id, bids[1].getOrderId());
+    ASSERT_TRUE(ob.ContainsOrder(bids[2].getOrderId()));
+
+    // Same book state as removing the two filled orders
+    OrderBook reference;
+    reference.PlaceOrder(bids[2]);
+    ASSERT_EQ(ob.GetStateHash(), reference.GetStateHash());
+}
+
+void TestFifoProRataSplit() {
+    FifoProRataOrderBook ob;
+    vector<Order> asks;
+    for (Volume volume : {50, 50, 100}) {
+        asks.push_back(createLimitOrder(SELL, 100, volume));
+        ob.PlaceOrder(asks.back());
+    }
+
+    // 40 lots FIFO to the oldest order, then 60 pro-rata over 10/50/100
+    // (3, 18 and 37), and the 2 rounding lots back to the oldest order
+    vector<Trade> trades = ob.PlaceOrder(createMarketOrder(BUY, 100));
+    ASSERT_EQ(trades.size(), 3);
+    ASSERT_EQ(trades[0].volume, 45);
+    ASSERT_EQ(trades[1].volume, 18);
+    ASSERT_EQ(trades[2].volume, 37);
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 100);
+}
+
+void TestProRataSharesExact() {
+    // Small levels take the double path, huge ones the integer path; both
+    // must give the exact floor of size * volume / total
+    mt19937_64 generator(3);
+    for (Volume max_size : {Volume{1'000}, Volume{UINT32_MAX}}) {
+        uniform_int_distribution<Volume> size(1, max_size);
+        for (int round = 0; round < 10'000; round++) {
+            double sizes[8];
+            double shares[8];
+            uint64_t total = 0;
+            for (double& order_size : sizes) {
+                order_size = size(generator);
+                total += static_cast<uint64_t>(order_size);
+            }
+            auto volume = static_cast<Volume>(
+                generator() % min<uint64_t>(total, UINT32_MAX));
+            ComputeProRataShares(sizes, shares, 8, volume, total);
+            for (size_t i = 0; i < 8; i++) {
+                ASSERT_EQ(static_cast<uint64_t>(shares[i]),
+                          static_cast<uint64_t>(sizes[i]) * volume / total);
+            }
+        }
+    }
+
+    // Huge orders in a book: 3,000,000,001 lots over three of 4,000,000,000
+    ProRataOrderBook ob;
+    for (int i = 0; i < 3; i++) {
+        ob.PlaceOrder(createLimitOrder(BUY, 100, 4'000'000'000));
+    }
+    vector<Trade> trades =
+        ob.PlaceOrder(createMarketOrder(SELL, 3'000'000'001));
+    ASSERT_EQ(trades.size(), 3);
+    ASSERT_EQ(trades[0].volume, 1'000'000'001);
+    ASSERT_EQ(trades[1].volume, 1'000'000'000);
+    ASSERT_EQ(trades[2].volume, 1'000'000'000);
+}
+
+void TestMidpointPegFollowsBbo(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 103, 10));
+
+    Order peg = createLimitOrder(BUY, 0, 10);
+    peg.setPeg(PEG_MID);
+    ob.PlaceOrder(peg);
+    ASSERT_EQ(ob.GetPegPrice(PEG_MID, BUY), 101);
+    ASSERT_EQ(ob.GetPeggedVolume(BUY), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, BUY), 0);  // pegs are not displayed
+
+    // The pegged bid is better than the displayed one, so it trades first
+    vector<Trade> trades = ob.PlaceOrder(createMarketOrder(SELL, 4));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].buy_order_id, peg.getOrderId());
+    ASSERT_EQ(trades[0].price, 101);
+
+    // A new best bid moves the midpoint, and the peg with it
+    ob.PlaceOrder(createLimitOrder(BUY, 101, 5));
+    ASSERT_EQ(ob.GetPegPrice(PEG_MID, BUY), 102);
+    trades = ob.PlaceOrder(createMarketOrder(SELL, 6));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].price, 102);
+    ASSERT_EQ(trades[0].volume, 6);
+    ASSERT_FALSE(ob.ContainsOrder(peg.getOrderId()));
+    ASSERT_EQ(ob.GetPeggedVolume(BUY), 0);
+
+    // Only plain limit orders can peg
+    Order pegged_market = createMarketOrder(BUY, 5);
+    pegged_market.setPeg(PEG_MID);
+    ob.PlaceOrder(pegged_market);
+    ASSERT_EQ(ob.GetLastRejectReason(), INVALID_PEG);
+}
+
+void TestPrimaryPegTradesBehindDisplayed(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(BUY, 95, 10));
+    Order displayed = createLimitOrder(SELL, 100, 5);
+    ob.PlaceOrder(displayed);
+    Order peg = createLimitOrder(SELL, 0, 5);
+    peg.setPeg(PEG_PRIMARY);
+    ob.PlaceOrder(peg);
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 5));
+    ASSERT_EQ(ob.GetPegPrice(PEG_PRIMARY, SELL), 100);
+
+    // The peg joins the best ask behind the displayed order; the reference
+    // only moves once the message is done
+    vector<Trade> trades = ob.PlaceOrder(createLimitOrder(BUY, 101, 12));
+    ASSERT_EQ(trades.size(), 3);
+    ASSERT_EQ(trades[0].sell_order_id, displayed.getOrderId());
+    ASSERT_EQ(trades[1].sell_order_id, peg.getOrderId());
+    ASSERT_EQ(trades[1].price, 100);
+    ASSERT_EQ(trades[2].price, 101);
+    ASSERT_EQ(trades[2].volume, 2);
+    ASSERT_EQ(ob.GetPegPrice(PEG_PRIMARY, SELL), 101);
+    ASSERT_EQ(ob.GetPeggedVolume(SELL), 0);
+}
+
+void TestMidpointPegsCrossOnEvenSpread(OrderBook& ob) {
+    Order bid = createLimitOrder(BUY, 99, 1);
+    Order ask = createLimitOrder(SELL, 102, 1);
+    ob.PlaceOrder(bid);
+    ob.PlaceOrder(ask);
+
+    // Odd spread: the midpoint rounds down for buys and up for sells
+    Order buy_peg = createLimitOrder(BUY, 0, 10);
+    buy_peg.setPeg(PEG_MID);
+    Order sell_peg = createLimitOrder(SELL, 0, 4);
+    sell_peg.setPeg(PEG_MID);
+    ob.PlaceOrder(buy_peg);
+    ASSERT_EQ(ob.PlaceOrder(sell_peg).size(), 0);
+
+    // A bid that makes the spread even brings both pegs to 101
+    Order new_bid = createLimitOrder(BUY, 100, 1);
+    vector<Trade> trades = ob.PlaceOrder(new_bid);
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].buy_order_id, buy_peg.getOrderId());
+    ASSERT_EQ(trades[0].sell_order_id, sell_peg.getOrderId());
+    ASSERT_EQ(trades[0].price, 101);
+    ASSERT_EQ(trades[0].volume, 4);
+
+    // Cancelling the rest of the peg leaves just the displayed orders
+    ob.CancelOrder(buy_peg.getOrderId());
+    ASSERT_EQ(ob.GetPeggedVolume(BUY), 0);
+    OrderBook reference;
+    reference.PlaceOrder(bid);
+    reference.PlaceOrder(ask);
+    reference.PlaceOrder(new_bid);
+    ASSERT_EQ(ob.GetStateHash(), reference.GetStateHash());
+}
+
+void TestMidpointPegCrossConflatedReports(OrderBook& ob) {
+    ob.SetReportMode(CONFLATED_REPORTS);
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 1));
+    ob.PlaceOrder(createLimitOrder(SELL, 102, 1));
+    Order buy_peg = createLimitOrder(BUY, 0, 10);
+    buy_peg.setPeg(PEG_MID);
+    ob.PlaceOrder(buy_peg);
+    vector<Order> sell_pegs;
+    for (Volume volume : {3, 4}) {
+        sell_pegs.push_back(createLimitOrder(SELL, 0, volume));
+        sell_pegs.back().setPeg(PEG_MID);
+        ob.PlaceOrder(sell_pegs.back());
+    }
+
+    // The crossing pegs report like any match: one print for the buy peg,
+    // each sell peg's fill on the passive channel
+    vector<Trade> trades = ob.PlaceOrder(createLimitOrder(BUY, 100, 1));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].buy_order_id, buy_peg.getOrderId());
+    ASSERT_EQ(trades[0].sell_order_id, kConflatedOrderId);
+    ASSERT_EQ(trades[0].price, 101);
+    ASSERT_EQ(trades[0].volume, 7);
+    vector<Trade> fills = ob.TakePassiveFills();
+    ASSERT_EQ(fills.size(), 2);
+    for (size_t i = 0; i < fills.size(); i++) {
+        ASSERT_EQ(fills[i].buy_order_id, buy_peg.getOrderId());
+        ASSERT_EQ(fills[i].sell_order_id, sell_pegs[i].getOrderId());
+        ASSERT_EQ(fills[i].volume, sell_pegs[i].getVolume());
+    }
+    ASSERT_EQ(ob.GetTradeStatistics().GetSummary().volume, 7);
+}
+
+void TestImmediateOrCancelNeverRests(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 5));
+
+    Order ioc = createLimitOrder(BUY, 101, 8);
+    ioc.setTimeInForce(IOC);
+    vector<Trade> trades = ob.PlaceOrder(ioc);
+
+    // Fills what is there, the rest is cancelled instead of resting
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].volume, 5);
+    ASSERT_FALSE(ob.ContainsOrder(ioc.getOrderId()));
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, BUY), 0);
+    ASSERT_EQ(ob.GetLastRejectReason(), NOT_REJECTED);
+}
+
+void TestFillOrKillAllOrNothing(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 5));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 5));
+    Order iceberg = createLimitOrder(SELL, 102, 10);
+    iceberg.setPeakVolume(2);
+    ob.PlaceOrder(iceberg);
+    uint64_t hash_before = ob.GetStateHash();
+
+    // 10 lots up to 101 is not enough for 11: nothing trades
+    Order short_fok = createLimitOrder(BUY, 101, 11);
+    short_fok.setTimeInForce(FOK);
+    ASSERT_EQ(ob.PlaceOrder(short_fok).size(), 0);
+    ASSERT_EQ(ob.GetLastRejectReason(), INSUFFICIENT_LIQUIDITY);
+    ASSERT_EQ(ob.GetStateHash(), hash_before);
+
+    // Up to 102 the iceberg's reserve counts too
+    Order fok = createLimitOrder(BUY, 102, 18);
+    fok.setTimeInForce(FOK);
+    vector<Trade> trades = ob.PlaceOrder(fok);
+    ASSERT_EQ(ob.GetLastRejectReason(), NOT_REJECTED);
+    Volume filled = 0;
+    for (const Trade& trade : trades) {
+        filled += trade.volume;
+    }
+    ASSERT_EQ(filled, 18);
+    ASSERT_EQ(ob.GetVolumeAtPrice(102, SELL), 2);
+}
+
+void TestAvailableVolumeAndCostToFill(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(BUY, 90, 7));
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 5));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 102, 20));
+    Order peg = createLimitOrder(SELL, 0, 4);
+    peg.setPeg(PEG_MID);
+    ob.PlaceOrder(peg);  // rests at the midpoint, 95
+
+    // Pegged liquidity counts at its current price
+    ASSERT_EQ(ob.GetAvailableVolume(BUY, 101), 19);
+    ASSERT_EQ(ob.GetAvailableVolume(BUY, 94), 0);
+    ASSERT_EQ(ob.GetAvailableVolume(SELL, 90), 7);
+    ASSERT_EQ(ob.GetAvailableVolume(SELL, 91), 0);
+
+    // 4 @ 95 + 5 @ 100 + 3 @ 101
+    FillCost cost = ob.GetCostToFill(BUY, 12);
+    ASSERT_EQ(cost.volume, 12);
+    ASSERT_EQ(cost.notional, 1183);
+    ASSERT_EQ(cost.worst_price, 101);
+
+    // Asking for more than the book holds reports what is there
+    cost = ob.GetCostToFill(BUY, 1000);
+    ASSERT_EQ(cost.volume, 39);
+    ASSERT_EQ(cost.worst_price, 102);
+}
+
+void TestRiskRejectsSizeCollarAndUnknown() {
+    RiskGate gate(RiskConfig{.max_order_volume = 100, .price_collar = 10});
+    gate.SetParticipantLimits(1, RiskLimits{.max_order_volume = 50});
+    gate.SetReferencePrice(100);
+
+    Order unknown = createLimitOrder(BUY, 100, 10);
+    unknown.setParticipantId(2);
+    ASSERT_EQ(gate.CheckOrder(unknown), UNKNOWN_PARTICIPANT);
+
+    // The participant's own size limit is tighter than the book-wide one
+    Order large = createLimitOrder(BUY, 100, 60);
+    large.setParticipantId(1);
+    gate.PlaceOrder(large);
+    ASSERT_EQ(gate.GetLastRejectReason(), ORDER_TOO_LARGE);
+    ASSERT_FALSE(gate.GetBook().ContainsOrder(large.getOrderId()));
+
+    // Collar bounds are inclusive
+    Order low = createLimitOrder(BUY, 89, 10);
+    low.setParticipantId(1);
+    ASSERT_EQ(gate.CheckOrder(low), OUTSIDE_PRICE_COLLAR);
+    Order edge = createLimitOrder(SELL, 110, 10);
+    edge.setParticipantId(1);
+    ASSERT_EQ(gate.CheckOrder(edge), NOT_REJECTED);
+
+    // Market orders carry no price to collar
+    Order market = createMarketOrder(SELL, 10);
+    market.setParticipantId(1);
+    ASSERT_EQ(gate.CheckOrder(market), NOT_REJECTED);
+
+    // The collar follows the last trade
+    Order bid = createLimitOrder(BUY, 108, 5);
+    bid.setParticipantId(1);
+    gate.PlaceOrder(bid);
+    Order ask = createLimitOrder(SELL, 108, 5);
+    ask.setParticipantId(1);
+    gate.PlaceOrder(ask);
+    ASSERT_EQ(gate.CheckOrder(low), OUTSIDE_PRICE_COLLAR);
+    Order high = createLimitOrder(SELL, 118, 10);
+    high.setParticipantId(1);
+    ASSERT_EQ(gate.CheckOrder(high), NOT_REJECTED);
+}
+
+void TestRiskOpenNotionalFollowsOrders() {
+    RiskGate gate;
+    gate.SetParticipantLimits(1, RiskLimits{.max_open_notional = 2000});
+    gate.SetParticipantLimits(2, RiskLimits{});
+
+    Order first = createLimitOrder(BUY, 100, 10);
+    first.setParticipantId(1);
+    gate.PlaceOrder(first);
+    Order second = createLimitOrder(BUY, 100, 10);
+    second.setParticipantId(1);
+    gate.PlaceOrder(second);
+    ASSERT_EQ(gate.GetOpenNotional(1), 2000);
+
+    Order third = createLimitOrder(SELL, 150, 1);
+    third.setParticipantId(1);
+    gate.PlaceOrder(third);
+    ASSERT_EQ(gate.GetLastRejectReason(), OPEN_NOTIONAL_LIMIT);
+
+    // A cancel and a partial fill both free up room
+    gate.CancelOrder(first.getOrderId());
+    ASSERT_EQ(gate.GetOpenNotional(1), 1000);
+    Order hit = createMarketOrder(SELL, 4);
+    hit.setParticipantId(2);
+    gate.PlaceOrder(hit);
+    ASSERT_EQ(gate.GetOpenNotional(1), 600);
+    ASSERT_EQ(gate.GetOpenNotional(2), 0);
+
+    gate.PlaceOrder(third);
+    ASSERT_EQ(gate.GetLastRejectReason(), NOT_REJECTED);
+    ASSERT_EQ(gate.GetOpenNotional(1), 750);
+}
+
+void TestRiskPositionCountsOpenOrders() {
+    RiskGate gate;
+    gate.SetParticipantLimits(1, RiskLimits{.max_position = 10});
+    gate.SetParticipantLimits(2, RiskLimits{});
+
+    Order bid = createLimitOrder(BUY, 100, 8);
+    bid.setParticipantId(1);
+    gate.PlaceOrder(bid);
+
+    // 8 open to buy: another 3 could take the position to 11
+    Order more = createLimitOrder(BUY, 99, 3);
+    more.setParticipantId(1);
+    ASSERT_EQ(gate.CheckOrder(more), POSITION_LIMIT);
+
+    // Filling the bid moves it from open volume into the position
+    Order ask = createLimitOrder(SELL, 100, 8);
+    ask.setParticipantId(2);
+    gate.PlaceOrder(ask);
+    ASSERT_EQ(gate.GetPosition(1), 8);
+    ASSERT_EQ(gate.GetPosition(2), -8);
+    ASSERT_EQ(gate.CheckOrder(more), POSITION_LIMIT);
+
+    // Selling reduces the position, so up to 18 may be sold
+    Order sell = createLimitOrder(SELL, 120, 18);
+    sell.setParticipantId(1);
+    ASSERT_EQ(gate.CheckOrder(sell), NOT_REJECTED);
+    sell = createLimitOrder(SELL, 120, 19);
+    sell.setParticipantId(1);
+    ASSERT_EQ(gate.CheckOrder(sell), POSITION_LIMIT);
+}
+
+void TestRiskRejectsDuplicateOrderId() {
+    RiskGate gate;
+    gate.SetParticipantLimits(1, RiskLimits{});
+
+    Order bid = createLimitOrder(BUY, 100, 10);
+    bid.setParticipantId(1);
+    gate.PlaceOrder(bid);
+    ASSERT_EQ(gate.GetOpenNotional(1), 1000);
+
+    // Reusing the ID of an open order leaves its counters alone
+    Order reused(bid.getOrderId(), BUY, LIMIT, 50, 4);
+    reused.setParticipantId(1);
+    gate.PlaceOrder(reused);
+    ASSERT_EQ(gate.GetLastRejectReason(), DUPLICATE_ORDER_ID);
+    ASSERT_EQ(gate.GetOpenNotional(1), 1000);
+    ASSERT_EQ(gate.GetBook().GetVolumeAtPrice(50, BUY), 0);
+
+    gate.CancelOrder(bid.getOrderId());
+    ASSERT_EQ(gate.GetOpenNotional(1), 0);
+
+    // Once the order is gone its ID may be used again
+    gate.PlaceOrder(reused);
+    ASSERT_EQ(gate.GetLastRejectReason(), NOT_REJECTED);
+    ASSERT_EQ(gate.GetOpenNotional(1), 200);
+}
+
+void TestRiskReleasesUntradedStops() {
+    RiskGate gate;
+    gate.SetParticipantLimits(1, RiskLimits{});
+    gate.SetParticipantLimits(2, RiskLimits{});
+
+    Order stop = createStopOrder(BUY, 50, 5);
+    stop.setParticipantId(1);
+    gate.PlaceOrder(stop);
+    ASSERT_EQ(gate.GetOpenNotional(1), 250);
+
+    // A print at 50 triggers the market stop into an empty ask side, so it
+    // leaves the book without a fill of its own
+    Order bid = createLimitOrder(BUY, 50, 1);
+    bid.setParticipantId(2);
+    gate.PlaceOrder(bid);
+    Order ask = createLimitOrder(SELL, 50, 1);
+    ask.setParticipantId(2);
+    gate.PlaceOrder(ask);
+    ASSERT_FALSE(gate.GetBook().ContainsOrder(stop.getOrderId()));
+    ASSERT_EQ(gate.GetOpenNotional(1), 0);
+    gate.PlaceOrder(stop);
+    ASSERT_EQ(gate.GetLastRejectReason(), NOT_REJECTED);
+
+    // Range cancels through the gate release what they remove
+    Order quote = createLimitOrder(SELL, 60, 10);
+    quote.setParticipantId(2);
+    gate.PlaceOrder(quote);
+    ASSERT_EQ(gate.GetOpenNotional(2), 600);
+    ASSERT_EQ(gate.CancelWorseThan(SELL, 55).order_ids.size(), 1);
+    ASSERT_EQ(gate.GetOpenNotional(2), 0);
+}
+
+void TestKeepWarmLeavesBookUnchanged(OrderBook& ob) {
+    ASSERT_EQ(ob.KeepWarm(), 0);
+
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 5));
+    Order peg = createLimitOrder(BUY, 0, 3);
+    peg.setPeg(PEG_MID);
+    ob.PlaceOrder(peg);
+    uint64_t hash = ob.GetStateHash();
+
+    // Repeated dry runs read the same data and change nothing
+    uint64_t touched = ob.KeepWarm();
+    ASSERT_TRUE(touched != 0);
+    ASSERT_EQ(ob.KeepWarm(), touched);
+    ASSERT_EQ(ob.GetStateHash(), hash);
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, BUY), 10);
+    ASSERT_EQ(ob.GetPeggedVolume(BUY), 3);
+
+    // The next order matches as if KeepWarm had never run
+    vector<Trade> trades = ob.PlaceOrder(createMarketOrder(SELL, 12));
+    ASSERT_EQ(trades.size(), 2);
+    ASSERT_EQ(trades[0].volume, 3);
+    ASSERT_EQ(trades[1].volume, 9);
+}
+
+void TestTradeStatisticsSummary(OrderBook& ob) {
+    ASSERT_EQ(ob.GetTradeStatistics().GetSummary().trades, 0);
+
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ob.PlaceOrder(createLimitOrder(SELL, 102, 10));
+    ob.PlaceOrder(createLimitOrder(BUY, 102, 15));  // 10 @ 100, 5 @ 102
+    ob.PlaceOrder(createLimitOrder(BUY, 95, 5));
+    ob.PlaceOrder(createMarketOrder(SELL, 5));  // 5 @ 95
+
+    TradeSummary summary = ob.GetTradeStatistics().GetSummary();
+    ASSERT_EQ(summary.trades, 3);
+    ASSERT_EQ(summary.last, 95);
+    ASSERT_EQ(summary.high, 102);
+    ASSERT_EQ(summary.low, 95);
+    ASSERT_EQ(summary.volume, 20);
+    ASSERT_EQ(summary.notional, 1985);
+    ASSERT_TRUE(abs(summary.Vwap() - 99.25) < 1e-9);
+}
+
+void TestTradeStatisticsBars(OrderBook& ob) {
+    ob.SetBarInterval(1'000);
+    ob.AdvanceTime(1'100);
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 10));
+    ob.PlaceOrder(createMarketOrder(BUY, 4));
+    ob.PlaceOrder(createLimitOrder(SELL, 99, 10));
+    ob.PlaceOrder(createMarketOrder(BUY, 2));
+
+    const TradeStatistics& stats = ob.GetTradeStatistics();
+    Bar bar = stats.GetCurrentBar();
+    ASSERT_EQ(bar.start, 1'000);
+    ASSERT_EQ(bar.open, 100);
+    ASSERT_EQ(bar.low, 99);
+    ASSERT_EQ(bar.close, 99);
+    ASSERT_EQ(bar.volume, 6);
+
+    // Quiet intervals leave no bar; the next fill closes the open one
+    ob.AdvanceTime(4'500);
+    ASSERT_EQ(stats.GetClosedBarCount(), 0);
+    ob.PlaceOrder(createMarketOrder(BUY, 3));
+    ASSERT_EQ(stats.GetClosedBarCount(), 1);
+    Bar closed;
+    ASSERT_TRUE(stats.GetClosedBar(0, closed));
+    ASSERT_EQ(closed.start, 1'000);
+    ASSERT_EQ(closed.trades, 2);
+    ASSERT_FALSE(stats.GetClosedBar(1, closed));
+
+    bar = stats.GetCurrentBar();
+    ASSERT_EQ(bar.start, 4'000);
+    ASSERT_EQ(bar.open, 99);
+    ASSERT_EQ(bar.volume, 3);
+}
+
+void TestTradeStatisticsConcurrentReader(OrderBook& ob) {
+    // Every trade prints at 100, so a consistent snapshot always has
+    // notional == 100 * volume and a bar no bigger than the totals
+    atomic<bool> done{false};
+    atomic<bool> torn{false};
+    thread reader([&]() {
+        const TradeStatistics& stats = ob.GetTradeStatistics();
+        while (!done.load(memory_order_acquire)) {
+            TradeSummary summary = stats.GetSummary();
+            Bar bar = stats.GetCurrentBar();
+            if (summary.notional != 100 * summary.volume ||
+                summary.trades * 3 != summary.volume ||
+                bar.notional != 100 * bar.volume) {
+                torn.store(true);
+            }
+        }
+    });
+    for (int i = 0; i < 20'000; i++) {
+        ob.PlaceOrder(createLimitOrder(SELL, 100, 3));
+        ob.PlaceOrder(createMarketOrder(BUY, 3));
+    }
+    done.store(true, memory_order_release);
+    reader.join();
+
+    ASSERT_FALSE(torn.load());
+    ASSERT_EQ(ob.GetTradeStatistics().GetSummary().volume, 60'000);
+}
+
+void TestForkSweepLeavesBookUntouched(OrderBook& ob) {
+    Order first = createLimitOrder(SELL, 100, 5);
+    ob.PlaceOrder(first);
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 5));
+    ob.PlaceOrder(createIcebergOrder(SELL, 101, 20, 4));
+    ob.PlaceOrder(createLimitOrder(SELL, 105, 50));
+    uint64_t hash = ob.GetStateHash();
+
+    BookFork fork(ob);
+    vector<Trade> trades = fork.PlaceOrder(createMarketOrder(BUY, 16));
+    ASSERT_EQ(trades.size(), 4);  // 5 + 5 @ 100, 4 + 2 @ 101 (iceberg)
+    ASSERT_EQ(trades[3].price, 101);
+    ASSERT_EQ(trades[3].volume, 2);
+    ASSERT_EQ(fork.GetVolumeAtPrice(100, SELL), 0);
+    ASSERT_EQ(fork.GetVolumeAtPrice(101, SELL), 14);
+    ASSERT_FALSE(fork.ContainsOrder(first.getOrderId()));
+
+    // Only the two swept levels and three order records were copied
+    ASSERT_EQ(fork.GetTouchedLevelCount(), 2);
+    ASSERT_EQ(fork.GetCopiedOrderCount(), 3);
+
+    ASSERT_EQ(ob.GetStateHash(), hash);
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 20);
+    ASSERT_TRUE(ob.ContainsOrder(first.getOrderId()));
+
+    // The same sweep on the real book prints the same trades
+    vector<Trade> real = ob.PlaceOrder(createMarketOrder(BUY, 16));
+    ASSERT_EQ(real.size(), trades.size());
+    for (size_t i = 0; i < real.size(); i++) {
+        ASSERT_EQ(real[i].sell_order_id, trades[i].sell_order_id);
+        ASSERT_EQ(real[i].volume, trades[i].volume);
+    }
+}
+
+void TestForkRestsAndCancelsLocally(OrderBook& ob) {
+    Order bid = createLimitOrder(BUY, 99, 10);
+    ob.PlaceOrder(bid);
+
+    BookFork fork(ob);
+    Order ask = createLimitOrder(SELL, 101, 7);
+    fork.PlaceOrder(ask);
+    ASSERT_TRUE(fork.ContainsOrder(ask.getOrderId()));
+    ASSERT_EQ(fork.GetVolumeAtPrice(101, SELL), 7);
+    ASSERT_FALSE(ob.ContainsOrder(ask.getOrderId()));
+
+    // Cancelling a book order only hides it from the fork
+    fork.CancelOrder(bid.getOrderId());
+    ASSERT_FALSE(fork.ContainsOrder(bid.getOrderId()));
+    ASSERT_EQ(fork.GetVolumeAtPrice(99, BUY), 0);
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, BUY), 10);
+
+    Order fok = createLimitOrder(SELL, 99, 5);
+    fok.setTimeInForce(FOK);
+    fork.PlaceOrder(fok);
+    ASSERT_EQ(fork.GetLastRejectReason(), INSUFFICIENT_LIQUIDITY);
+
+    Order stop = createStopOrder(SELL, 98, 5);
+    fork.PlaceOrder(stop);
+    ASSERT_EQ(fork.GetLastRejectReason(), NOT_SIMULATED);
+
+    // Reset goes back to the live book
+    fork.Reset();
+    ASSERT_FALSE(fork.ContainsOrder(ask.getOrderId()));
+    ASSERT_EQ(fork.GetVolumeAtPrice(99, BUY), 10);
+    ASSERT_EQ(fork.GetTouchedLevelCount(), 0);
+}
+
+void TestForkTakesOnlyTheOrdersItReaches(OrderBook& ob) {
+    vector<OrderID> ids;
+    for (int i = 0; i < 1'000; i++) {
+        Order order = createLimitOrder(SELL, 100, 5);
+        ob.PlaceOrder(order);
+        ids.push_back(order.getOrderId());
+    }
+
+    // A one-lot fill takes one pointer off the front of a deep level
+    BookFork fork(ob);
+    vector<Trade> trades = fork.PlaceOrder(createMarketOrder(BUY, 1));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].sell_order_id, ids[0]);
+    ASSERT_EQ(fork.GetTakenOrderCount(), 1);
+
+    // Cancelling an order deeper in the queue takes nothing
+    fork.CancelOrder(ids[2]);
+    ASSERT_EQ(fork.GetTakenOrderCount(), 1);
+    ASSERT_EQ(fork.GetVolumeAtPrice(100, SELL), 4'994);
+    ASSERT_FALSE(fork.ContainsOrder(ids[2]));
+
+    // A resting order goes behind the whole book queue, and the cancelled
+    // order is skipped when matching reaches it
+    Order late = createLimitOrder(SELL, 100, 5);
+    fork.PlaceOrder(late);
+    trades = fork.PlaceOrder(createMarketOrder(BUY, 14));
+    ASSERT_EQ(trades.size(), 3);  // 4 + 5 + 5, order 2 cancelled
+    ASSERT_EQ(trades[1].sell_order_id, ids[1]);
+    ASSERT_EQ(trades[2].sell_order_id, ids[3]);
+    ASSERT_EQ(fork.GetTakenOrderCount(), 3);
+    ASSERT_EQ(fork.GetVolumeAtPrice(100, SELL), 4'985);
+
+    trades = fork.PlaceOrder(createMarketOrder(BUY, 4'985));
+    ASSERT_EQ(trades.back().sell_order_id, late.getOrderId());
+    ASSERT_EQ(fork.GetVolumeAtPrice(100, SELL), 0);
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, SELL), 5'000);
+}
+
+void TestForkMatchesLikeTheBook() {
+    // Two books built from the same flow; the same what-if orders go to a
+    // fork of one and straight into the other
+    default_random_engine generator(7);
+    uniform_int_distribution<int> side_dist(0, 1);
+    uniform_int_distribution<Price> price_dist(95, 105);
+    uniform_int_distribution<Volume> volume_dist(1, 20);
+    auto random_order = [&]() {
+        Side side = side_dist(generator) == 0 ? BUY : SELL;
+        Price price = price_dist(generator);
+        Volume volume = volume_dist(generator);
+        int kind = uniform_int_distribution<int>(0, 9)(generator);
+        if (kind == 0) {
+            return createMarketOrder(side, volume);
+        }
+        if (kind == 1) {
+            return createIcebergOrder(side, price, volume * 3, volume);
+        }
+        return createLimitOrder(side, price, volume);
+    };
+
+    OrderBook live;
+    OrderBook reference;
+    vector<OrderID> ids;
+    for (int i = 0; i < 500; i++) {
+        Order order = random_order();
+        live.PlaceOrder(order);
+        reference.PlaceOrder(order);
+        ids.push_back(order.getOrderId());
+    }
+    uint64_t hash = live.GetStateHash();
+
+    BookFork fork(live);
+    for (int i = 0; i < 300; i++) {
+        if (i % 5 == 0) {
+            OrderID id = ids[uniform_int_distribution<size_t>(
+                0, ids.size() - 1)(generator)];
+            fork.CancelOrder(id);
+            reference.CancelOrder(id);
+            continue;
+        }
+        Order order = random_order();
+        ids.push_back(order.getOrderId());
+        vector<Trade> simulated = fork.PlaceOrder(order);
+        vector<Trade> real = reference.PlaceOrder(order);
+        ASSERT_EQ(fork.GetLastRejectReason(), reference.GetLastRejectReason());
+        ASSERT_EQ(simulated.size(), real.size());
+        for (size_t j = 0; j < real.size(); j++) {
+            ASSERT_EQ(simulated[j].buy_order_id, real[j].buy_order_id);
+            ASSERT_EQ(simulated[j].sell_order_id, real[j].sell_order_id);
+            ASSERT_EQ(simulated[j].price, real[j].price);
+            ASSERT_EQ(simulated[j].volume, real[j].volume);
+        }
+    }
+    for (Price price = 90; price <= 110; price++) {
+        ASSERT_EQ(fork.GetVolumeAtPrice(price, BUY),
+                  reference.GetVolumeAtPrice(price, BUY));
+        ASSERT_EQ(fork.GetVolumeAtPrice(price, SELL),
+                  reference.GetVolumeAtPrice(price, SELL));
+    }
+    ASSERT_EQ(live.GetStateHash(), hash);
+
+    // In a call auction orders only accumulate, and market orders are
+    // rejected the same way
+    OrderBook auction_live;
+    OrderBook auction_reference;
+    auction_live.StartAuction();
+    auction_reference.StartAuction();
+    BookFork auction_fork(auction_live);
+    for (int i = 0; i < 100; i++) {
+        Order order = random_order();
+        if (i % 7 == 0) {
+            order.setTimeInForce(i % 2 == 0 ? IOC : FOK);
+        }
+        ASSERT_TRUE(auction_fork.PlaceOrder(order).empty());
+        ASSERT_TRUE(auction_reference.PlaceOrder(order).empty());
+        ASSERT_EQ(auction_fork.GetLastRejectReason(),
+                  auction_reference.GetLastRejectReason());
+    }
+    for (Price price = 90; price <= 110; price++) {
+        ASSERT_EQ(auction_fork.GetVolumeAtPrice(price, BUY),
+                  auction_reference.GetVolumeAtPrice(price, BUY));
+        ASSERT_EQ(auction_fork.GetVolumeAtPrice(price, SELL),
+                  auction_reference.GetVolumeAtPrice(price, SELL));
+    }
+}
+
+void TestColumnarWriterRoundTrip() {
+    // Three chunks of 4 rows, the last one partly filled
+    const string path = "test_columnar.col";
+    const array<ColumnSpec, 2> schema = {{{"id", 8}, {"price", 4}}};
+    {
+        ColumnarWriter<2> writer(path, schema, 4);
+        ASSERT_TRUE(writer.IsOpen());
+        for (uint64_t row = 0; row < 10; row++) {
+            writer.Write({(1ULL << 40) + row, 100 + row});
+        }
+    }
+
+    ifstream file(path, ios::binary);
+    vector<char> bytes((istreambuf_iterator<char>(file)),
+                       istreambuf_iterator<char>());
+    remove(path.c_str());
+    auto read = [&](size_t offset, size_t width) {
+        uint64_t value = 0;
+        memcpy(&value, &bytes[offset], width);
+        return value;
+    };
+
+    const size_t header = 16 + 2 * sizeof(ColumnSpec);
+    const size_t chunk = 8 + 4 * (8 + 4);
+    ASSERT_EQ(bytes.size(), header + 3 * chunk);
+    ASSERT_TRUE(memcmp(bytes.data(), kColumnarMagic, 8) == 0);
+    ASSERT_EQ(read(8, 4), 2);
+    ASSERT_EQ(read(12, 4), 4);
+    ASSERT_TRUE(string(&bytes[16]) == "id");
+    ASSERT_EQ(read(16 + 28, 4), 8);
+
+    for (uint64_t row = 0; row < 10; row++) {
+        size_t base = header + (row / 4) * chunk;
+        ASSERT_EQ(read(base + 8 + (row % 4) * 8, 8), (1ULL << 40) + row);
+        ASSERT_EQ(read(base + 8 + 4 * 8 + (row % 4) * 4, 4), 100 + row);
+    }
+    ASSERT_EQ(read(header, 8), 4);
+    ASSERT_EQ(read(header + 2 * chunk, 8), 2);
+}
+
+void TestDepthSnapshot(OrderBook& ob) {
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 10));
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 5));
+    ob.PlaceOrder(createIcebergOrder(BUY, 98, 30, 10));
+    ob.PlaceOrder(createLimitOrder(BUY, 97, 1));
+    ob.PlaceOrder(createLimitOrder(SELL, 101, 4));
+
+    vector<DepthLevel> bids = ob.GetDepth(BUY, 2);
+    ASSERT_EQ(bids.size(), 2);
+    ASSERT_EQ(bids[0].price, 99);
+    ASSERT_EQ(bids[0].volume, 15);
+    ASSERT_EQ(bids[0].orders, 2);
+    ASSERT_EQ(bids[1].price, 98);
+    ASSERT_EQ(bids[1].volume, 30);
+    ASSERT_EQ(bids[1].hidden_volume, 20);
+
+    vector<DepthLevel> asks = ob.GetDepth(SELL, 10);
+    ASSERT_EQ(asks.size(), 1);
+    ASSERT_EQ(asks[0].price, 101);
+}
+
+void TestMassQuoteRequoteKeepsPriority(OrderBook& ob) {
+    ob.MassQuote(7, {{101, BUY, 99, 10},
+                     {102, BUY, 98, 10},
+                     {201, SELL, 101, 10},
+                     {202, SELL, 102, 10}});
+    ob.PlaceOrder(Order(1, BUY, LIMIT, 99, 10));
+
+    // 101 shrinks in place, 102 moves, 201 grows, 202 is pulled
+    auto trades = ob.MassQuote(7, {{101, BUY, 99, 5},
+                                   {102, BUY, 97, 10},
+                                   {201, SELL, 101, 20}});
+    ASSERT_TRUE(trades.empty());
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, BUY), 15);
+    ASSERT_EQ(ob.GetVolumeAtPrice(98, BUY), 0);
+    ASSERT_EQ(ob.GetVolumeAtPrice(97, BUY), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 20);
+    ASSERT_FALSE(ob.ContainsOrder(202));
+
+    // Same book reached with plain orders, queue order included
+    OrderBook reference;
+    reference.PlaceOrder(Order(101, BUY, LIMIT, 99, 5));
+    reference.PlaceOrder(Order(1, BUY, LIMIT, 99, 10));
+    reference.PlaceOrder(Order(102, BUY, LIMIT, 97, 10));
+    reference.PlaceOrder(Order(201, SELL, LIMIT, 101, 20));
+    ASSERT_EQ(ob.GetStateHash(), reference.GetStateHash());
+
+    // The shrunk leg is still first in its queue
+    trades = ob.PlaceOrder(Order(2, SELL, LIMIT, 99, 5));
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].buy_order_id, 101);
+}
+
+void TestMassQuoteRejectsWholeQuote(OrderBook& ob) {
+    ob.MassQuote(7, {{101, BUY, 99, 10}, {201, SELL, 101, 10}});
+    ob.PlaceOrder(Order(1, BUY, LIMIT, 98, 10));
+    uint64_t hash = ob.GetStateHash();
+
+    // Crossed legs, a zero leg, a repeated ID, another order's ID
+    vector<vector<QuoteEntry>> bad_quotes = {
+        {{101, BUY, 100, 10}, {201, SELL, 100, 10}},
+        {{101, BUY, 97, 10}, {201, SELL, 103, 0}},
+        {{101, BUY, 97, 10}, {101, SELL, 103, 10}},
+        {{101, BUY, 97, 10}, {1, SELL, 103, 10}}};
+    for (const vector<QuoteEntry>& quote : bad_quotes) {
+        ASSERT_TRUE(ob.MassQuote(7, quote).empty());
+        ASSERT_EQ(ob.GetLastRejectReason(), INVALID_QUOTE);
+        ASSERT_EQ(ob.GetStateHash(), hash);
+    }
+
+    // The old quote is still live and can be replaced
+    ob.MassQuote(7, {{101, BUY, 97, 10}});
+    ASSERT_EQ(ob.GetLastRejectReason(), NOT_REJECTED);
+    ASSERT_EQ(ob.GetVolumeAtPrice(97, BUY), 10);
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, BUY), 0);
+    ASSERT_FALSE(ob.ContainsOrder(201));
+}
+
+void TestMassQuoteCrossingLegTrades(OrderBook& ob) {
+    ob.PlaceOrder(Order(1, SELL, LIMIT, 100, 5));
+
+    // The bid leg takes the offer and rests the remainder
+    auto trades = ob.MassQuote(7, {{101, BUY, 100, 8}, {201, SELL, 102, 5}});
+    ASSERT_EQ(trades.size(), 1);
+    ASSERT_EQ(trades[0].sell_order_id, 1);
+    ASSERT_EQ(trades[0].volume, 5);
+    ASSERT_EQ(ob.GetVolumeAtPrice(100, BUY), 3);
+
+    // Legs filled or cancelled since the last quote are simply replaced
+    ob.PlaceOrder(Order(2, SELL, LIMIT, 100, 3));
+    ob.CancelOrder(201);
+    trades = ob.MassQuote(7, {{101, BUY, 99, 4}, {201, SELL, 101, 6}});
+    ASSERT_TRUE(trades.empty());
+    ASSERT_EQ(ob.GetVolumeAtPrice(99, BUY), 4);
+    ASSERT_EQ(ob.GetVolumeAtPrice(101, SELL), 6);
+    ASSERT_EQ(ob.GetVolumeAtPrice(102, SELL), 0);
+
+    OrderBook reference;
+    reference.PlaceOrder(Order(101, BUY, LIMIT, 99, 4));
+    reference.PlaceOrder(Order(201, SELL, LIMIT, 101, 6));
+    ASSERT_EQ(ob.GetStateHash(), reference.GetStateHash());
+}
+
+void TestRingDequeMatchesDeque() {
+    // Random pushes, pops and erases, with the ring wrapping around
+    default_random_engine generator(11);
+    RingDeque<int> ring;
+    deque<int> reference;
+    for (int i = 0; i < 5000; i++) {
+        int op = uniform_int_distribution<int>(0, 9)(generator);
+        if (op < 5 || reference.empty()) {
+            ring.push_back(i);
+            reference.push_back(i);
+        } else if (op < 8) {
+            ring.pop_front();
+            reference.pop_front();
+        } else if (op == 8) {
+            size_t index = uniform_int_distribution<size_t>(
+                0, reference.size() - 1)(generator);
+            ring.erase(ring.begin() + static_cast<ptrdiff_t>(index));
+            reference.erase(reference.begin() +
+                            static_cast<ptrdiff_t>(index));
+        } else {
+            erase_if(ring, [](int value) { return value % 7 == 0; });
+            erase_if(reference, [](int value) { return value % 7 == 0; });
+            ring.shrink_to_fit();
+        }
+        ASSERT_EQ(ring.size(), reference.size());
+        ASSERT_TRUE(ranges::equal(ring, reference));
+    }
+}
+
+template <typename Book>
+static void checkMatchesDefaultBook() {
+    // The same random flow through the default book and a container variant
+    default_random_engine generator(3);
+    uniform_int_distribution<Price> price_dist(95, 105);
+    uniform_int_distribution<Volume> volume_dist(1, 20);
+    OrderBook reference;
+    Book variant;
+    vector<OrderID> ids;
+    for (int i = 0; i < 3000; i++) {
+        int kind = uniform_int_distribution<int>(0, 19)(generator);
+        if (kind < 4 && !ids.empty()) {
+            OrderID id = ids[uniform_int_distribution<size_t>(
+                0, ids.size() - 1)(generator)];
+            reference.CancelOrder(id);
+            variant.CancelOrder(id);
+            continue;
+        }
+        if (kind == 4) {
+            reference.CancelWorseThan(BUY, 96);
+            variant.CancelWorseThan(BUY, 96);
+            continue;
+        }
+        if (kind == 5) {
+            reference.Compact(16);
+            variant.Compact(16);
+        }
+
+        Side side = kind % 2 == 0 ? BUY : SELL;
+        Price price = price_dist(generator);
+        Volume volume = volume_dist(generator);
+        Order order = kind == 6   ? createMarketOrder(side, volume)
+                      : kind == 7 ? createIcebergOrder(side, price,
+                                                       volume * 3, volume)
+                                  : createLimitOrder(side, price, volume);
+        ids.push_back(order.getOrderId());
+        vector<Trade> expected = reference.PlaceOrder(order);
+        vector<Trade> trades = variant.PlaceOrder(order);
+        ASSERT_EQ(trades.size(), expected.size());
+        for (size_t j = 0; j < trades.size(); j++) {
+            ASSERT_EQ(trades[j].buy_order_id, expected[j].buy_order_id);
+            ASSERT_EQ(trades[j].sell_order_id, expected[j].sell_order_id);
+            ASSERT_EQ(trades[j].volume, expected[j].volume);
+        }
+        ASSERT_EQ(variant.GetStateHash(), reference.GetStateHash());
+    }
+    ASSERT_EQ(variant.GetMemoryUsage().orders,
+              reference.GetMemoryUsage().orders);
+}
+
+void TestContainerVariantsMatchDefault() {
+    checkMatchesDefaultBook<BasicOrderBook<
+        FifoMatching, BookContainers<MapLevels, RingQueue, HashIndex>>>();
+    checkMatchesDefaultBook<BasicOrderBook<
+        FifoMatching,
+        BookContainers<PooledMapLevels, DequeQueue, HashIndex>>>();
+    checkMatchesDefaultBook<BasicOrderBook<
+        FifoMatching,
+        BookContainers<PooledMapLevels, RingQueue, PooledHashIndex>>>();
+}
+
+void TestTopOfBookSlotFollowsBook(OrderBook& ob) {
+    ConsolidatedBbo bbo(1);
+    ob.PlaceOrder(createLimitOrder(BUY, 99, 10));
+    ob.SetTopOfBookSlot(&bbo.GetSlot(0));
+    TopOfBook top = bbo.GetTopOfBook(0);
+    ASSERT_EQ(top.bids[0].price, 99);
+    ASSERT_EQ(top.bids[0].volume, 10);
+    ASSERT_EQ(top.asks[0].volume, 0);
+
+    // Levels best first, displayed volume only
+    Order best_ask = createLimitOrder(SELL, 101, 5);
+    ob.PlaceOrder(best_ask);
+    ob.PlaceOrder(createIcebergOrder(SELL, 102, 30, 10));
+    for (Price price = 98; price >= 94; price--) {
+        ob.PlaceOrder(createLimitOrder(BUY, price, 1));
+    }
+    top = bbo.GetTopOfBook(0);
+    ASSERT_EQ(top.asks[0].price, 101);
+    ASSERT_EQ(top.asks[1].price, 102);
+    ASSERT_EQ(top.asks[1].volume, 10);
+    ASSERT_EQ(top.bids[3].price, 96);  // only kTopOfBookLevels published
+
+    // Cancels, fills and auctions republish
+    ob.CancelOrder(best_ask.getOrderId());
+    ASSERT_EQ(bbo.GetTopOfBook(0).asks[0].price, 102);
+    ob.PlaceOrder(createMarketOrder(SELL, 10));
+    ASSERT_EQ(bbo.GetTopOfBook(0).bids[0].price, 98);
+    ob.StartAuction();
+    ASSERT_TRUE(bbo.GetTopOfBook(0).in_auction);
+    ob.Uncross();
+    ASSERT_FALSE(bbo.GetTopOfBook(0).in_auction);
+}
+
+void TestConsolidatedBboAcrossBooks() {
+    ConsolidatedBbo bbo(3);
+    OrderBook books[3];
+    for (size_t i = 0; i < 3; i++) {
+        books[i].SetTopOfBookSlot(&bbo.GetSlot(i));
+    }
+    ASSERT_FALSE(bbo.GetBbo().HasBid());
+
+    books[0].PlaceOrder(createLimitOrder(BUY, 99, 10));
+    books[0].PlaceOrder(createLimitOrder(SELL, 103, 10));
+    books[1].PlaceOrder(createLimitOrder(BUY, 100, 4));
+    books[1].PlaceOrder(createLimitOrder(BUY, 99, 6));
+    books[1].PlaceOrder(createLimitOrder(SELL, 102, 5));
+    books[2].PlaceOrder(createLimitOrder(BUY, 100, 7));
+    books[2].PlaceOrder(createLimitOrder(SELL, 104, 8));
+
+    ConsolidatedQuote quote = bbo.GetBbo();
+    ASSERT_EQ(quote.bid_price, 100);
+    ASSERT_EQ(quote.bid_volume, 11);
+    ASSERT_EQ(quote.bid_books, 2);
+    ASSERT_EQ(quote.ask_price, 102);
+    ASSERT_EQ(quote.ask_volume, 5);
+    ASSERT_EQ(quote.ask_books, 1);
+    ASSERT_EQ(bbo.GetVolumeAtPrice(99, BUY), 16);
+    ASSERT_EQ(bbo.GetVolumeAtPrice(104, SELL), 8);
+
+    // A book in auction drops out until it uncrosses
+    books[1].StartAuction();
+    quote = bbo.GetBbo();
+    ASSERT_EQ(quote.bid_volume, 7);
+    ASSERT_EQ(quote.ask_price, 103);
+    books[1].Uncross();
+    ASSERT_EQ(bbo.GetBbo().ask_price, 102);
+}
+
+void TestConsolidatedBboConcurrentReader() {
+    // Two books keep moving a one-lot quote around 100 with a one-tick
+    // spread; every consistent view has a bid below the ask
+    ConsolidatedBbo bbo(2);
+    atomic<bool> done{false};
+    atomic<bool> torn{false};
+    thread reader([&]() {
+        while (!done.load(memory_order_acquire)) {
+            ConsolidatedQuote quote = bbo.GetBbo();
+            for (size_t book = 0; book < 2; book++) {
+                TopOfBook top = bbo.GetTopOfBook(book);
+                if (top.bids[0].volume != 0 && top.asks[0].volume != 0 &&
+                    top.bids[0].price + 1 != top.asks[0].price) {
+                    torn.store(true);
+                }
+            }
+            if (quote.HasBid() && quote.bid_volume != quote.bid_books) {
+                torn.store(true);
+            }
+        }
+    });
+
+    vector<thread> writers;
+    for (size_t book = 0; book < 2; book++) {
+        writers.emplace_back([&bbo, book]() {
+            OrderBook ob;
+            ob.SetTopOfBookSlot(&bbo.GetSlot(book));
+            for (int i = 0; i < 10'000; i++) {
+                // createLimitOrder's ID counter is not shared across threads
+                Price bid = 95 + static_cast<Price>(i % 10);
+                ob.PlaceOrder(Order(1, BUY, LIMIT, bid, 1));
+                ob.PlaceOrder(Order(2, SELL, LIMIT, bid + 1, 1));
+                ob.CancelOrder(1);
+                ob.CancelOrder(2);
+            }
+            ob.SetTopOfBookSlot(nullptr);
+        });
+    }
+    for (thread& writer : writers) {
+        writer.join();
+    }
+    done.store(true, memory_order_release);
+    reader.join();
+    ASSERT_FALSE(torn.load());
+}
+
+void TestQueuePositionCounts(OrderBook& ob) {
+    Order a = createLimitOrder(SELL, 100, 10);
+    Order b = createLimitOrder(SELL, 100, 20);
+    Order c = createIcebergOrder(SELL, 100, 30, 10);
+    Order d = createLimitOrder(SELL, 100, 5);
+    Order e = createLimitOrder(SELL, 100, 7);
+    for (const Order& order : {a, b, c, d, e}) {
+        ob.PlaceOrder(order);
+    }
+
+    // Only the iceberg's shown slice is ahead
+    QueuePosition position;
+    ASSERT_TRUE(ob.GetQueuePosition(d.getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 40);
+    ASSERT_EQ(position.orders_ahead, 3);
+
+    // Fills at the front move everyone up
+    ob.PlaceOrder(createMarketOrder(BUY, 15));
+    ASSERT_TRUE(ob.GetQueuePosition(d.getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 25);
+    ASSERT_EQ(position.orders_ahead, 2);
+    ASSERT_TRUE(ob.GetQueuePosition(b.getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 0);
+    ASSERT_EQ(position.orders_ahead, 0);
+
+    // A cancel in the middle moves only the orders behind it
+    ob.CancelOrder(c.getOrderId());
+    ASSERT_TRUE(ob.GetQueuePosition(d.getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 15);
+    ASSERT_EQ(position.orders_ahead, 1);
+    ASSERT_TRUE(ob.GetQueuePosition(e.getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 20);
+    ASSERT_EQ(position.orders_ahead, 2);
+    ASSERT_TRUE(ob.GetQueuePosition(b.getOrderId(), position));
+    ASSERT_EQ(position.orders_ahead, 0);
+
+    // An iceberg showing a new slice goes to the back
+    Order f = createIcebergOrder(SELL, 100, 8, 4);
+    Order g = createLimitOrder(SELL, 100, 3);
+    ob.PlaceOrder(f);
+    ob.PlaceOrder(g);
+    ob.PlaceOrder(createMarketOrder(BUY, 31));
+    ASSERT_TRUE(ob.GetQueuePosition(g.getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 0);
+    ASSERT_EQ(position.orders_ahead, 0);
+    ASSERT_TRUE(ob.GetQueuePosition(f.getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 3);
+    ASSERT_EQ(position.orders_ahead, 1);
+
+    // Only orders in a price level's queue have a position
+    Order stop = createStopOrder(BUY, 120, 5);
+    ob.PlaceOrder(stop);
+    ASSERT_FALSE(ob.GetQueuePosition(stop.getOrderId(), position));
+    ASSERT_FALSE(ob.GetQueuePosition(a.getOrderId(), position));
+}
+
+void TestQueuePositionAfterRequoteAndProRata() {
+    // A leg shrunk in place keeps its place; the order behind moves up
+    OrderBook quote_book;
+    quote_book.MassQuote(7, {{101, BUY, 99, 10}});
+    quote_book.PlaceOrder(Order(1, BUY, LIMIT, 99, 10));
+    quote_book.MassQuote(7, {{101, BUY, 99, 4}});
+    QueuePosition position;
+    ASSERT_TRUE(quote_book.GetQueuePosition(1, position));
+    ASSERT_EQ(position.volume_ahead, 4);
+    ASSERT_EQ(position.orders_ahead, 1);
+
+    // A moved leg goes to the back of its new level and stays watched
+    ASSERT_TRUE(quote_book.WatchQueuePosition(101));
+    quote_book.PlaceOrder(Order(2, BUY, LIMIT, 98, 10));
+    quote_book.MassQuote(7, {{101, BUY, 98, 4}});
+    ASSERT_TRUE(quote_book.GetQueuePosition(101, position));
+    ASSERT_EQ(position.volume_ahead, 10);
+    ASSERT_EQ(position.orders_ahead, 1);
+    quote_book.CancelOrder(1);
+    quote_book.TakeQueuePositionUpdates();
+    quote_book.PlaceOrder(Order(3, SELL, LIMIT, 98, 6));
+    vector<QueuePositionUpdate> updates =
+        quote_book.TakeQueuePositionUpdates();
+    ASSERT_EQ(updates.size(), 1);
+    ASSERT_EQ(updates[0].order_id, 101);
+    ASSERT_EQ(updates[0].position.volume_ahead, 4);
+
+    // Pro-rata fills land all over the queue
+    ProRataOrderBook prorata_book;
+    vector<Order> bids;
+    for (int i = 0; i < 3; i++) {
+        bids.push_back(createLimitOrder(BUY, 100, 10));
+        prorata_book.PlaceOrder(bids.back());
+    }
+    prorata_book.PlaceOrder(createMarketOrder(SELL, 6));
+    ASSERT_TRUE(prorata_book.GetQueuePosition(bids[2].getOrderId(), position));
+    ASSERT_EQ(position.volume_ahead, 16);
+    ASSERT_EQ(position.orders_ahead, 2);
+}
+
+void TestQueuePositionUpdates(OrderBook& ob) {
+    Order a = createLimitOrder(BUY, 100, 10);
+    Order b = createLimitOrder(BUY, 100, 10);
+    Order c = createLimitOrder(BUY, 99, 10);
+    b.setParticipantId(3);
+    ob.PlaceOrder(a);
+    ob.PlaceOrder(b);
+    ob.PlaceOrder(c);
+
+    // Watching pushes the current position
+    ASSERT_TRUE(ob.WatchQueuePosition(b.getOrderId()));
+    vector<QueuePositionUpdate> updates = ob.TakeQueuePositionUpdates();
+    ASSERT_EQ(updates.size(), 1);
+    ASSERT_EQ(updates[0].order_id, b.getOrderId());
+    ASSERT_EQ(updates[0].participant_id, 3);
+    ASSERT_EQ(updates[0].position.volume_ahead, 10);
+    ASSERT_EQ(updates[0].position.orders_ahead, 1);
+
+    // Orders joining behind it and changes at other levels do not move it
+    ob.PlaceOrder(createLimitOrder(BUY, 100, 5));
+    ob.CancelOrder(c.getOrderId());
+    ASSERT_TRUE(ob.TakeQueuePositionUpdates().empty());
+
+    // A fill ahead of it is pushed with the fill, once per message
+    ob.PlaceOrder(createLimitOrder(SELL, 100, 4));
+    updates = ob.TakeQueuePositionUpdates();
+    ASSERT_EQ(updates.size(), 1);
+    ASSERT_EQ(updates[0].position.volume_ahead, 6);
+    ASSERT_EQ(updates[0].position.orders_ahead, 1);
+    ob.PlaceOrder(createMarketOrder(SELL, 8));
+    updates = ob.TakeQueuePositionUpdates();
+    ASSERT_EQ(updates.size(), 1);
+    ASSERT_EQ(updates[0].position.volume_ahead, 0);
+    ASSERT_EQ(updates[0].position.orders_ahead, 0);
+
+    // Unwatched, it gets nothing more
+    ob.UnwatchQueuePosition(b.getOrderId());
+    ob.PlaceOrder(createMarketOrder(SELL, 1));
+    ASSERT_TRUE(ob.TakeQueuePositionUpdates().empty());
+    ASSERT_FALSE(ob.WatchQueuePosition(c.getOrderId()));
+}
+
+// Random flow; after every message the positions at each level must be
+// the queue order itself: 0..n-1 orders ahead, volume rising from 0 and
+// staying below the level's displayed volume
+template <typename Book>
+static void checkQueuePositionsFollowQueues() {
+    Book book;
+    mt19937 generator(11);
+    uniform_int_distribution<int> action(0, 99);
+    uniform_int_distribution<Price> price(95, 105);
+    uniform_int_distribution<Volume> volume(1, 20);
+    vector<Order> placed;
+
+    for (int step = 0; step < 3'000; step++) {
+        int roll = action(generator);
+        Side side = roll % 2 == 0 ? BUY : SELL;
+        if (roll < 50) {
+            placed.push_back(createLimitOrder(side, price(generator),
+                                              volume(generator)));
+            book.PlaceOrder(placed.back());
+        } else if (roll < 60) {
+            placed.push_back(createIcebergOrder(side, price(generator),
+                                                3 * volume(generator),
+                                                volume(generator)));
+            book.PlaceOrder(placed.back());
+        } else if (roll < 85 && !placed.empty()) {
+            size_t index = generator() % placed.size();
+            book.CancelOrder(placed[index].getOrderId());
+        } else {
+            book.PlaceOrder(createMarketOrder(side, volume(generator)));
+        }
+
+        map<pair<Side, Price>, vector<QueuePosition>> levels;
+        for (const Order& order : placed) {
+            QueuePosition position;
+            if (book.GetQueuePosition(order.getOrderId(), position)) {
+                levels[{order.getSide(), order.getPrice()}].push_back(
+                    position);
+            }
+        }
+        for (auto& [key, positions] : levels) {
+            ranges::sort(positions, {}, &QueuePosition::orders_ahead);
+            for (size_t i = 0; i < positions.size(); i++) {
+                ASSERT_EQ(positions[i].orders_ahead, i);
+                if (i > 0) {
+                    ASSERT_TRUE(positions[i].volume_ahead >
+                                positions[i - 1].volume_ahead);
+                }
+            }
+            ASSERT_EQ(positions[0].volume_ahead, 0);
+            ASSERT_TRUE(positions.back().volume_ahead <
+                        book.GetDisplayedVolumeAtPrice(key.second, key.first));
+        }
+    }
+}
+
+void TestQueuePositionsFollowQueues() {
+    checkQueuePositionsFollowQueues<OrderBook>();
+    checkQueuePositionsFollowQueues<FifoProRataOrderBook>();
+}
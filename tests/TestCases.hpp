@@ -1,5 +1,8 @@
 #pragma once
+#include "matching_engine/BookFork.hpp"
+#include "matching_engine/ColumnarExport.hpp"
 #include "matching_engine/OrderBook.hpp"
+#include "matching_engine/RiskGate.hpp"
 
 void TestEmptyBook(OrderBook& ob);
 void TestAddSingleBuyLimit(OrderBook& ob);
@@ -28,3 +31,89 @@ void TestMarketOrderPartialFillThenDrop(OrderBook& ob);
 void TestMarketOrderClearsBook(OrderBook& ob);
 void TestInterleavedOps(OrderBook& ob);
 void TestLargeVolumeArithmetic(OrderBook& ob);
+
+void TestAuctionAccumulatesOrders(OrderBook& ob);
+void TestAuctionUncrossMaxVolume(OrderBook& ob);
+void TestAuctionReferencePriceTieBreak(OrderBook& ob);
+void TestAuctionNoCross(OrderBook& ob);
+void TestAuctionRejectsMarketOrders(OrderBook& ob);
+void TestAuctionUncrossMatchesBruteForce();
+
+void TestStopOrderTriggers(OrderBook& ob);
+void TestStopLimitRestsAfterTrigger(OrderBook& ob);
+void TestTriggeredStopKeepsOwnerAndExpiry(OrderBook& ob);
+void TestCancelStopOrder(OrderBook& ob);
+void TestStopCascadeBudget(OrderBook& ob);
+
+void TestIcebergDisplaysPeakOnly(OrderBook& ob);
+void TestIcebergReplenishLosesPriority(OrderBook& ob);
+void TestIcebergAggressorRestsWithPeak(OrderBook& ob);
+void TestCancelIceberg(OrderBook& ob);
+
+void TestStateHashRoundTrip(OrderBook& ob);
+void TestStateHashPathIndependent(OrderBook& ob);
+void TestStateHashCoversTimePriority(OrderBook& ob);
+
+void TestTickSizeRejectsOffTick(OrderBook& ob);
+void TestTickSizeTradesReportPrices(OrderBook& ob);
+void TestTickConverterRoundTrip();
+
+void TestCancelRange(OrderBook& ob);
+void TestCancelWorseThan(OrderBook& ob);
+void TestCancelWorseThanBandEdges(OrderBook& ob);
+
+void TestCompactionReleasesIdleMemory(OrderBook& ob);
+void TestCompactionInterleavedWithOrders(OrderBook& ob);
+
+void TestConflatedSweepReports(OrderBook& ob);
+void TestConflatedReportsMatchPerOrderBook(OrderBook& ob);
+
+void TestGtdOrderExpires(OrderBook& ob);
+void TestDayOrdersExpireAtSessionEnd(OrderBook& ob);
+void TestTimerWheelFiresOnTime();
+
+void TestProRataSplitsByDisplayedSize();
+void TestProRataRoundingGoesToTimePriority();
+void TestFifoProRataSplit();
+void TestProRataSharesExact();
+
+void TestMidpointPegFollowsBbo(OrderBook& ob);
+void TestPrimaryPegTradesBehindDisplayed(OrderBook& ob);
+void TestMidpointPegsCrossOnEvenSpread(OrderBook& ob);
+void TestMidpointPegCrossConflatedReports(OrderBook& ob);
+
+void TestImmediateOrCancelNeverRests(OrderBook& ob);
+void TestFillOrKillAllOrNothing(OrderBook& ob);
+void TestAvailableVolumeAndCostToFill(OrderBook& ob);
+
+void TestRiskRejectsSizeCollarAndUnknown();
+void TestRiskOpenNotionalFollowsOrders();
+void TestRiskPositionCountsOpenOrders();
+void TestRiskRejectsDuplicateOrderId();
+void TestRiskReleasesUntradedStops();
+
+void TestKeepWarmLeavesBookUnchanged(OrderBook& ob);
+
+void TestTradeStatisticsSummary(OrderBook& ob);
+void TestTradeStatisticsBars(OrderBook& ob);
+void TestTradeStatisticsConcurrentReader(OrderBook& ob);
+
+void TestForkSweepLeavesBookUntouched(OrderBook& ob);
+void TestForkRestsAndCancelsLocally(OrderBook& ob);
+void TestForkMatchesLikeTheBook();
+void TestForkTakesOnlyTheOrdersItReaches(OrderBook& ob);
+
+void TestColumnarWriterRoundTrip();
+void TestDepthSnapshot(OrderBook& ob);
+void TestMassQuoteRequoteKeepsPriority(OrderBook& ob);
+void TestMassQuoteRejectsWholeQuote(OrderBook& ob);
+void TestMassQuoteCrossingLegTrades(OrderBook& ob);
+void TestRingDequeMatchesDeque();
+void TestContainerVariantsMatchDefault();
+void TestTopOfBookSlotFollowsBook(OrderBook& ob);
+void TestConsolidatedBboAcrossBooks();
+void TestConsolidatedBboConcurrentReader();
+void TestQueuePositionCounts(OrderBook& ob);
+void TestQueuePositionAfterRequoteAndProRata();
+void TestQueuePositionUpdates(OrderBook& ob);
+void TestQueuePositionsFollowQueues();
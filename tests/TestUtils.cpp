@@ -14,3 +14,23 @@ Order createLimitOrder(Side side, Price price, Volume volume) {
 Order createMarketOrder(Side side, Volume volume) {
     return Order(getNextId(), side, MARKET, 0, volume);
 }
+
+Order createStopOrder(Side side, Price trigger_price, Volume volume) {
+    Order order(getNextId(), side, STOP, 0, volume);
+    order.setTriggerPrice(trigger_price);
+    return order;
+}
+
+Order createStopLimitOrder(Side side, Price trigger_price, Price price,
+                           Volume volume) {
+    Order order(getNextId(), side, STOP_LIMIT, price, volume);
+    order.setTriggerPrice(trigger_price);
+    return order;
+}
+
+Order createIcebergOrder(Side side, Price price, Volume volume,
+                         Volume peak_volume) {
+    Order order(getNextId(), side, LIMIT, price, volume);
+    order.setPeakVolume(peak_volume);
+    return order;
+}
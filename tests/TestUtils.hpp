@@ -23,3 +23,8 @@ using namespace std;
 OrderID getNextId();
 Order createLimitOrder(Side side, Price price, Volume volume);
 Order createMarketOrder(Side side, Volume volume);
+Order createStopOrder(Side side, Price trigger_price, Volume volume);
+Order createStopLimitOrder(Side side, Price trigger_price, Price price,
+                           Volume volume);
+Order createIcebergOrder(Side side, Price price, Volume volume,
+                         Volume peak_volume);
@@ -0,0 +1,27 @@
+#include <unistd.h>
+#include <string>
+#include "DropCopyTestCases.hpp"
+#include "TestRunner.hpp"
+
+using namespace std;
+
+int main() {
+    TestRunner runner;
+
+    // Unique file names so parallel test runs do not collide
+    string prefix = "drop_copy_test_" + to_string(getpid()) + "_";
+
+    runner.run("Drop Copy Round Trip",
+               [&prefix]() { TestDropCopyRoundTrip(prefix + "round_trip"); });
+    runner.run("Drop Copy io_uring Batches", [&prefix]() {
+        TestDropCopyIoUringBatches(prefix + "io_uring");
+    });
+    runner.run("Drop Copy Without Sync",
+               [&prefix]() { TestDropCopyWithoutSync(prefix + "no_sync"); });
+    runner.run("Drop Copy Rejects Foreign File", [&prefix]() {
+        TestDropCopyRejectsForeignFile(prefix + "foreign");
+    });
+
+    runner.summary();
+    return runner.getFailed() > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
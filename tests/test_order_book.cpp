@@ -115,6 +115,242 @@ int main() {
         OrderBook ob;
         TestLargeVolumeArithmetic(ob);
     });
+    runner.run("Auction Accumulates Orders", []() {
+        OrderBook ob;
+        TestAuctionAccumulatesOrders(ob);
+    });
+    runner.run("Auction Uncross Max Volume", []() {
+        OrderBook ob;
+        TestAuctionUncrossMaxVolume(ob);
+    });
+    runner.run("Auction Reference Price Tie-Break", []() {
+        OrderBook ob;
+        TestAuctionReferencePriceTieBreak(ob);
+    });
+    runner.run("Auction No Cross", []() {
+        OrderBook ob;
+        TestAuctionNoCross(ob);
+    });
+    runner.run("Auction Rejects Market Orders", []() {
+        OrderBook ob;
+        TestAuctionRejectsMarketOrders(ob);
+    });
+    runner.run("Auction Uncross Matches Brute Force",
+               []() { TestAuctionUncrossMatchesBruteForce(); });
+    runner.run("Stop Order Triggers", []() {
+        OrderBook ob;
+        TestStopOrderTriggers(ob);
+    });
+    runner.run("Stop Limit Rests After Trigger", []() {
+        OrderBook ob;
+        TestStopLimitRestsAfterTrigger(ob);
+    });
+    runner.run("Triggered Stop Keeps Owner And Expiry", []() {
+        OrderBook ob;
+        TestTriggeredStopKeepsOwnerAndExpiry(ob);
+    });
+    runner.run("Cancel Stop Order", []() {
+        OrderBook ob;
+        TestCancelStopOrder(ob);
+    });
+    runner.run("Stop Cascade Budget", []() {
+        OrderBook ob;
+        TestStopCascadeBudget(ob);
+    });
+    runner.run("Iceberg Displays Peak Only", []() {
+        OrderBook ob;
+        TestIcebergDisplaysPeakOnly(ob);
+    });
+    runner.run("Iceberg Replenish Loses Priority", []() {
+        OrderBook ob;
+        TestIcebergReplenishLosesPriority(ob);
+    });
+    runner.run("Iceberg Aggressor Rests With Peak", []() {
+        OrderBook ob;
+        TestIcebergAggressorRestsWithPeak(ob);
+    });
+    runner.run("Cancel Iceberg", []() {
+        OrderBook ob;
+        TestCancelIceberg(ob);
+    });
+    runner.run("State Hash Round Trip", []() {
+        OrderBook ob;
+        TestStateHashRoundTrip(ob);
+    });
+    runner.run("State Hash Path Independent", []() {
+        OrderBook ob;
+        TestStateHashPathIndependent(ob);
+    });
+    runner.run("State Hash Covers Time Priority", []() {
+        OrderBook ob;
+        TestStateHashCoversTimePriority(ob);
+    });
+    runner.run("Tick Size Rejects Off-Tick", []() {
+        OrderBook ob(InstrumentConfig{
+            .tick_size = 5, .min_price = 100, .max_price = 1000});
+        TestTickSizeRejectsOffTick(ob);
+    });
+    runner.run("Tick Size Trades Report Prices", []() {
+        OrderBook ob(InstrumentConfig{
+            .tick_size = 5, .min_price = 100, .max_price = 1000});
+        TestTickSizeTradesReportPrices(ob);
+    });
+    runner.run("Tick Converter Round Trip",
+               []() { TestTickConverterRoundTrip(); });
+    runner.run("Cancel Range", []() {
+        OrderBook ob;
+        TestCancelRange(ob);
+    });
+    runner.run("Cancel Worse Than", []() {
+        OrderBook ob;
+        TestCancelWorseThan(ob);
+    });
+    runner.run("Cancel Worse Than At Band Edges", []() {
+        OrderBook ob;
+        TestCancelWorseThanBandEdges(ob);
+    });
+    runner.run("Compaction Releases Idle Memory", []() {
+        OrderBook ob;
+        TestCompactionReleasesIdleMemory(ob);
+    });
+    runner.run("Compaction Interleaved With Orders", []() {
+        OrderBook ob;
+        TestCompactionInterleavedWithOrders(ob);
+    });
+    runner.run("Conflated Sweep Reports", []() {
+        OrderBook ob;
+        TestConflatedSweepReports(ob);
+    });
+    runner.run("Conflated Reports Match Per Order Book", []() {
+        OrderBook ob;
+        TestConflatedReportsMatchPerOrderBook(ob);
+    });
+    runner.run("GTD Order Expires", []() {
+        OrderBook ob;
+        TestGtdOrderExpires(ob);
+    });
+    runner.run("Day Orders Expire At Session End", []() {
+        OrderBook ob;
+        TestDayOrdersExpireAtSessionEnd(ob);
+    });
+    runner.run("Timer Wheel Fires On Time",
+               []() { TestTimerWheelFiresOnTime(); });
+    runner.run("Pro-Rata Splits By Displayed Size",
+               []() { TestProRataSplitsByDisplayedSize(); });
+    runner.run("Pro-Rata Rounding Goes To Time Priority",
+               []() { TestProRataRoundingGoesToTimePriority(); });
+    runner.run("FIFO Pro-Rata Split", []() { TestFifoProRataSplit(); });
+    runner.run("Pro-Rata Shares Exact", []() { TestProRataSharesExact(); });
+    runner.run("Midpoint Peg Follows BBO", []() {
+        OrderBook ob;
+        TestMidpointPegFollowsBbo(ob);
+    });
+    runner.run("Primary Peg Trades Behind Displayed", []() {
+        OrderBook ob;
+        TestPrimaryPegTradesBehindDisplayed(ob);
+    });
+    runner.run("Midpoint Pegs Cross On Even Spread", []() {
+        OrderBook ob;
+        TestMidpointPegsCrossOnEvenSpread(ob);
+    });
+    runner.run("Midpoint Peg Cross Conflated Reports", []() {
+        OrderBook ob;
+        TestMidpointPegCrossConflatedReports(ob);
+    });
+    runner.run("IOC Never Rests", []() {
+        OrderBook ob;
+        TestImmediateOrCancelNeverRests(ob);
+    });
+    runner.run("FOK All Or Nothing", []() {
+        OrderBook ob;
+        TestFillOrKillAllOrNothing(ob);
+    });
+    runner.run("Available Volume And Cost To Fill", []() {
+        OrderBook ob;
+        TestAvailableVolumeAndCostToFill(ob);
+    });
+    runner.run("Risk Size, Collar And Unknown Participant",
+               []() { TestRiskRejectsSizeCollarAndUnknown(); });
+    runner.run("Risk Open Notional Follows Orders",
+               []() { TestRiskOpenNotionalFollowsOrders(); });
+    runner.run("Risk Position Counts Open Orders",
+               []() { TestRiskPositionCountsOpenOrders(); });
+    runner.run("Risk Rejects Duplicate Order ID",
+               []() { TestRiskRejectsDuplicateOrderId(); });
+    runner.run("Risk Releases Untraded Stops",
+               []() { TestRiskReleasesUntradedStops(); });
+    runner.run("Keep Warm Leaves Book Unchanged", []() {
+        OrderBook ob;
+        TestKeepWarmLeavesBookUnchanged(ob);
+    });
+    runner.run("Trade Statistics Summary", []() {
+        OrderBook ob;
+        TestTradeStatisticsSummary(ob);
+    });
+    runner.run("Trade Statistics Bars", []() {
+        OrderBook ob;
+        TestTradeStatisticsBars(ob);
+    });
+    runner.run("Trade Statistics Concurrent Reader", []() {
+        OrderBook ob;
+        TestTradeStatisticsConcurrentReader(ob);
+    });
+    runner.run("Fork Sweep Leaves Book Untouched", []() {
+        OrderBook ob;
+        TestForkSweepLeavesBookUntouched(ob);
+    });
+    runner.run("Fork Rests And Cancels Locally", []() {
+        OrderBook ob;
+        TestForkRestsAndCancelsLocally(ob);
+    });
+    runner.run("Fork Matches Like The Book",
+               []() { TestForkMatchesLikeTheBook(); });
+    runner.run("Fork Takes Only The Orders It Reaches", []() {
+        OrderBook ob;
+        TestForkTakesOnlyTheOrdersItReaches(ob);
+    });
+    runner.run("Columnar Writer Round Trip",
+               []() { TestColumnarWriterRoundTrip(); });
+    runner.run("Depth Snapshot", []() {
+        OrderBook ob;
+        TestDepthSnapshot(ob);
+    });
+    runner.run("Mass Quote Requote Keeps Priority", []() {
+        OrderBook ob;
+        TestMassQuoteRequoteKeepsPriority(ob);
+    });
+    runner.run("Mass Quote Rejects Whole Quote", []() {
+        OrderBook ob;
+        TestMassQuoteRejectsWholeQuote(ob);
+    });
+    runner.run("Mass Quote Crossing Leg Trades", []() {
+        OrderBook ob;
+        TestMassQuoteCrossingLegTrades(ob);
+    });
+    runner.run("Ring Deque Matches Deque",
+               []() { TestRingDequeMatchesDeque(); });
+    runner.run("Container Variants Match Default",
+               []() { TestContainerVariantsMatchDefault(); });
+    runner.run("Top Of Book Slot Follows Book", []() {
+        OrderBook ob;
+        TestTopOfBookSlotFollowsBook(ob);
+    });
+    runner.run("Consolidated BBO Across Books",
+               []() { TestConsolidatedBboAcrossBooks(); });
+    runner.run("Consolidated BBO Concurrent Reader",
+               []() { TestConsolidatedBboConcurrentReader(); });
+    runner.run("Queue Position Counts", []() {
+        OrderBook ob;
+        TestQueuePositionCounts(ob);
+    });
+    runner.run("Queue Position Updates", []() {
+        OrderBook ob;
+        TestQueuePositionUpdates(ob);
+    });
+    runner.run("Queue Position After Requote And Pro-Rata",
+               []() { TestQueuePositionAfterRequoteAndProRata(); });
+    runner.run("Queue Positions Follow Queues",
+               []() { TestQueuePositionsFollowQueues(); });
 
     runner.summary();
     return runner.getFailed() > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
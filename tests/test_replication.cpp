@@ -0,0 +1,44 @@
+#include <unistd.h>
+#include <string>
+#include "ReplicationTestCases.hpp"
+#include "TestRunner.hpp"
+
+using namespace std;
+
+int main() {
+    TestRunner runner;
+
+    // Unique shared memory names so parallel test runs do not collide
+    string prefix = "/order_book_test_" + to_string(getpid()) + "_";
+
+    runner.run("Replication Lockstep", [&prefix]() {
+        TestReplicationLockstep(prefix + "lockstep");
+    });
+    runner.run("Replication Carries Instrument Config", [&prefix]() {
+        TestReplicationCarriesInstrumentConfig(prefix + "config");
+    });
+    runner.run("Replication Range Cancels", [&prefix]() {
+        TestReplicationRangeCancels(prefix + "range");
+    });
+    runner.run("Replication Mass Quotes", [&prefix]() {
+        TestReplicationMassQuotes(prefix + "quotes");
+    });
+    runner.run("Replication Lag Reporting", [&prefix]() {
+        TestReplicationLagReporting(prefix + "lag");
+    });
+    runner.run("Replication Planned Handover", [&prefix]() {
+        TestReplicationPlannedHandover(prefix + "handover");
+    });
+    runner.run("Replication Forced Promotion", [&prefix]() {
+        TestReplicationForcedPromotion(prefix + "promotion");
+    });
+    runner.run("Replication Promotion During Flow", [&prefix]() {
+        TestReplicationPromotionDuringFlow(prefix + "flow");
+    });
+    runner.run("Replication Detaches Stalled Standby", [&prefix]() {
+        TestReplicationDetachesStalledStandby(prefix + "stalled");
+    });
+
+    runner.summary();
+    return runner.getFailed() > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}